@@ -0,0 +1,250 @@
+//============================================================================
+// Name        : Merge.cpp
+// Author      : Rian van Gijlswijk
+// Description : Command which merges the outputs of the shards of a
+//				 simulation into one file, in ray order
+//============================================================================
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <set>
+#include <boost/log/trivial.hpp>
+#include "Merge.h"
+#include "../core/Config.h"
+#include "../exporter/BinaryExporter.h"
+#include "../exporter/DataWriter.h"
+
+namespace raytracer {
+namespace commands {
+
+	using namespace raytracer::core;
+	using namespace raytracer::exporter;
+
+	namespace {
+
+		bool byRayNumber(const Data &a, const Data &b) {
+
+			return a.rayNumber < b.rayNumber;
+		}
+
+		/**
+		 * Position in a sorted run, which is read in blocks
+		 */
+		struct Cursor {
+			Cursor(const std::string &filepath, size_t blockSize)
+				: reader(filepath.c_str()), block(blockSize) {
+				count = reader.read(block.data(), block.size());
+			}
+
+			/**
+			 * Move to the next record, return false at the end of the run
+			 */
+			bool next() {
+				position++;
+				if (position >= count) {
+					count = reader.read(block.data(), block.size());
+					position = 0;
+				}
+				return position < count;
+			}
+
+			const Data& current() const {
+				return block[position];
+			}
+
+			BinaryReader reader;
+			std::vector<Data> block;
+			size_t position = 0;
+			size_t count = 0;
+		};
+	}
+
+	constexpr size_t Merge::MAX_FAN_IN;
+
+	Merge::Merge(std::vector<std::string> inputs, const char *filepath,
+			IExporter *exporter, size_t memoryBudget)
+			: _inputs(inputs), _filepath(filepath), _exporter(exporter), _memoryBudget(memoryBudget) {
+
+	}
+
+	/**
+	 * Every shard of one simulation has to be given once, with the manifest
+	 * it writes when its output is complete
+	 */
+	void Merge::start() {
+
+		BOOST_LOG_TRIVIAL(info) << "Starting \"Merge\" program";
+
+		if (_inputs.empty()) {
+			BOOST_LOG_TRIVIAL(fatal) << "No shard outputs given! Exiting.";
+			std::exit(1);
+		}
+
+		int numShards = 0;
+		std::set<int> shards;
+		for (const std::string &input : _inputs) {
+			if (!BinaryReader(input.c_str()).isOpen()) {
+				BOOST_LOG_TRIVIAL(fatal) << input << " is not a binary output of the simulation! Exiting.";
+				std::exit(1);
+			}
+
+			// a shard writes its manifest once its output is complete
+			std::string manifestPath = getManifestPath(input);
+			if (!std::ifstream(manifestPath.c_str()).good()) {
+				BOOST_LOG_TRIVIAL(fatal) << "No manifest found for " << input << ", the shard has not finished! Exiting.";
+				std::exit(1);
+			}
+
+			Config manifest(manifestPath.c_str());
+			if (numShards > 0 && manifest.getInt("shards") != numShards) {
+				BOOST_LOG_TRIVIAL(fatal) << input << " is a shard of another simulation! Exiting.";
+				std::exit(1);
+			}
+			numShards = manifest.getInt("shards");
+			if (!shards.insert(manifest.getInt("shard")).second) {
+				BOOST_LOG_TRIVIAL(fatal) << "Shard " << manifest.getInt("shard") << " is given more than once! Exiting.";
+				std::exit(1);
+			}
+		}
+
+		for (int shard = 0; shard < numShards; shard++) {
+			if (shards.count(shard) == 0) {
+				BOOST_LOG_TRIVIAL(fatal) << "Shard " << shard << " of " << numShards << " is missing! Exiting.";
+				std::exit(1);
+			}
+		}
+	}
+
+	void Merge::run() {
+
+		for (const std::string &input : _inputs) {
+			sortRuns(input);
+		}
+		mergeRuns();
+	}
+
+	void Merge::stop() {
+
+		for (const std::string &run : _runs) {
+			std::remove(run.c_str());
+		}
+		_runs.clear();
+
+		BOOST_LOG_TRIVIAL(warning) << "Results stored at: " << _filepath;
+	}
+
+	std::string Merge::getManifestPath(const std::string &output) {
+
+		return output + ".manifest.json";
+	}
+
+	/**
+	 * Sort the records of an input by ray number, in runs which fill the
+	 * memory budget. The records of a ray keep their order.
+	 */
+	void Merge::sortRuns(const std::string &input) {
+
+		size_t runSize = std::max((size_t)1, _memoryBudget / sizeof(Data));
+		std::vector<Data> records(runSize);
+		BinaryReader reader(input.c_str());
+
+		size_t count;
+		while ((count = reader.read(records.data(), runSize)) > 0) {
+			std::stable_sort(records.begin(), records.begin() + count, byRayNumber);
+
+			std::string run = createRunPath();
+			BinaryExporter runExporter;
+			runExporter.open(run.c_str());
+			runExporter.write(records.data(), count);
+			runExporter.close();
+			_runs.push_back(run);
+		}
+
+		BOOST_LOG_TRIVIAL(info) << "Sorted " << input << ", " << _runs.size() << " runs so far";
+	}
+
+	/**
+	 * Consecutive runs are merged into one run, until few enough runs are
+	 * left to merge them into the output. Merging consecutive runs keeps
+	 * the earlier parts of a ray in the earlier runs.
+	 */
+	void Merge::mergeRuns() {
+
+		while (_runs.size() > MAX_FAN_IN) {
+			std::vector<std::string> merged;
+			for (size_t first = 0; first < _runs.size(); first += MAX_FAN_IN) {
+				std::vector<std::string> runs(_runs.begin() + first,
+						_runs.begin() + std::min(_runs.size(), first + MAX_FAN_IN));
+				if (runs.size() == 1) {
+					merged.push_back(runs.front());
+					continue;
+				}
+
+				std::string run = createRunPath();
+				BinaryExporter runExporter;
+				mergeRuns(runs, &runExporter, run.c_str());
+				for (const std::string &r : runs) {
+					std::remove(r.c_str());
+				}
+				merged.push_back(run);
+			}
+
+			BOOST_LOG_TRIVIAL(info) << "Merged " << _runs.size() << " runs into " << merged.size();
+			_runs = merged;
+		}
+
+		mergeRuns(_runs, _exporter, _filepath);
+	}
+
+	/**
+	 * Repeatedly take the record with the lowest ray number from the runs.
+	 * Records of the same ray are taken from the earliest run first, which
+	 * holds the earlier part of the ray.
+	 */
+	void Merge::mergeRuns(const std::vector<std::string> &runs, IExporter *exporter, const char *filepath) {
+
+		size_t blockSize = _memoryBudget / sizeof(Data) / (runs.size() + 1);
+		blockSize = std::max((size_t)1, std::min(DataWriter::BUFFER_SIZE, blockSize));
+
+		typedef std::pair<int, size_t> Key;	// ray number, run
+		std::priority_queue<Key, std::vector<Key>, std::greater<Key> > heads;
+		std::vector<std::unique_ptr<Cursor> > cursors;
+		for (size_t r = 0; r < runs.size(); r++) {
+			cursors.push_back(std::unique_ptr<Cursor>(new Cursor(runs[r], blockSize)));
+			if (cursors[r]->count > 0) {
+				heads.push(Key(cursors[r]->current().rayNumber, r));
+			}
+		}
+
+		std::vector<Data> batch;
+		batch.reserve(blockSize);
+		exporter->open(filepath);
+		while (!heads.empty()) {
+			size_t r = heads.top().second;
+			heads.pop();
+
+			batch.push_back(cursors[r]->current());
+			if (batch.size() == blockSize) {
+				exporter->write(batch.data(), batch.size());
+				batch.clear();
+			}
+
+			if (cursors[r]->next()) {
+				heads.push(Key(cursors[r]->current().rayNumber, r));
+			}
+		}
+		exporter->write(batch.data(), batch.size());
+		exporter->close();
+	}
+
+	std::string Merge::createRunPath() {
+
+		return std::string(_filepath) + ".run" + std::to_string(_numRuns++);
+	}
+
+} /* namespace commands */
+} /* namespace raytracer */
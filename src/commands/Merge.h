@@ -0,0 +1,72 @@
+//============================================================================
+// Name        : Merge.h
+// Author      : Rian van Gijlswijk
+// Description : Command which merges the binary outputs of the shards of a
+//				 simulation into one file, in ray order. The records are
+//				 sorted in runs which fit in memory, after which the runs
+//				 are merged, so the outputs can be larger than memory.
+//============================================================================
+
+#ifndef CORE_COMMANDS_MERGE_H_
+#define CORE_COMMANDS_MERGE_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "BaseCommand.h"
+#include "../exporter/IExporter.h"
+
+namespace raytracer {
+namespace commands {
+
+	class Merge : public BaseCommand {
+
+		public:
+			/**
+			 * Merge the inputs, written by the BinaryExporter, to filepath
+			 * with the exporter. memoryBudget is the number of bytes of
+			 * records held in memory at once.
+			 */
+			Merge(std::vector<std::string> inputs, const char *filepath,
+					exporter::IExporter *exporter, size_t memoryBudget);
+
+			/**
+			 * Check the inputs, and the manifests of the shards
+			 */
+			void start();
+			void run();
+
+			/**
+			 * Remove the sorted runs
+			 */
+			void stop();
+
+			/**
+			 * Path of the manifest which a shard writes next to its output
+			 */
+			static std::string getManifestPath(const std::string &output);
+
+			/**
+			 * Runs merged at once. Every run is an open file, so more runs
+			 * are merged in passes.
+			 */
+			static constexpr size_t MAX_FAN_IN = 64;
+
+		private:
+			void sortRuns(const std::string &input);
+			void mergeRuns();
+			void mergeRuns(const std::vector<std::string> &runs, exporter::IExporter *exporter, const char *filepath);
+			std::string createRunPath();
+
+			std::vector<std::string> _inputs;
+			const char *_filepath;
+			exporter::IExporter *_exporter;
+			size_t _memoryBudget;
+			std::vector<std::string> _runs;
+			size_t _numRuns = 0;
+	};
+
+} /* namespace commands */
+} /* namespace raytracer */
+
+#endif /* CORE_COMMANDS_MERGE_H_ */
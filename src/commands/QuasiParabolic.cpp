@@ -0,0 +1,135 @@
+//============================================================================
+// Name        : QuasiParabolic.cpp
+// Author      : Rian van Gijlswijk
+// Description : Command which sweeps the launch configurations of the
+//				 application config through a quasi-parabolic fit of the
+//				 ionosphere
+//============================================================================
+
+#include <cmath>
+#include <memory>
+#include <boost/log/trivial.hpp>
+#include "QuasiParabolic.h"
+#include "../core/Application.h"
+#include "../core/LaunchGrid.h"
+#include "../core/Timer.cpp"
+#include "../tracer/QuasiParabolicTracer.h"
+#include "../math/Matrix3d.h"
+#include "../math/Constants.h"
+
+namespace raytracer {
+namespace commands {
+
+	using namespace raytracer::core;
+	using namespace raytracer::tracer;
+	using namespace raytracer::exporter;
+	using namespace raytracer::scene;
+	using namespace raytracer::math;
+
+	QuasiParabolic::QuasiParabolic(int fmin, int fstep, int fmax) : _fmin(fmin), _fstep(fstep), _fmax(fmax) {
+
+	}
+
+	void QuasiParabolic::start() {
+
+		BOOST_LOG_TRIVIAL(info) << "Starting \"QuasiParabolic\" program";
+	}
+
+	/**
+	 * Every launch configuration results in a record at the apogee and a
+	 * record where the ray lands, or leaves the scene. The records have the
+	 * same fields as those of Application::run(), without signal losses.
+	 */
+	void QuasiParabolic::run() {
+
+		Timer tmr;
+		Application &app = Application::getInstance();
+		const SimulationContext &context = app.getSimulationContext();
+		Config applicationConfig = app.getApplicationConfig();
+		app.openDataset();
+
+		const Json::Value beacons = applicationConfig.getArray("beacons");
+		double R = context.radius;
+		double plasmaFrequencyFactor = pow(Constants::ELEMENTARY_CHARGE, 2)
+				/ (Constants::ELECTRON_MASS * Constants::PERMITTIVITY_VACUUM);
+
+		// the rays are numbered as by the simulation command
+		LaunchGrid launchGrid(applicationConfig, R, _fmin, _fstep, _fmax);
+		std::unique_ptr<QuasiParabolicTracer> tracer;
+		int beaconId = 0;
+		double beaconAltitude = 0;
+		Vector3d up;
+
+		for (size_t index = 0; index < launchGrid.size(); index++) {
+
+			// the rays of a beacon are consecutive in the grid
+			Ray ray = launchGrid.rayAt(index);
+			if (ray.originBeaconId != beaconId) {
+				beaconId = ray.originBeaconId;
+				beaconAltitude = beacons[(Json::ArrayIndex)(beaconId - 1)].get("altitude", "").asDouble();
+				up = ray.o.norm();
+
+				// the ionosphere above the beacon is assumed for the whole path
+				tracer.reset(new QuasiParabolicTracer(context, up.angle(Vector3d::SUBSOLAR), beaconAltitude + 2));
+				BOOST_LOG_TRIVIAL(info) << "Beacon " << beaconId << ": fitted " << tracer->getSegments().size()
+						<< " segments, max error " << tracer->getMaxError();
+			}
+
+			Matrix3d azimuthRotation = Matrix3d::createRotationMatrix(ray.originalAzimuth, Matrix3d::ROTATION_Y);
+			Vector3d horizontal = azimuthRotation * Vector3d(1, 0, 0);
+			horizontal = (horizontal - up * (horizontal * up)).norm();
+
+			double zenithAngle = ray.originalAngle;
+			QuasiParabolicTracer::Path path = tracer->trace(zenithAngle, ray.frequency);
+
+			Data d;
+			d.rayNumber = ray.rayNumber;
+			d.theta_0 = zenithAngle;
+			d.azimuth_0 = ray.originalAzimuth;
+			d.frequency = ray.frequency;
+			d.signalPower = ray.signalPower;
+			d.beaconId = ray.originBeaconId;
+
+			if (path.reflected) {
+				double apogeeRadius = R + path.apogee;
+				Vector3d apogee = up * (apogeeRadius * cos(path.apogeeRange / R))
+						+ horizontal * (apogeeRadius * sin(path.apogeeRange / R));
+				Data top = d;
+				top.x = apogee.x;
+				top.y = apogee.y;
+				top.z = apogee.z;
+				top.n_e = tracer->getElectronNumberDensity(path.apogee);
+				top.omega_p = sqrt(plasmaFrequencyFactor * top.n_e);
+				top.mu_r_sqrt = pow((R + beaconAltitude + 2) * sin(zenithAngle) / apogeeRadius, 2);
+				top.timeOfFlight = path.apogeeGroupPath / Constants::C;
+				top.collisionType = GeometryType::ionosphere;
+				app.addToDataset(top);
+			}
+
+			double endRadius = path.reflected ? R : context.sceneBoundary;
+			Vector3d end = up * (endRadius * cos(path.groundRange / R))
+					+ horizontal * (endRadius * sin(path.groundRange / R));
+			d.x = end.x;
+			d.y = end.y;
+			d.z = end.z;
+			d.mu_r_sqrt = 1;
+			d.timeOfFlight = path.timeOfFlight;
+			d.collisionType = path.reflected ? GeometryType::terrain : GeometryType::none;
+			d.aoa = path.reflected ? Constants::PI - path.arrivalAngle : path.arrivalAngle;
+			app.addToDataset(d);
+			_numRays++;
+		}
+
+		double t = tmr.elapsed();
+		char buffer[80];
+		sprintf(buffer, "Elapsed: %5.2f sec. %d rays traced. %5.2f rays/sec", t, _numRays, _numRays / t);
+		BOOST_LOG_TRIVIAL(warning) << buffer;
+	}
+
+	void QuasiParabolic::stop() {
+
+		Application::getInstance().exportDataset();
+	}
+
+} /* namespace commands */
+} /* namespace raytracer */
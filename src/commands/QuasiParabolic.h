@@ -0,0 +1,39 @@
+//============================================================================
+// Name        : QuasiParabolic.h
+// Author      : Rian van Gijlswijk
+// Description : Command which sweeps the beacons, azimuths, frequencies and
+//				 elevations of the application config through a quasi-
+//				 parabolic fit of the ionosphere, instead of tracing rays
+//				 step by step. Meant for fast what-if studies.
+//============================================================================
+
+#ifndef CORE_COMMANDS_QUASIPARABOLIC_H_
+#define CORE_COMMANDS_QUASIPARABOLIC_H_
+
+#include "BaseCommand.h"
+
+namespace raytracer {
+namespace commands {
+
+	class QuasiParabolic : public BaseCommand {
+
+		public:
+			/**
+			 * Sweep the frequencies fmin to fmax in steps of fstep [Hz]. The
+			 * application must have been started, so that its configuration
+			 * and exporter are loaded.
+			 */
+			QuasiParabolic(int fmin, int fstep, int fmax);
+			void start();
+			void run();
+			void stop();
+
+		private:
+			int _fmin, _fstep, _fmax;
+			int _numRays = 0;
+	};
+
+} /* namespace commands */
+} /* namespace raytracer */
+
+#endif /* CORE_COMMANDS_QUASIPARABOLIC_H_ */
@@ -7,20 +7,31 @@
 #include "Application.h"
 #include <string>
 #include <regex>
+#include <fstream>
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/utility/setup/file.hpp>
 #include "Timer.cpp"
 #include "CommandLine.h"
+#include "LaunchGrid.h"
+#include "TracingStatistics.h"
 #include "../math/Matrix3d.h"
+#include "../tracer/PacketTracer.h"
+#include "../exporter/BinaryExporter.h"
 #include "../exporter/CsvExporter.h"
 #include "../exporter/JsonExporter.h"
 #include "../exporter/MatlabExporter.h"
 #include "../exporter/VtkExporter.h"
-#include "../radio/AntennaFactory.h"
-#include "../radio/IsotropicAntenna.h"
 #include "../commands/Wavetypes.h"
+#include "../commands/QuasiParabolic.h"
+#include "../commands/Merge.h"
+#include "../../contrib/jsoncpp/writer.h"
 
 namespace raytracer {
 namespace core {
@@ -34,9 +45,45 @@ namespace core {
 	using namespace radio;
 
 	boost::mutex datasetMutex;
-	boost::mutex tracingIncMutex;
 
-	boost::threadpool::pool tp;
+	namespace {
+
+		// records of the rays being traced by the calling thread, which are
+		// added to the dataset once the rays are finished
+		thread_local std::vector<Data> *tracedRecords = nullptr;
+
+		/**
+		 * Whether the command line option is followed by a value
+		 */
+		bool optionHasValue(const char *option) {
+
+			const char *options[] = {"-s", "--scenario", "-c", "--config", "-p", "--parallelism",
+					"-o", "--output", "-i", "--iterations", "-fmin", "-fstep", "-fmax", "--shard"};
+			for (const char *o : options) {
+				if (strcmp(option, o) == 0) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * The first SIGINT or SIGTERM stops the simulation after writing the
+		 * results, a second one ends the program right away
+		 */
+		void onSignal(int signal) {
+
+			std::signal(SIGINT, SIG_DFL);
+			std::signal(SIGTERM, SIG_DFL);
+			Application::getInstance().interrupt();
+		}
+
+		uint64_t getFileSize(const char *filepath) {
+
+			std::ifstream file(filepath, std::ifstream::binary | std::ifstream::ate);
+			return file.good() ? (uint64_t)file.tellg() : 0;
+		}
+	}
 
 	void Application::init(int argc, char * argv[]) {
 
@@ -92,6 +139,19 @@ namespace core {
 
 			} else if (strcmp(argv[i], "-fmax") == 0) {
 				_fmax = atoi(argv[i+1]);
+
+			} else if (strcmp(argv[i], "--shard") == 0) {
+				if (i+1 >= argc || sscanf(argv[i+1], "%d/%d", &_shard, &_numShards) != 2
+						|| _numShards < 1 || _shard < 0 || _shard >= _numShards) {
+					BOOST_LOG_TRIVIAL(fatal) << "Shards are given as i/N, with 0 <= i < N";
+					std::exit(1);
+				}
+
+			} else if (strcmp(argv[i], "--resume") == 0) {
+				_resume = true;
+
+			} else if (strcmp(argv[i], "--no-cache") == 0) {
+				_noCache = true;
 			}
 		}
 
@@ -101,7 +161,7 @@ namespace core {
 		if (commandArgument.substr(0, 1) == "-") {
 			BOOST_LOG_TRIVIAL(fatal) << "No command supplied! Usage:";
 			usage();
-		} else if (commandArgument.compare("simulation") == 0) {
+		} else if (commandArgument.compare("simulation") == 0 || commandArgument.compare("quasiparabolic") == 0) {
 
 			// load scenario config file. Must be given.
 			if (!std::regex_match (argv[argc-1], std::regex("[A-Za-z0-9_/]+\.json") )) {
@@ -111,7 +171,35 @@ namespace core {
 			_celestialConfigFile = argv[argc-1];
 
 			start();
-			run();
+			if (commandArgument.compare("simulation") == 0) {
+				run();
+			} else {
+				QuasiParabolic cmd(_fmin, _fstep, _fmax);
+				cmd.start();
+				cmd.run();
+				cmd.stop();
+			}
+		} else if (commandArgument.compare("merge") == 0) {
+
+			// the files to merge are all arguments which are not an option
+			std::vector<std::string> inputs;
+			for (int i = 2; i < argc; i++) {
+				if (argv[i][0] == '-') {
+					i += optionHasValue(argv[i]) ? 1 : 0;
+				} else {
+					inputs.push_back(argv[i]);
+				}
+			}
+
+			_applicationConfig = Config(_applicationConfigFile);
+			createSimulationContext();
+			boost::log::core::get()->set_filter(boost::log::trivial::severity >= _verbosity);
+			configureExporter();
+
+			Merge cmd(inputs, _outputFile, _exporter, _context.outputMemoryBudget);
+			cmd.start();
+			cmd.run();
+			cmd.stop();
 		} else if (commandArgument.compare("wavetypes") == 0) {
 			Wavetypes cmd;
 			cmd.start();
@@ -127,13 +215,21 @@ namespace core {
 					<< "Description: \n"
 					<< "\tPerform ionospheric ray tracing on a celestial object described by the _celestialConfig json file. "
 					<< "If no config file is supplied, use a default scenario.\n\n"
+					<< "Commands:\n"
+					<< "\tsimulation\t Trace rays through the scenario with the configured engine.\n"
+					<< "\tquasiparabolic\t Compute the ray paths in closed form through a quasi-parabolic fit of the ionosphere.\n"
+					<< "\tmerge\t\t Merge the .bin outputs of all shards, given instead of the scenario, into one file in ray order. Every shard needs its manifest.\n"
+					<< "\twavetypes\t Compare O- and X-waves in a test scenario.\n\n"
 					<< "Options:\n"
 					<< "\t-c | --config\t Application config file\n"
 					<< "\t-i | --iterations\t The number of consecutive times every ray option should be run.\n"
 					<< "\t-h | --help\t This help.\n"
 					<< "\t-m | --magneticfield\t Include magnetic field effects.\n"
+					<< "\t--no-cache\t Trace every ray, without using or filling the ray cache.\n"
 					<< "\t-o | --output\t Path where output file should be stored.\n"
 					<< "\t-p | --parallelism\t Multithreading indicator.\n"
+					<< "\t--resume\t Continue an interrupted simulation from the checkpoint next to its output, and append to the output.\n"
+					<< "\t--shard i/N\t Only trace part i of N of the rays, 0 <= i < N, and write a manifest next to the output.\n"
 					<< "\t-v | --verbose\t Verbose, display log output\n"
 					<< "\t-vv \t\t Very verbose, display log and debug output\n";
 		std::exit(0);
@@ -147,6 +243,7 @@ namespace core {
 
 		_applicationConfig = Config(_applicationConfigFile);
 		_celestialConfig = Config(_celestialConfigFile);
+		createSimulationContext();
 
 		if (_parallelism < 1) {
 			_parallelism = _applicationConfig.getInt("parallelism");
@@ -169,13 +266,17 @@ namespace core {
 		boost::log::core::get()->set_filter(
 				boost::log::trivial::severity >= _verbosity);
 
-		tp = boost::threadpool::pool(_parallelism);
+		_scheduler.reset(new Scheduler(_parallelism));
 
 		BOOST_LOG_TRIVIAL(debug) << "applicationConfig: " << _applicationConfigFile << "\n"
 				<< _applicationConfig << "\n"
 				<< "celestialConfig:" << _celestialConfigFile << "\n"
 				<< _celestialConfig;
 
+		if (_context.useIonosphereTable) {
+			_ionosphereTable.build(_context, _context.ionosphereTableMaxError);
+		}
+
 		configureExporter();
 	}
 
@@ -183,7 +284,29 @@ namespace core {
 
 		BOOST_LOG_TRIVIAL(debug) << "Run application";
 
+		// the Haselgrove engines trace an unmagnetized ionosphere above a
+		// spherical surface, whatever the configuration asks for
+		if (_context.engine == SimulationContext::engine_haselgrove
+				|| _context.engine == SimulationContext::engine_linear_layers) {
+			std::string engine = _applicationConfig.getValue("engine").asString();
+			if (_context.includeMagneticField || !_context.magneticFields.empty()) {
+				BOOST_LOG_TRIVIAL(warning) << "The " << engine << " engine ignores magnetic fields, "
+						<< "the rays are traced without them";
+			}
+			if (_context.terrain == SimulationContext::terrain_patches) {
+				BOOST_LOG_TRIVIAL(warning) << "The " << engine << " engine does not support the patches terrain model, "
+						<< "the terrain is traced as a sphere";
+			}
+		}
+
+		// packets are only traced together on the interpolated ionosphere
+		if (_context.engine == SimulationContext::engine_packet && !_context.useIonosphereTable) {
+			BOOST_LOG_TRIVIAL(warning) << "The packet engine needs the ionosphere table to trace rays together, "
+					<< "enable ionosphereTable in the configuration";
+		}
+
 		Timer tmr;
+		TracingStatistics::reset();
 		int radius = _celestialConfig.getInt("radius");
 
 		BOOST_LOG_TRIVIAL(info) << "Parallelism is " << _applicationConfig.getInt("parallelism");
@@ -201,76 +324,69 @@ namespace core {
 		double azimuthMin = _applicationConfig.getObject("azimuth")["min"].asDouble();
 		double azimuthStep = _applicationConfig.getObject("azimuth")["step"].asDouble();
 		double azimuthMax = _applicationConfig.getObject("azimuth")["max"].asDouble();
-		const Json::Value beacons = _applicationConfig.getArray("beacons");
+		LaunchGrid launchGrid(_applicationConfig, radius, _fmin, _fstep, _fmax);
+
+		// a shard traces a contiguous part of the launch grid, the rays keep
+		// the numbers they have in the complete grid
+		size_t firstIndex = launchGrid.size() * _shard / _numShards;
+		size_t numRays = launchGrid.size() * (_shard + 1) / _numShards - firstIndex;
+		if (_numShards > 1) {
+			BOOST_LOG_TRIVIAL(info) << "Shard " << _shard << " of " << _numShards << ": rays "
+					<< (firstIndex + 1) << " to " << (firstIndex + numRays) << " of " << launchGrid.size();
+		}
+
+		Checkpoint checkpoint;
+		checkpoint.nextIndex = firstIndex;
+		checkpoint.raysPerIteration = launchGrid.size();
+		checkpoint.shard = _shard;
+		checkpoint.numShards = _numShards;
+		if (_resume) {
+			resumeFromCheckpoint(checkpoint);
+		}
+		openDataset();
+		if (_context.useRayCache && !_noCache) {
+			_rayCache.reset(new RayCache(_context.rayCacheDirectory, getPhysicsKey(),
+					_context.rayCacheMaxSize, _context.rayCacheEviction));
+		}
+		std::signal(SIGINT, onSignal);
+		std::signal(SIGTERM, onSignal);
+
+		// the rays of an iteration are traced in segments, after each of
+		// which a checkpoint is written. Segments are sized to take about the
+		// checkpoint interval, and hold whole packets. Outputs which can not
+		// be continued are not checkpointed.
+		double checkpointInterval = _context.checkpointInterval;
+		if (checkpointInterval > 0 && !_exporter->canResume()) {
+			BOOST_LOG_TRIVIAL(info) << "Not writing checkpoints, " << _outputFile << " can not be resumed";
+			checkpointInterval = 0;
+		}
+		const size_t packetSize = PacketTracer::PACKET_SIZE;
+		size_t segmentSize = _scheduler->getNumThreads() * Scheduler::MAX_CHUNK_SIZE * packetSize;
 
 		// trace a ray
-		int rayCounter = 0;
-		for (int iteration = 0; iteration < _applicationConfig.getInt("iterations"); iteration++) {
+		for (int iteration = checkpoint.iteration; iteration < _applicationConfig.getInt("iterations") && !_interrupted; iteration++) {
 
 			BOOST_LOG_TRIVIAL(info) << "Iteration " << (iteration+1) << " of " << _applicationConfig.getInt("iterations");
 
 			createScene();
 
-			BOOST_LOG_TRIVIAL(info) << "Simulating " << beacons.size() << " beacons";
+			BOOST_LOG_TRIVIAL(info) << "Simulating " << launchGrid.getNumBeacons() << " beacons";
 			BOOST_LOG_TRIVIAL(info) << "Scanning frequencies " << _fmin << " Hz to " << _fmax << "Hz with steps of " << _fstep << "Hz";
 			BOOST_LOG_TRIVIAL(info) << "Scanning SZA " << SZAmin << " deg to " << SZAmax << " deg with steps of " << SZAstep << " deg";
 			BOOST_LOG_TRIVIAL(info) << "Scanning azimuth " << azimuthMin << " deg to " << azimuthMax << " deg with steps of " << azimuthStep << " deg";
 
 			if (_verbosity > boost::log::trivial::info) {
 				std::ostringstream stringStream;
-				stringStream << "Simulating " << beacons.size() << " beacons\n" << "Scanning frequencies " << _fmin << " Hz to " << _fmax
+				stringStream << "Simulating " << launchGrid.getNumBeacons() << " beacons\n" << "Scanning frequencies " << _fmin << " Hz to " << _fmax
 						<< "Hz with steps of " << _fstep << "Hz\n" << "Scanning SZA " << SZAmin << " deg to "
 						<< SZAmax << " deg with steps of " << SZAstep << " deg\n"
 						<< "Scanning azimuth " << azimuthMin << " deg to " << azimuthMax << " deg with steps of " << azimuthStep << " deg";
 						CommandLine::getInstance().addToHeader(stringStream.str().c_str());
 			}
 
-			for(int b = 0; b < beacons.size(); b++) {
-
-				double latitudeOffset = beacons[b].get("latitudeOffset", "").asDouble() * Constants::PI / 180.0;
-				double longitudeOffset = beacons[b].get("longitudeOffset", "").asDouble() * Constants::PI / 180.0;
-				double beaconAltitude = beacons[b].get("altitude", "").asDouble();
-				const Json::Value antenna = beacons[b].get("antenna", "");
-//				IAntenna* ant = AntennaFactory::createInstance(antenna.get("type", "").asString());
-				IAntenna* ant = new IsotropicAntenna();
-				ant->setConfig(antenna);
-
-				Matrix3d latitude = Matrix3d::createRotationMatrix(latitudeOffset, Matrix3d::ROTATION_X);
-				Matrix3d longitude = Matrix3d::createRotationMatrix(longitudeOffset, Matrix3d::ROTATION_Z);
-				Matrix3d rotationMatrix = latitude * longitude;
-
-				Vector3d startPosition = rotationMatrix * Vector3d(0, (radius+2+beaconAltitude), 0);
-				BOOST_LOG_TRIVIAL(debug) << startPosition;
-
-				for(double azimuth = azimuthMin; azimuth <= azimuthMax; azimuth += azimuthStep) {
-
-					Matrix3d azimuthRotation = Matrix3d::createRotationMatrix(azimuth * Constants::PI / 180, Matrix3d::ROTATION_Y);
-
-					for (int freq = _fmin; freq <= _fmax; freq += _fstep) {
-						for (double elevation = SZAmin; elevation <= SZAmax; elevation += SZAstep) {
-
-							Ray r;
-							r.rayNumber = ++rayCounter;
-							r.frequency = (double)freq;
-							r.signalPower = ant->getSignalPowerAt(azimuth, elevation);
-							r.o = startPosition;
-							r.originalAngle = elevation * Constants::PI / 180.0;
-							r.originBeaconId = b+1;
-							r.originalAzimuth = azimuth * Constants::PI / 180.0;
-							Vector3d direction = Vector3d(cos(Constants::PI/2.0 - r.originalAngle),
-									sin(Constants::PI/2.0 - r.originalAngle),
-									0).norm();
-							r.d = azimuthRotation * direction;
-
-							Worker w;
-							w.schedule(&tp, r);
-
-							numWorkers++;
-						}
-					}
-				}
-			}
-
+			size_t begin = (checkpoint.iteration == iteration) ? checkpoint.nextIndex : firstIndex;
+			size_t end = firstIndex + numRays;
+			numWorkers += end - begin;
 			BOOST_LOG_TRIVIAL(info) << numWorkers << " workers queued";
 			if (_verbosity > boost::log::trivial::info) {
 				std::ostringstream stringStream;
@@ -278,26 +394,78 @@ namespace core {
 				CommandLine::getInstance().addToHeader(stringStream.str().c_str());
 			}
 
-			tp.wait();
+			// rays are computed by the workers when they are traced, and
+			// numbered on from the previous iteration
+			int firstRayNumber = iteration * launchGrid.size();
+
+			while (begin < end && !_interrupted) {
+				Timer segmentTimer;
+				size_t segmentEnd = (checkpointInterval > 0) ? std::min(end, begin + segmentSize) : end;
+				traceRays(launchGrid, begin, segmentEnd, firstRayNumber);
+
+				// an interrupted segment is traced again on resume
+				if (_interrupted) {
+					break;
+				}
+
+				begin = segmentEnd;
+				if (checkpointInterval > 0) {
+					checkpoint.iteration = (begin < end) ? iteration : iteration + 1;
+					checkpoint.nextIndex = (begin < end) ? begin : firstIndex;
+					writeCheckpoint(checkpoint);
+
+					double scale = checkpointInterval / std::max(segmentTimer.elapsed(), 1e-3);
+					scale = std::min(4.0, std::max(0.25, scale));
+					segmentSize = std::max(packetSize, (size_t)(segmentSize * scale) / packetSize * packetSize);
+				}
+			}
 
 			flushScene();
 		}
 
+		std::signal(SIGINT, SIG_DFL);
+		std::signal(SIGTERM, SIG_DFL);
 		stop();
 
 		double t = tmr.elapsed();
-		double tracingsPerSec = _numTracings / t;
+		TracingStatistics statistics = TracingStatistics::aggregate();
+		uint64_t numTracings = statistics.get(TracingStatistics::counter_steps);
+		double tracingsPerSec = numTracings / t;
 		char buffer[80];
 		CommandLine::getInstance().updateBody("\n");
-	    sprintf(buffer, "Elapsed: %5.2f sec. %d tracings done. %5.2f tracings/sec",
-	    		t, _numTracings, tracingsPerSec);
+	    sprintf(buffer, "Elapsed: %5.2f sec. %llu tracings done. %5.2f tracings/sec",
+	    		t, (unsigned long long)numTracings, tracingsPerSec);
 	    BOOST_LOG_TRIVIAL(warning) << buffer;
+	    BOOST_LOG_TRIVIAL(warning) << "Statistics: " << statistics;
+	    BOOST_LOG_TRIVIAL(info) << _scheduler->getNumSteals() << " chunks of rays stolen between threads";
+	    if (_rayCache) {
+	    	BOOST_LOG_TRIVIAL(warning) << _rayCache->getNumHits() << " rays served from the ray cache, "
+	    			<< _rayCache->getNumMisses() << " rays traced";
+	    	_rayCache->evict();
+	    	_rayCache.reset();
+	    }
+
+	    std::vector<TracingStatistics> threads = TracingStatistics::perThread();
+	    for (int i = 0; i < (int)threads.size(); i++) {
+	    	BOOST_LOG_TRIVIAL(info) << "Thread " << i << ": " << threads[i];
+	    }
 
 		//CsvExporter ce;
 		//ce.dump("Debug/data.csv", dataSet);
-		_exporter->dump(_outputFile, dataSet);
+		exportDataset();
 
-	    BOOST_LOG_TRIVIAL(warning) << "Results stored at: " << _outputFile;
+		if (_interrupted) {
+			BOOST_LOG_TRIVIAL(warning) << "Simulation interrupted";
+			if (checkpointInterval > 0) {
+				BOOST_LOG_TRIVIAL(warning) << "Continue it with --resume";
+			}
+		} else {
+			// a finished simulation has nothing to resume
+			std::remove(Checkpoint::getPath(_outputFile).c_str());
+			if (_numShards > 1) {
+				writeShardManifest(firstIndex, numRays, launchGrid.size());
+			}
+		}
 	}
 
 	void Application::stop() {
@@ -305,17 +473,207 @@ namespace core {
 		_isRunning = false;
 	}
 
+	void Application::interrupt() {
+
+		_interrupted = true;
+		if (_scheduler) {
+			_scheduler->cancel();
+		}
+	}
+
+	void Application::traceRays(const LaunchGrid &launchGrid, size_t begin, size_t end, int firstRayNumber) {
+
+		// consecutive rays differ in elevation only, so they stay close
+		// together and make a coherent packet
+		if (_context.engine == SimulationContext::engine_packet) {
+			size_t numPackets = (end - begin + PacketTracer::PACKET_SIZE - 1) / PacketTracer::PACKET_SIZE;
+			_scheduler->run(numPackets, [this, &launchGrid, begin, end, firstRayNumber](size_t p) {
+				size_t first = begin + p * PacketTracer::PACKET_SIZE;
+				size_t last = std::min(first + PacketTracer::PACKET_SIZE, end);
+				std::vector<Ray> packet;
+				for (size_t index = first; index < last; index++) {
+					packet.push_back(launchGrid.rayAt(index));
+					packet.back().rayNumber += firstRayNumber;
+				}
+				tracePacket(packet);
+			});
+		} else {
+			_scheduler->run(end - begin, [this, &launchGrid, begin, firstRayNumber](size_t index) {
+				Ray r = launchGrid.rayAt(begin + index);
+				r.rayNumber += firstRayNumber;
+				trace(r);
+			});
+		}
+	}
+
+	/**
+	 * Rays served from the cache count in the statistics of how rays end
+	 * as if they were traced
+	 */
+	void Application::trace(const Ray &ray) {
+
+		std::vector<Data> records;
+		Tracer::traceState state;
+		if (_rayCache && _rayCache->load(ray, records, state)) {
+			for (const Data &d : records) {
+				addToDataset(d);
+			}
+			TracingStatistics::local().recordTermination(state);
+			numCompletedWorkers++;
+			return;
+		}
+
+		tracedRecords = _rayCache ? &records : nullptr;
+		Worker w;
+		state = w.process(ray);
+		tracedRecords = nullptr;
+
+		if (_rayCache) {
+			for (const Data &d : records) {
+				addToDataset(d);
+			}
+			_rayCache->store(ray, records, state);
+		}
+	}
+
 	/**
-	 * Add geometries to the scenemanager
+	 * The rays which are not in the cache are traced as a smaller packet
+	 */
+	void Application::tracePacket(const std::vector<Ray> &rays) {
+
+		std::vector<Ray> packet;
+		std::vector<Data> records;
+		Tracer::traceState state;
+		for (const Ray &ray : rays) {
+			if (_rayCache && _rayCache->load(ray, records, state)) {
+				for (const Data &d : records) {
+					addToDataset(d);
+				}
+				records.clear();
+				TracingStatistics::local().recordTermination(state);
+				numCompletedWorkers++;
+			} else {
+				packet.push_back(ray);
+			}
+		}
+		if (packet.empty()) {
+			return;
+		}
+
+		tracedRecords = &records;
+		Worker w;
+		std::vector<Tracer::traceState> states = w.processPacket(packet);
+		tracedRecords = nullptr;
+
+		// the records of the rays of a packet are interleaved, so they are
+		// added ray by ray to keep the records of every ray together
+		for (size_t lane = 0; lane < packet.size(); lane++) {
+			const Ray &ray = packet[lane];
+			std::vector<Data> rayRecords;
+			for (const Data &d : records) {
+				if (d.rayNumber == ray.rayNumber) {
+					rayRecords.push_back(d);
+				}
+			}
+			for (const Data &d : rayRecords) {
+				addToDataset(d);
+			}
+			if (_rayCache) {
+				_rayCache->store(ray, rayRecords, states[lane]);
+			}
+		}
+	}
+
+	/**
+	 * The beacons and sweeps are left out, as they are part of the launch of
+	 * every ray. Files referred to by the configuration are not hashed.
+	 */
+	uint64_t Application::getPhysicsKey() {
+
+		const char *launchSettings[] = {"parallelism", "iterations", "frequencies", "SZA", "azimuth",
+				"beacons", "output", "rayCache"};
+		Json::Value application = _applicationConfig.getDocument();
+		for (const char *setting : launchSettings) {
+			if (application.isObject()) {
+				application.removeMember(setting);
+			}
+		}
+
+		Json::FastWriter writer;
+		std::string configuration = writer.write(application) + writer.write(_celestialConfig.getDocument())
+				+ (_includeMagneticField ? "magneticField" : "");
+		return RayCache::hash(configuration.data(), configuration.size());
+	}
+
+	void Application::resumeFromCheckpoint(Checkpoint &checkpoint) {
+
+		if (!_exporter->canResume()) {
+			BOOST_LOG_TRIVIAL(fatal) << "Simulations writing " << _outputFile << " can not be resumed! Exiting.";
+			std::exit(1);
+		}
+
+		std::string filepath = Checkpoint::getPath(_outputFile);
+		Checkpoint previous;
+		if (!previous.load(filepath)) {
+			BOOST_LOG_TRIVIAL(fatal) << "No checkpoint found at " << filepath << "! Exiting.";
+			std::exit(1);
+		}
+		if (previous.raysPerIteration != checkpoint.raysPerIteration
+				|| previous.shard != checkpoint.shard || previous.numShards != checkpoint.numShards) {
+			BOOST_LOG_TRIVIAL(fatal) << "The checkpoint at " << filepath << " is of another simulation! Exiting.";
+			std::exit(1);
+		}
+		if (getFileSize(_outputFile) < previous.outputOffset) {
+			BOOST_LOG_TRIVIAL(fatal) << _outputFile << " is shorter than its checkpoint! Exiting.";
+			std::exit(1);
+		}
+
+		// make sure the output can be continued before cutting it back
+		if (!_exporter->resume(_outputFile)) {
+			BOOST_LOG_TRIVIAL(fatal) << "Could not open " << _outputFile << " to continue it! Exiting.";
+			std::exit(1);
+		}
+		_exporter->close();
+
+		// results after the checkpoint belong to rays which are traced again
+		if (truncate(_outputFile, previous.outputOffset) != 0) {
+			BOOST_LOG_TRIVIAL(fatal) << "Could not cut " << _outputFile << " back to its checkpoint! Exiting.";
+			std::exit(1);
+		}
+
+		checkpoint = previous;
+		BOOST_LOG_TRIVIAL(warning) << "Resuming at iteration " << (checkpoint.iteration + 1)
+				<< ", ray " << (checkpoint.nextIndex + 1);
+	}
+
+	void Application::writeCheckpoint(Checkpoint &checkpoint) {
+
+		_writer->flush();
+		checkpoint.outputOffset = getFileSize(_outputFile);
+		checkpoint.save(Checkpoint::getPath(_outputFile));
+
+		BOOST_LOG_TRIVIAL(info) << "Checkpoint at iteration " << (checkpoint.iteration + 1)
+				<< ", ray " << (checkpoint.nextIndex + 1) << ", " << checkpoint.outputOffset << " bytes written";
+	}
+
+	/**
+	 * Add geometries to a new scenemanager and publish it to the workers
 	 */
 	void Application::createScene() {
 
-		_scm = SceneManager();
-		_scm.loadStaticEnvironment();
+		SceneManager scm;
+		scm.loadStaticEnvironment(_context, &_ionosphereTable);
+
+		// the analytic terrain is handled by the scene manager itself
+		if (_context.terrain == SimulationContext::terrain_sphere) {
+			BOOST_LOG_TRIVIAL(info) << "Spherical terrain, no scene objects created";
+			_scene = std::make_shared<const SceneManager>(std::move(scm));
+			return;
+		}
 
 		int numSceneObjectsCreated = 0;
-		double R = _celestialConfig.getInt("radius");
-		double angularStepSize = _applicationConfig.getDouble("angularStepSize");
+		double R = _context.radius;
+		double angularStepSize = _context.angularStepSize;
 
 		for (double latitude = 0 * Constants::PI; latitude <= 2 * Constants::PI; latitude += angularStepSize) {
 			for (double longitude = 0 * Constants::PI; longitude <= 2 * Constants::PI; longitude += angularStepSize) {
@@ -331,7 +689,7 @@ namespace core {
 				Terrain* tr = new Terrain(mesh);
 
 				numSceneObjectsCreated++;
-				_scm.addToScene(tr);
+				scm.addToScene(tr);
 			}
 		}
 
@@ -343,37 +701,68 @@ namespace core {
 			BOOST_LOG_TRIVIAL(info) << setprecision(3) << numSceneObjectsCreated/1.0e3 << "K scene objects created";
 		else
 			BOOST_LOG_TRIVIAL(info) << setprecision(3) << numSceneObjectsCreated << " scene objects created";
+
+		scm.buildIndex();
+		_scene = std::make_shared<const SceneManager>(std::move(scm));
 	}
 
 	/**
-	 * Flush the scene by clearing the list of scene objects
+	 * Flush the scene by deleting the scene objects created in createScene().
+	 * Must only be called once all workers have finished.
 	 */
 	void Application::flushScene() {
 
-		_scm.removeAllFromScene();
+		if (_scene) {
+			for (Geometry* g : _scene->getScene()) {
+				delete g;
+			}
+			_scene.reset();
+		}
 	}
 
-	void Application::addToDataset(Data dat) {
+	void Application::addToDataset(const Data &dat) {
+
+		if (tracedRecords) {
+			tracedRecords->push_back(dat);
+			return;
+		}
+
+		if (_writer) {
+			_writer->add(dat);
+			return;
+		}
 
 		datasetMutex.lock();
 		dataSet.push_back(dat);
-		if (dataSet.size() > Data::MAX_DATASET_SIZE) {
-			_exporter->dump(_outputFile, dataSet);
-			dataSet.clear();
-		}
 		datasetMutex.unlock();
 	}
 
-	void Application::incrementTracing() {
+	void Application::openDataset() {
 
-		tracingIncMutex.lock();
-		_numTracings++;
-		tracingIncMutex.unlock();
+		_writer.reset(new DataWriter(_exporter, _outputFile, _context.outputMemoryBudget, _resume));
+		BOOST_LOG_TRIVIAL(info) << "Writing results in buffers of " << _writer->getBufferSize()
+				<< " records, " << _writer->getMemoryBudget() << " bytes budget";
 	}
 
-	SceneManager Application::getSceneManager() {
+	void Application::exportDataset() {
+
+		if (_writer) {
+			_writer->close();
+			BOOST_LOG_TRIVIAL(info) << "Writer waited " << _writer->getNumWaits() << " times for memory";
+			_writer.reset();
+		} else {
+			datasetMutex.lock();
+			_exporter->dump(_outputFile, dataSet);
+			dataSet.clear();
+			datasetMutex.unlock();
+		}
 
-		return _scm;
+	    BOOST_LOG_TRIVIAL(warning) << "Results stored at: " << _outputFile;
+	}
+
+	std::shared_ptr<const SceneManager> Application::getSceneManager() {
+
+		return _scene;
 	}
 
 	Config Application::getApplicationConfig() {
@@ -389,11 +778,51 @@ namespace core {
 	void Application::setCelestialConfig(Config conf) {
 
 		_celestialConfig = conf;
+		createSimulationContext();
 	}
 
 	void Application::setApplicationConfig(Config conf) {
 
 		_applicationConfig = conf;
+		createSimulationContext();
+	}
+
+	const SimulationContext& Application::getSimulationContext() {
+
+		return _context;
+	}
+
+	const IonosphereTable& Application::getIonosphereTable() {
+
+		return _ionosphereTable;
+	}
+
+	/**
+	 * Rebuild the typed configuration snapshot. Must not be called while
+	 * rays are being traced.
+	 */
+	void Application::createSimulationContext() {
+
+		_context = SimulationContext(_applicationConfig, _celestialConfig, _includeMagneticField);
+	}
+
+	void Application::writeShardManifest(size_t firstIndex, size_t numRays, size_t gridSize) {
+
+		Json::Value manifest;
+		manifest["shard"] = _shard;
+		manifest["shards"] = _numShards;
+		manifest["firstRay"] = (Json::UInt64)(firstIndex + 1);
+		manifest["numRays"] = (Json::UInt64)numRays;
+		manifest["raysPerIteration"] = (Json::UInt64)gridSize;
+		manifest["iterations"] = _applicationConfig.getInt("iterations");
+		manifest["output"] = _outputFile;
+		manifest["config"] = _applicationConfigFile;
+		manifest["scenario"] = _celestialConfigFile;
+
+		std::string filepath = Merge::getManifestPath(_outputFile);
+		std::ofstream file(filepath.c_str());
+		file << Json::StyledWriter().write(manifest);
+		BOOST_LOG_TRIVIAL(warning) << "Shard manifest stored at: " << filepath;
 	}
 
 	int Application::getVerbosity() {
@@ -414,20 +843,24 @@ namespace core {
 		BOOST_LOG_TRIVIAL(info) << "Found the following file extension for export: " << fileext;
 		if (fileext == "csv") {
 			_exporterType = ExporterType::Csv;
-			_exporter = new CsvExporter(_outputFile);
+			_exporter = _resume ? new CsvExporter() : new CsvExporter(_outputFile);
 			BOOST_LOG_TRIVIAL(info) << "CSV Exporter selected.\n";
 		} else if (fileext == "dat") {
 			_exporterType = ExporterType::Matlab;
-			_exporter = new MatlabExporter(_outputFile);
+			_exporter = _resume ? new MatlabExporter() : new MatlabExporter(_outputFile);
 			BOOST_LOG_TRIVIAL(info) << "Matlab Exporter selected.\n";
 		} else if (fileext == "vtk") {
 			_exporterType = ExporterType::Matlab;
-			_exporter = new VtkExporter(_outputFile);
+			_exporter = _resume ? new VtkExporter() : new VtkExporter(_outputFile);
 			BOOST_LOG_TRIVIAL(info) << "VTK Exporter selected.\n";
 		} else if (fileext == "json") {
 			_exporterType = ExporterType::Matlab;
-			_exporter = new JsonExporter(_outputFile);
+			_exporter = _resume ? new JsonExporter() : new JsonExporter(_outputFile);
 			BOOST_LOG_TRIVIAL(info) << "Json Exporter selected.\n";
+		} else if (fileext == "bin") {
+			_exporterType = ExporterType::Binary;
+			_exporter = _resume ? new BinaryExporter() : new BinaryExporter(_outputFile);
+			BOOST_LOG_TRIVIAL(info) << "Binary Exporter selected.\n";
 		}
 	}
 
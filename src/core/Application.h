@@ -8,11 +8,16 @@
 #ifndef APPLICATION_H_
 #define APPLICATION_H_
 
+#include <atomic>
 #include <iostream>
 #include <list>
+#include <memory>
 #include <stdlib.h>
 #include <boost/thread.hpp>
+#include "Checkpoint.h"
 #include "Config.h"
+#include "RayCache.h"
+#include "SimulationContext.h"
 #include "../scene/SceneManager.h"
 #include "../scene/Ionosphere.h"
 #include "../scene/Atmosphere.h"
@@ -20,12 +25,14 @@
 #include "../tracer/Ray.h"
 #include "../exporter/Data.h"
 #include "../exporter/IExporter.h"
+#include "../exporter/DataWriter.h"
 #include "../math/Constants.h"
 #include "../math/NormalDistribution.h"
+#include "../threading/Scheduler.h"
 #include "../threading/Worker.h"
-#include "../../contrib/threadpool/threadpool.hpp"
 #include "../../contrib/jsoncpp/value.h"
 #include "../scene/IonosphereConfigParser.h"
+#include "../scene/IonosphereTable.h"
 
 namespace raytracer {
 namespace core {
@@ -34,6 +41,8 @@ namespace core {
 	using namespace exporter;
 	using namespace tracer;
 
+	class LaunchGrid;
+
 	class Application {
 
 		public:
@@ -46,23 +55,59 @@ namespace core {
 			void start();
 			void run();
 			void stop();
-			void addToDataset(Data dat);
-			void incrementTracing();
-			SceneManager getSceneManager();
+
+			/**
+			 * Stop tracing, and write the results traced so far. Only sets
+			 * flags, so that it can be called from a signal handler.
+			 */
+			void interrupt();
+			void addToDataset(const Data &dat);
+
+			/**
+			 * Write the data added from now on while it is collected, on a
+			 * background thread, until exportDataset() is called. Without it,
+			 * data is collected in dataSet.
+			 */
+			void openDataset();
+
+			/**
+			 * Dump the data collected so far with the configured exporter
+			 */
+			void exportDataset();
+
+			/**
+			 * The scene of the current iteration. The scene is immutable once
+			 * published, so workers can share it without copying or locking.
+			 */
+			std::shared_ptr<const SceneManager> getSceneManager();
 			list<Data> dataSet;
 			list<Ray> rays;
 			Config getApplicationConfig();
 			Config getCelestialConfig();
 			void setCelestialConfig(Config conf);
 			void setApplicationConfig(Config conf);
+
+			/**
+			 * Typed snapshot of the configuration, to be used on the hot path
+			 * instead of the json based getApplicationConfig() and
+			 * getCelestialConfig()
+			 */
+			const SimulationContext& getSimulationContext();
+
+			/**
+			 * Precomputed ionosphere of the current scenario. Only built when
+			 * the simulation is started.
+			 */
+			const IonosphereTable& getIonosphereTable();
 			int getVerbosity();
 			bool includeMagneticFieldEffects();
 			int numWorkers = 0;
+			// rays of numWorkers which are traced or served from the ray cache
+			std::atomic<int> numCompletedWorkers{0};
 
 		private:
 			Application() {
 				_isRunning = false;
-				_numTracings = 0;
 			}
 			Application(Application const&);      // Don't Implement
 			void operator = (Application const&); // Don't implement
@@ -70,11 +115,51 @@ namespace core {
 			void createScene();
 			void flushScene();
 			void configureExporter();
+			void createSimulationContext();
+
+			/**
+			 * Trace the rays with launch indices [begin, end) of an iteration
+			 */
+			void traceRays(const LaunchGrid &launchGrid, size_t begin, size_t end, int firstRayNumber);
+
+			/**
+			 * Trace a ray or a packet of rays. Rays found in the ray cache
+			 * are not traced, their records are added from the cache.
+			 */
+			void trace(const Ray &ray);
+			void tracePacket(const std::vector<Ray> &rays);
+
+			/**
+			 * Hash of the configuration, apart from the settings which only
+			 * choose the rays to launch or how a run is carried out
+			 */
+			uint64_t getPhysicsKey();
+
+			/**
+			 * Read the checkpoint of the output, and cut the output back to
+			 * the rays it records as complete
+			 */
+			void resumeFromCheckpoint(Checkpoint &checkpoint);
+
+			/**
+			 * Flush the results and record how far the simulation got
+			 */
+			void writeCheckpoint(Checkpoint &checkpoint);
+
+			/**
+			 * Describe the part of the launch grid traced by this shard, for
+			 * the merge command
+			 */
+			void writeShardManifest(size_t firstIndex, size_t numRays, size_t gridSize);
 			bool _isRunning;
 			bool _includeMagneticField = false;
-			int _numTracings;
+			bool _resume = false;
+			bool _noCache = false;
+			std::atomic<bool> _interrupted{false};
 			Config _celestialConfig;
 			Config _applicationConfig;
+			SimulationContext _context;
+			IonosphereTable _ionosphereTable;
 			const char * _applicationConfigFile = "config/config.json";
 			const char * _celestialConfigFile = "";
 			const char * _outputFile = "Debug/data.dat";
@@ -84,8 +169,13 @@ namespace core {
 			int _fmin = 0;
 			int _fstep = 0;
 			int _fmax = 0;
-			SceneManager _scm;
+			int _shard = 0;
+			int _numShards = 1;
+			std::shared_ptr<const SceneManager> _scene;
+			std::unique_ptr<threading::Scheduler> _scheduler;
 			IExporter* _exporter;
+			std::unique_ptr<DataWriter> _writer;
+			std::unique_ptr<RayCache> _rayCache;
 			ExporterType _exporterType = ExporterType::Matlab;
 
 	};
@@ -0,0 +1,57 @@
+//============================================================================
+// Name        : Checkpoint.cpp
+// Author      : Rian van Gijlswijk
+// Description : Progress of a simulation, to resume it after an interruption
+//============================================================================
+
+#include <cstdio>
+#include <fstream>
+#include "Checkpoint.h"
+#include "../../contrib/jsoncpp/reader.h"
+#include "../../contrib/jsoncpp/writer.h"
+
+namespace raytracer {
+namespace core {
+
+	void Checkpoint::save(const std::string &filepath) const {
+
+		Json::Value checkpoint;
+		checkpoint["iteration"] = iteration;
+		checkpoint["nextIndex"] = (Json::UInt64)nextIndex;
+		checkpoint["outputOffset"] = (Json::UInt64)outputOffset;
+		checkpoint["raysPerIteration"] = (Json::UInt64)raysPerIteration;
+		checkpoint["shard"] = shard;
+		checkpoint["shards"] = numShards;
+
+		std::string temporary = filepath + ".tmp";
+		{
+			std::ofstream file(temporary.c_str());
+			file << Json::StyledWriter().write(checkpoint);
+		}
+		std::rename(temporary.c_str(), filepath.c_str());
+	}
+
+	bool Checkpoint::load(const std::string &filepath) {
+
+		std::ifstream file(filepath.c_str(), std::ifstream::binary);
+		Json::Value checkpoint;
+		if (!file.good() || !Json::Reader().parse(file, checkpoint, false) || !checkpoint.isObject()) {
+			return false;
+		}
+
+		iteration = checkpoint["iteration"].asInt();
+		nextIndex = checkpoint["nextIndex"].asUInt64();
+		outputOffset = checkpoint["outputOffset"].asUInt64();
+		raysPerIteration = checkpoint["raysPerIteration"].asUInt64();
+		shard = checkpoint["shard"].asInt();
+		numShards = checkpoint["shards"].asInt();
+		return true;
+	}
+
+	std::string Checkpoint::getPath(const std::string &output) {
+
+		return output + ".checkpoint.json";
+	}
+
+} /* namespace core */
+} /* namespace raytracer */
@@ -0,0 +1,52 @@
+//============================================================================
+// Name        : Checkpoint.h
+// Author      : Rian van Gijlswijk
+// Description : Progress of a simulation, written next to its output while it
+//				 runs, so that an interrupted simulation can be resumed. The
+//				 rays of an iteration are traced in launch order, in segments;
+//				 after each segment the results are flushed and the checkpoint
+//				 records up to where the grid and the output are complete.
+//============================================================================
+
+#ifndef CORE_CHECKPOINT_H_
+#define CORE_CHECKPOINT_H_
+
+#include <cstdint>
+#include <string>
+
+namespace raytracer {
+namespace core {
+
+	class Checkpoint {
+
+		public:
+			/**
+			 * Write the checkpoint to a temporary file which then replaces
+			 * the previous one, so that an interruption never leaves a
+			 * partial checkpoint behind
+			 */
+			void save(const std::string &filepath) const;
+
+			/**
+			 * Read a checkpoint, return false if there is none
+			 */
+			bool load(const std::string &filepath);
+
+			/**
+			 * Path of the checkpoint which a simulation writes next to its
+			 * output
+			 */
+			static std::string getPath(const std::string &output);
+
+			int iteration = 0;
+			uint64_t nextIndex = 0;			// first launch index of the iteration which is not complete
+			uint64_t outputOffset = 0;		// bytes of the output holding the complete rays
+			uint64_t raysPerIteration = 0;
+			int shard = 0;
+			int numShards = 1;
+	};
+
+} /* namespace core */
+} /* namespace raytracer */
+
+#endif /* CORE_CHECKPOINT_H_ */
@@ -40,6 +40,20 @@ namespace core {
 		}
 	}
 
+	bool Config::isMember(const char * path) {
+
+		return _doc.isObject() && _doc.isMember(path);
+	}
+
+	Json::Value Config::getValue(const char * path) {
+
+		if (!_doc.isMember(path)) {
+			cerr << path << " does not exist!" << endl;
+		}
+
+		return _doc[path];
+	}
+
 	int Config::getInt(const char * path) {
 
 		if (!_doc.isMember(path)) {
@@ -98,5 +112,10 @@ namespace core {
 		return _doc[path];
 	}
 
+	const Json::Value& Config::getDocument() const {
+
+		return _doc;
+	}
+
 } /* namespace core */
 } /* namespace raytracer */
@@ -19,12 +19,19 @@ namespace core {
 			Config();
 			Config(const char * filepath);
 			void loadFromFile(const char * filepath);
+			bool isMember(const char * path);
+			Json::Value getValue(const char * path);
 			int getInt(const char * path);
 			static math::Vector3d getVector3dFromObject(const Json::Value obj);
 			double getDouble(const char * path);
 			Json::Value getArray(const char * path);
 			Json::Value getObject(const char * path);
 
+			/**
+			 * The complete configuration
+			 */
+			const Json::Value& getDocument() const;
+
 			friend std::ostream& operator<<(std::ostream &strm, const raytracer::core::Config &c) {
 
 				return strm << c._doc.toStyledString();
@@ -0,0 +1,125 @@
+//============================================================================
+// Name        : LaunchGrid.cpp
+// Author      : Rian van Gijlswijk
+// Description : The rays launched by a simulation
+//============================================================================
+
+#include <cmath>
+#include "LaunchGrid.h"
+#include "../math/Constants.h"
+#include "../math/Matrix3d.h"
+#include "../radio/IsotropicAntenna.h"
+
+namespace raytracer {
+namespace core {
+
+	using namespace math;
+	using namespace radio;
+	using namespace tracer;
+
+	/**
+	 * A small tolerance keeps max in the sweep when (max - min) / step is
+	 * not exactly an integer because of rounding
+	 */
+	LaunchGrid::Sweep::Sweep(double min, double step, double max) {
+
+		this->min = min;
+		this->step = step;
+		if (max < min) {
+			size = 0;
+		} else if (step <= 0) {
+			size = 1;
+		} else {
+			size = (size_t)floor((max - min) / step + 1e-9) + 1;
+		}
+	}
+
+	LaunchGrid::LaunchGrid(Config &applicationConfig, double radius, int fmin, int fstep, int fmax) {
+
+		const Json::Value sza = applicationConfig.getObject("SZA");
+		const Json::Value azimuth = applicationConfig.getObject("azimuth");
+		_elevations = Sweep(sza["min"].asDouble(), sza["step"].asDouble(), sza["max"].asDouble());
+		_azimuths = Sweep(azimuth["min"].asDouble(), azimuth["step"].asDouble(), azimuth["max"].asDouble());
+		_frequencies = Sweep(fmin, fstep, fmax);
+
+		const Json::Value beacons = applicationConfig.getArray("beacons");
+		for (Json::ArrayIndex b = 0; b < beacons.size(); b++) {
+
+			double latitudeOffset = beacons[b].get("latitudeOffset", "").asDouble() * Constants::PI / 180.0;
+			double longitudeOffset = beacons[b].get("longitudeOffset", "").asDouble() * Constants::PI / 180.0;
+			double beaconAltitude = beacons[b].get("altitude", "").asDouble();
+			const Json::Value antenna = beacons[b].get("antenna", "");
+
+			Beacon beacon;
+//			beacon.antenna = AntennaFactory::createInstance(antenna.get("type", "").asString());
+			beacon.antenna = std::make_shared<IsotropicAntenna>();
+			beacon.antenna->setConfig(antenna);
+
+			Matrix3d latitude = Matrix3d::createRotationMatrix(latitudeOffset, Matrix3d::ROTATION_X);
+			Matrix3d longitude = Matrix3d::createRotationMatrix(longitudeOffset, Matrix3d::ROTATION_Z);
+			Matrix3d rotationMatrix = latitude * longitude;
+			beacon.startPosition = rotationMatrix * Vector3d(0, (radius+2+beaconAltitude), 0);
+
+			_beacons.push_back(beacon);
+		}
+	}
+
+	size_t LaunchGrid::size() const {
+
+		return _beacons.size() * _azimuths.size * _frequencies.size * _elevations.size;
+	}
+
+	Ray LaunchGrid::rayAt(size_t index) const {
+
+		size_t remainder = index;
+		size_t e = remainder % _elevations.size;
+		remainder /= _elevations.size;
+		size_t f = remainder % _frequencies.size;
+		remainder /= _frequencies.size;
+		size_t a = remainder % _azimuths.size;
+		size_t b = remainder / _azimuths.size;
+
+		const Beacon &beacon = _beacons[b];
+		double azimuth = _azimuths.at(a);
+		double elevation = _elevations.at(e);
+
+		Ray r;
+		r.rayNumber = index + 1;
+		r.frequency = _frequencies.at(f);
+		r.signalPower = beacon.antenna->getSignalPowerAt(azimuth, elevation);
+		r.o = beacon.startPosition;
+		r.originalAngle = elevation * Constants::PI / 180.0;
+		r.originBeaconId = b+1;
+		r.originalAzimuth = azimuth * Constants::PI / 180.0;
+
+		Matrix3d azimuthRotation = Matrix3d::createRotationMatrix(azimuth * Constants::PI / 180, Matrix3d::ROTATION_Y);
+		Vector3d direction = Vector3d(cos(Constants::PI/2.0 - r.originalAngle),
+				sin(Constants::PI/2.0 - r.originalAngle),
+				0).norm();
+		r.d = azimuthRotation * direction;
+
+		return r;
+	}
+
+	const LaunchGrid::Sweep& LaunchGrid::getAzimuths() const {
+
+		return _azimuths;
+	}
+
+	const LaunchGrid::Sweep& LaunchGrid::getFrequencies() const {
+
+		return _frequencies;
+	}
+
+	const LaunchGrid::Sweep& LaunchGrid::getElevations() const {
+
+		return _elevations;
+	}
+
+	size_t LaunchGrid::getNumBeacons() const {
+
+		return _beacons.size();
+	}
+
+} /* namespace core */
+} /* namespace raytracer */
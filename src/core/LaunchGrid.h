@@ -0,0 +1,82 @@
+//============================================================================
+// Name        : LaunchGrid.h
+// Author      : Rian van Gijlswijk
+// Description : The rays launched by a simulation: every combination of
+//				 beacon, azimuth, frequency and elevation. Rays are numbered,
+//				 and each is computed from its index when it is needed.
+//============================================================================
+
+#ifndef CORE_LAUNCHGRID_H_
+#define CORE_LAUNCHGRID_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "Config.h"
+#include "../math/Vector3d.h"
+#include "../radio/IAntenna.h"
+#include "../tracer/Ray.h"
+
+namespace raytracer {
+namespace core {
+
+	class LaunchGrid {
+
+		public:
+			/**
+			 * Values min, min + step, ... up to and including max. The
+			 * values are computed from their index, so that rounding errors
+			 * do not add up over a sweep.
+			 */
+			struct Sweep {
+				double min = 0;
+				double step = 1;
+				size_t size = 0;
+
+				Sweep() {}
+				Sweep(double min, double step, double max);
+
+				double at(size_t index) const {
+					return min + index * step;
+				}
+			};
+
+			/**
+			 * Read the beacons and the azimuth and elevation (SZA) sweeps of
+			 * the application config. The frequencies are passed separately,
+			 * as they can be set on the command line.
+			 */
+			LaunchGrid(Config &applicationConfig, double radius, int fmin, int fstep, int fmax);
+
+			/**
+			 * Number of rays in the grid
+			 */
+			size_t size() const;
+
+			/**
+			 * The ray with the given index. Elevation varies fastest, then
+			 * frequency, azimuth and beacon. The ray number is index + 1.
+			 */
+			tracer::Ray rayAt(size_t index) const;
+
+			const Sweep& getAzimuths() const;
+			const Sweep& getFrequencies() const;
+			const Sweep& getElevations() const;
+			size_t getNumBeacons() const;
+
+		private:
+			struct Beacon {
+				math::Vector3d startPosition;
+				std::shared_ptr<radio::IAntenna> antenna;
+			};
+
+			std::vector<Beacon> _beacons;
+			Sweep _azimuths;		// deg
+			Sweep _frequencies;		// Hz
+			Sweep _elevations;		// deg
+	};
+
+} /* namespace core */
+} /* namespace raytracer */
+
+#endif /* CORE_LAUNCHGRID_H_ */
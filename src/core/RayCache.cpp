@@ -0,0 +1,249 @@
+//============================================================================
+// Name        : RayCache.cpp
+// Author      : Rian van Gijlswijk
+// Description : On-disk cache of the results of rays, shared between runs
+//============================================================================
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <boost/log/trivial.hpp>
+#include "RayCache.h"
+
+namespace raytracer {
+namespace core {
+
+	using namespace exporter;
+	using namespace tracer;
+
+	namespace {
+
+		const char MAGIC[8] = {'I', 'R', 'T', 'R', 'A', 'Y', '0', '2'};
+		constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+		struct File {
+			double time;
+			uint64_t size;
+			std::string path;
+		};
+
+		bool byTime(const File &a, const File &b) {
+
+			return a.time < b.time;
+		}
+
+		/**
+		 * Create a directory and its parents, if they do not exist yet
+		 */
+		void makeDirectories(const std::string &path) {
+
+			for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+				mkdir(path.substr(0, slash).c_str(), 0755);
+			}
+			mkdir(path.c_str(), 0755);
+		}
+
+		/**
+		 * Files in a directory, without . and ..
+		 */
+		std::vector<std::string> listDirectory(const std::string &path) {
+
+			std::vector<std::string> names;
+			DIR *directory = opendir(path.c_str());
+			if (directory == nullptr) {
+				return names;
+			}
+			while (struct dirent *entry = readdir(directory)) {
+				if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+					names.push_back(entry->d_name);
+				}
+			}
+			closedir(directory);
+			return names;
+		}
+	}
+
+	constexpr uint64_t RayCache::FNV_OFFSET_BASIS;
+
+	RayCache::RayCache(const std::string &directory, uint64_t physicsKey, uint64_t maxSize,
+			SimulationContext::cacheEviction eviction) {
+
+		_directory = directory;
+		_physicsKey = physicsKey;
+		_maxSize = maxSize;
+		_eviction = eviction;
+		_numHits.store(0);
+		_numMisses.store(0);
+		_numTemporaries.store(0);
+		makeDirectories(_directory);
+	}
+
+	/**
+	 * The entry starts with MAGIC, the size of a record, the launch, the
+	 * final state and the number of records, followed by the records
+	 */
+	bool RayCache::load(const Ray &ray, std::vector<Data> &records, Tracer::traceState &state) {
+
+		records.clear();
+		Launch launch = getLaunch(ray);
+		std::string path = getPath(launch);
+		std::ifstream file(path.c_str(), std::fstream::binary);
+
+		char magic[sizeof(MAGIC)];
+		uint32_t recordSize = 0;
+		Launch stored;
+		int32_t storedState = 0;
+		uint64_t count = 0;
+		file.read(magic, sizeof(magic));
+		file.read((char*)&recordSize, sizeof(recordSize));
+		file.read((char*)&stored, sizeof(stored));
+		file.read((char*)&storedState, sizeof(storedState));
+		file.read((char*)&count, sizeof(count));
+		if (!file.good() || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || recordSize != sizeof(Data)
+				|| memcmp(&stored, &launch, sizeof(Launch)) != 0) {
+			_numMisses++;
+			return false;
+		}
+
+		records.resize(count);
+		file.read((char*)records.data(), count * sizeof(Data));
+		if ((uint64_t)file.gcount() != count * sizeof(Data)) {
+			records.clear();
+			_numMisses++;
+			return false;
+		}
+
+		// the records are numbered as in the run which traced the ray
+		for (Data &d : records) {
+			d.rayNumber = ray.rayNumber;
+			d.beaconId = ray.originBeaconId;
+		}
+		state = (Tracer::traceState)storedState;
+		if (_eviction == SimulationContext::eviction_lru) {
+			utime(path.c_str(), nullptr);
+		}
+		_numHits++;
+		return true;
+	}
+
+	void RayCache::store(const Ray &ray, const std::vector<Data> &records, Tracer::traceState state) {
+
+		Launch launch = getLaunch(ray);
+		std::string path = getPath(launch);
+		makeDirectories(path.substr(0, path.find_last_of('/')));
+
+		std::string temporary = path + ".tmp" + std::to_string(getpid()) + "-" + std::to_string(_numTemporaries++);
+		uint32_t recordSize = sizeof(Data);
+		int32_t storedState = state;
+		uint64_t count = records.size();
+		{
+			std::ofstream file(temporary.c_str(), std::fstream::binary);
+			file.write(MAGIC, sizeof(MAGIC));
+			file.write((const char*)&recordSize, sizeof(recordSize));
+			file.write((const char*)&launch, sizeof(launch));
+			file.write((const char*)&storedState, sizeof(storedState));
+			file.write((const char*)&count, sizeof(count));
+			file.write((const char*)records.data(), count * sizeof(Data));
+			if (!file.good()) {
+				BOOST_LOG_TRIVIAL(warning) << "Could not write " << temporary << " to the ray cache";
+				file.close();
+				std::remove(temporary.c_str());
+				return;
+			}
+		}
+		std::rename(temporary.c_str(), path.c_str());
+	}
+
+	/**
+	 * The time of an entry is when it was stored, or last loaded with lru
+	 * eviction
+	 */
+	size_t RayCache::evict() {
+
+		std::vector<File> files;
+		uint64_t size = 0;
+		for (const std::string &subdirectory : listDirectory(_directory)) {
+			std::string subdirectoryPath = _directory + "/" + subdirectory;
+			for (const std::string &name : listDirectory(subdirectoryPath)) {
+				File file;
+				file.path = subdirectoryPath + "/" + name;
+				struct stat status;
+				if (stat(file.path.c_str(), &status) == 0 && S_ISREG(status.st_mode)) {
+					file.time = status.st_mtim.tv_sec + 1e-9 * status.st_mtim.tv_nsec;
+					file.size = status.st_size;
+					files.push_back(file);
+					size += file.size;
+				}
+			}
+		}
+
+		size_t numRemoved = 0;
+		if (size > _maxSize) {
+			std::sort(files.begin(), files.end(), byTime);
+			for (size_t i = 0; i < files.size() && size > _maxSize; i++) {
+				if (std::remove(files[i].path.c_str()) == 0) {
+					size -= files[i].size;
+					numRemoved++;
+				}
+			}
+		}
+
+		BOOST_LOG_TRIVIAL(info) << "Ray cache holds " << (files.size() - numRemoved) << " rays, "
+				<< size << " bytes; " << numRemoved << " rays evicted";
+		return numRemoved;
+	}
+
+	uint64_t RayCache::getNumHits() const {
+
+		return _numHits.load();
+	}
+
+	uint64_t RayCache::getNumMisses() const {
+
+		return _numMisses.load();
+	}
+
+	uint64_t RayCache::hash(const void *data, size_t size, uint64_t seed) {
+
+		const unsigned char *bytes = (const unsigned char*)data;
+		uint64_t h = seed;
+		for (size_t i = 0; i < size; i++) {
+			h ^= bytes[i];
+			h *= FNV_PRIME;
+		}
+		return h;
+	}
+
+	RayCache::Launch RayCache::getLaunch(const Ray &ray) const {
+
+		Launch launch;
+		memset(&launch, 0, sizeof(launch));
+		launch.physicsKey = _physicsKey;
+		launch.ox = ray.o.x;
+		launch.oy = ray.o.y;
+		launch.oz = ray.o.z;
+		launch.dx = ray.d.x;
+		launch.dy = ray.d.y;
+		launch.dz = ray.d.z;
+		launch.elevation = ray.originalAngle;
+		launch.azimuth = ray.originalAzimuth;
+		launch.frequency = ray.frequency;
+		launch.signalPower = ray.signalPower;
+		return launch;
+	}
+
+	std::string RayCache::getPath(const Launch &launch) const {
+
+		char name[20];
+		snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash(&launch, sizeof(launch)));
+		return _directory + "/" + std::string(name, 2) + "/" + std::string(name + 2);
+	}
+
+} /* namespace core */
+} /* namespace raytracer */
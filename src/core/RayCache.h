@@ -0,0 +1,105 @@
+//============================================================================
+// Name        : RayCache.h
+// Author      : Rian van Gijlswijk
+// Description : On-disk cache of the results of rays, shared between runs.
+//				 An entry holds the records of one ray and is addressed by a
+//				 hash of its launch and of the configuration it was traced
+//				 in, so runs which only add rays to an earlier run trace only
+//				 the new ones.
+//============================================================================
+
+#ifndef CORE_RAYCACHE_H_
+#define CORE_RAYCACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SimulationContext.h"
+#include "../exporter/Data.h"
+#include "../tracer/Ray.h"
+#include "../tracer/Tracer.h"
+
+namespace raytracer {
+namespace core {
+
+	/**
+	 * Entries are stored as <directory>/<2 hex digits>/<14 hex digits> of
+	 * the hash of the launch. The launch is repeated in the entry, so that
+	 * a hash collision is a miss rather than a wrong result. Entries are
+	 * written to a temporary file first, so that runs can share a cache.
+	 */
+	class RayCache {
+
+		public:
+			/**
+			 * physicsKey identifies everything apart from the launch which
+			 * changes the path of a ray, see hash(). maxSize is the number of
+			 * bytes kept by evict().
+			 */
+			RayCache(const std::string &directory, uint64_t physicsKey, uint64_t maxSize,
+					SimulationContext::cacheEviction eviction);
+
+			/**
+			 * Read the records of a ray, numbered as the given ray, and the
+			 * state its tracing ended in. Returns false, with no records, if
+			 * the ray is not in the cache.
+			 */
+			bool load(const tracer::Ray &ray, std::vector<exporter::Data> &records,
+					tracer::Tracer::traceState &state);
+
+			/**
+			 * Store the records of a ray and the state its tracing ended in.
+			 * The ray must be as it was launched.
+			 */
+			void store(const tracer::Ray &ray, const std::vector<exporter::Data> &records,
+					tracer::Tracer::traceState state);
+
+			/**
+			 * Remove entries until the cache fits in its maximum size. Returns
+			 * the number of entries removed.
+			 */
+			size_t evict();
+
+			uint64_t getNumHits() const;
+			uint64_t getNumMisses() const;
+
+			/**
+			 * 64 bit FNV-1a hash, which is the same on every run
+			 */
+			static uint64_t hash(const void *data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
+
+			static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+		private:
+			/**
+			 * Everything about a ray which changes its records, as stored in
+			 * the header of its entry
+			 */
+			struct Launch {
+				uint64_t physicsKey;
+				double ox, oy, oz;
+				double dx, dy, dz;
+				double elevation;
+				double azimuth;
+				double frequency;
+				double signalPower;
+			};
+
+			Launch getLaunch(const tracer::Ray &ray) const;
+			std::string getPath(const Launch &launch) const;
+
+			std::string _directory;
+			uint64_t _physicsKey;
+			uint64_t _maxSize;
+			SimulationContext::cacheEviction _eviction;
+			std::atomic<uint64_t> _numHits;
+			std::atomic<uint64_t> _numMisses;
+			std::atomic<uint64_t> _numTemporaries;
+	};
+
+} /* namespace core */
+} /* namespace raytracer */
+
+#endif /* CORE_RAYCACHE_H_ */
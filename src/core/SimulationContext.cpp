@@ -0,0 +1,156 @@
+//============================================================================
+// Name        : SimulationContext.cpp
+// Author      : Rian van Gijlswijk
+// Description : Typed, read-only snapshot of the simulation configuration
+//============================================================================
+
+#include <cstdlib>
+#include <boost/log/trivial.hpp>
+#include "SimulationContext.h"
+
+namespace raytracer {
+namespace core {
+
+	SimulationContext::SimulationContext() {}
+
+	/**
+	 * Read all values which are needed while tracing from the configuration
+	 * files. Missing values are left at their defaults, so that a context can
+	 * also be built from a partial configuration.
+	 */
+	SimulationContext::SimulationContext(Config &applicationConfig, Config &celestialConfig,
+			bool includeMagneticField) {
+
+		this->includeMagneticField = includeMagneticField;
+
+		if (celestialConfig.isMember("radius")) {
+			radius = celestialConfig.getInt("radius");
+		}
+		sceneBoundary = radius + SCENE_BOUNDARY_ALTITUDE;
+
+		if (celestialConfig.isMember("surfaceNCO2")) {
+			surfaceNCO2 = toDouble(celestialConfig.getValue("surfaceNCO2"), 0);
+		}
+
+		// older scenario files describe the ionosphere as an array of layers
+		// without a step size. Those are not supported by the tracer.
+		if (celestialConfig.isMember("ionosphere") && celestialConfig.getValue("ionosphere").isObject()) {
+			const Json::Value ionosphereConfig = celestialConfig.getObject("ionosphere");
+			ionosphereStart = toDouble(ionosphereConfig["start"], 0);
+			ionosphereStep = toDouble(ionosphereConfig["step"], 0);
+			ionosphereEnd = toDouble(ionosphereConfig["end"], 0);
+
+			const Json::Value layers = ionosphereConfig["layers"];
+			for (Json::ArrayIndex idx = 0; idx < layers.size(); idx++) {
+				IonosphereLayerParameters layer;
+				layer.electronPeakDensity = toDouble(layers[idx]["electronPeakDensity"], 0);
+				layer.peakProductionAltitude = toDouble(layers[idx]["peakProductionAltitude"], 0);
+				layer.neutralScaleHeight = toDouble(layers[idx]["neutralScaleHeight"], 11.1e3);
+				ionosphereLayers.push_back(layer);
+			}
+		}
+
+		if (applicationConfig.isMember("tracingLimit")) {
+			tracingLimit = applicationConfig.getInt("tracingLimit");
+		}
+		if (applicationConfig.isMember("angularStepSize")) {
+			angularStepSize = toDouble(applicationConfig.getValue("angularStepSize"), 0);
+		}
+		if (applicationConfig.isMember("terrainModel")) {
+			std::string model = applicationConfig.getValue("terrainModel").asString();
+			if (model == "sphere") {
+				terrain = terrain_sphere;
+			} else if (model != "patches") {
+				BOOST_LOG_TRIVIAL(warning) << "Unknown terrain model " << model << ", using patches";
+			}
+		}
+		if (applicationConfig.isMember("engine")) {
+			std::string name = applicationConfig.getValue("engine").asString();
+			if (name == "packet") {
+				engine = engine_packet;
+			} else if (name == "haselgrove") {
+				engine = engine_haselgrove;
+			} else if (name == "linear_layers") {
+				engine = engine_linear_layers;
+			} else if (name != "scalar") {
+				BOOST_LOG_TRIVIAL(warning) << "Unknown tracer engine " << name << ", using scalar";
+			}
+		}
+		if (applicationConfig.isMember("haselgrove")) {
+			const Json::Value haselgroveConfig = applicationConfig.getValue("haselgrove");
+			haselgroveTolerance = toDouble(haselgroveConfig["tolerance"], haselgroveTolerance);
+		}
+		if (applicationConfig.isMember("quasiParabolic")) {
+			const Json::Value quasiParabolicConfig = applicationConfig.getValue("quasiParabolic");
+			quasiParabolicMaxError = toDouble(quasiParabolicConfig["maxError"], quasiParabolicMaxError);
+		}
+		if (applicationConfig.isMember("output")) {
+			const Json::Value outputConfig = applicationConfig.getValue("output");
+			outputMemoryBudget = (size_t)toDouble(outputConfig["memoryBudget"], outputMemoryBudget);
+			checkpointInterval = toDouble(outputConfig["checkpointInterval"], checkpointInterval);
+		}
+		if (applicationConfig.isMember("rayCache")) {
+			const Json::Value cacheConfig = applicationConfig.getValue("rayCache");
+			useRayCache = cacheConfig.get("enabled", false).asBool();
+			rayCacheDirectory = cacheConfig.get("directory", rayCacheDirectory).asString();
+			rayCacheMaxSize = (uint64_t)toDouble(cacheConfig["maxSize"], rayCacheMaxSize);
+			std::string eviction = cacheConfig.get("eviction", "lru").asString();
+			if (eviction == "oldest") {
+				rayCacheEviction = eviction_oldest;
+			} else if (eviction != "lru") {
+				BOOST_LOG_TRIVIAL(warning) << "Unknown cache eviction " << eviction << ", using lru";
+			}
+		}
+		if (applicationConfig.isMember("ionosphereTable")) {
+			const Json::Value tableConfig = applicationConfig.getValue("ionosphereTable");
+			useIonosphereTable = tableConfig.get("enabled", false).asBool();
+			ionosphereTableMaxError = toDouble(tableConfig["maxError"], ionosphereTableMaxError);
+		}
+		if (applicationConfig.isMember("emptySpaceSkipping")) {
+			const Json::Value skipConfig = applicationConfig.getValue("emptySpaceSkipping");
+			skipEmptySpace = skipConfig.get("enabled", true).asBool();
+			skipPlasmaFrequencyRatio = toDouble(skipConfig["plasmaFrequencyRatio"], 0);
+		}
+		if (applicationConfig.isMember("magneticFields")) {
+			const Json::Value fields = applicationConfig.getValue("magneticFields");
+			for (Json::ArrayIndex idx = 0; idx < fields.size(); idx++) {
+				MagneticFieldParameters field;
+				field.strength = toDouble(fields[idx]["strength"], 0);
+				if (fields[idx].isMember("direction")) {
+					field.direction = Config::getVector3dFromObject(fields[idx]["direction"]);
+				}
+				magneticFields.push_back(field);
+			}
+		}
+	}
+
+	/**
+	 * Strength of the first magnetic field, or 0 if no magnetic
+	 * fields are configured
+	 */
+	double SimulationContext::getMagneticFieldStrength() const {
+
+		if (magneticFields.empty()) {
+			return 0;
+		}
+
+		return magneticFields[0].strength;
+	}
+
+	/**
+	 * Numerical values are stored both as json numbers and as strings (e.g.
+	 * "2.5e11") in the config files. Accept both.
+	 */
+	double SimulationContext::toDouble(const Json::Value &value, double defaultValue) {
+
+		if (value.isNull()) {
+			return defaultValue;
+		} else if (value.isString()) {
+			return atof(value.asCString());
+		}
+
+		return value.asDouble();
+	}
+
+} /* namespace core */
+} /* namespace raytracer */
@@ -0,0 +1,112 @@
+//============================================================================
+// Name        : SimulationContext.h
+// Author      : Rian van Gijlswijk
+// Description : Typed, read-only snapshot of the application and celestial
+//				 configuration. Built once per run so that the tracer does not
+//				 need to query the json configuration on every step
+//============================================================================
+
+#ifndef CORE_SIMULATIONCONTEXT_H_
+#define CORE_SIMULATIONCONTEXT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Config.h"
+#include "../math/Vector3d.h"
+
+namespace raytracer {
+namespace core {
+
+	/**
+	 * Parameters of a single chapman layer as given in the ionosphere.layers
+	 * array of the scenario file
+	 */
+	struct IonosphereLayerParameters {
+		double electronPeakDensity = 0;		// m^-3
+		double peakProductionAltitude = 0;	// m
+		double neutralScaleHeight = 11.1e3;	// m
+	};
+
+	/**
+	 * A magnetic field as given in the magneticFields array of the
+	 * application config
+	 */
+	struct MagneticFieldParameters {
+		double strength = 0;				// T
+		math::Vector3d direction;
+	};
+
+	class SimulationContext {
+
+		public:
+			enum terrainModel {
+				terrain_patches,	// flat Terrain patches, created in Application::createScene
+				terrain_sphere		// ideal sphere with the scenario radius
+			};
+
+			enum tracerEngine {
+				engine_scalar,		// every ray is traced by its own Tracer
+				engine_packet,		// rays are traced in packets by a PacketTracer
+				engine_haselgrove,	// the ray equations are integrated by a HaselgroveTracer
+				engine_linear_layers	// a HaselgroveTracer crosses layers with a linear n^2 in single steps
+			};
+
+			enum cacheEviction {
+				eviction_lru,		// the entries used longest ago are removed first
+				eviction_oldest		// the entries stored longest ago are removed first
+			};
+
+			SimulationContext();
+			SimulationContext(Config &applicationConfig, Config &celestialConfig,
+					bool includeMagneticField);
+
+			/**
+			 * Strength of the first magnetic field, or 0 if no magnetic
+			 * fields are configured
+			 */
+			double getMagneticFieldStrength() const;
+
+			// celestial config
+			double radius = 0;					// m
+			double sceneBoundary = 0;			// m, measured from the center
+			double surfaceNCO2 = 0;				// m^-3
+			double ionosphereStart = 0;			// m
+			double ionosphereStep = 0;			// m
+			double ionosphereEnd = 0;			// m
+			std::vector<IonosphereLayerParameters> ionosphereLayers;
+
+			// application config
+			int tracingLimit = 0;
+			double angularStepSize = 0;			// rad
+			std::vector<MagneticFieldParameters> magneticFields;
+			bool includeMagneticField = false;
+			terrainModel terrain = terrain_patches;
+			bool useIonosphereTable = false;
+			double ionosphereTableMaxError = 1e-3;	// relative to the peak electron density
+			bool skipEmptySpace = false;
+			double skipPlasmaFrequencyRatio = 0;	// layers with w_p below this fraction of w are skipped
+			tracerEngine engine = engine_scalar;
+			double haselgroveTolerance = 1e-9;		// error per step, relative to the distance from the center
+			double quasiParabolicMaxError = 1e-4;	// of the fitted profile, relative to the peak electron density
+			size_t outputMemoryBudget = 64 << 20;	// bytes of results waiting to be written
+			double checkpointInterval = 60;			// s between checkpoints of a simulation, 0 disables them
+			bool useRayCache = false;
+			std::string rayCacheDirectory = "cache";
+			uint64_t rayCacheMaxSize = 1ull << 30;	// bytes
+			cacheEviction rayCacheEviction = eviction_lru;
+
+			/**
+			 * Rays further away from the surface than this altitude are
+			 * considered to have left the scene
+			 */
+			static constexpr double SCENE_BOUNDARY_ALTITUDE = 250e3;	// m
+
+		private:
+			static double toDouble(const Json::Value &value, double defaultValue);
+	};
+
+} /* namespace core */
+} /* namespace raytracer */
+
+#endif /* CORE_SIMULATIONCONTEXT_H_ */
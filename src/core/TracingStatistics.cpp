@@ -0,0 +1,135 @@
+//============================================================================
+// Name        : TracingStatistics.cpp
+// Author      : Rian van Gijlswijk
+// Description : Per-thread counters of the tracing engines
+//============================================================================
+
+#include <boost/thread/mutex.hpp>
+#include "TracingStatistics.h"
+
+namespace raytracer {
+namespace core {
+
+	using namespace tracer;
+
+	namespace {
+
+		/**
+		 * Counters of every thread which traced. The counters are never
+		 * freed, so that they can be summed after their thread has ended.
+		 */
+		boost::mutex registryMutex;
+		std::vector<TracingStatistics*> registry;
+
+		TracingStatistics* registerThread() {
+
+			TracingStatistics *statistics = new TracingStatistics();
+			boost::mutex::scoped_lock lock(registryMutex);
+			registry.push_back(statistics);
+			return statistics;
+		}
+	}
+
+	TracingStatistics::TracingStatistics() {
+
+		for (int c = 0; c < NUM_COUNTERS; c++) {
+			_counts[c].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	TracingStatistics::TracingStatistics(const TracingStatistics &other) {
+
+		for (int c = 0; c < NUM_COUNTERS; c++) {
+			_counts[c].store(other.get((counter)c), std::memory_order_relaxed);
+		}
+	}
+
+	TracingStatistics& TracingStatistics::local() {
+
+		static thread_local TracingStatistics *statistics = registerThread();
+		return *statistics;
+	}
+
+	TracingStatistics TracingStatistics::aggregate() {
+
+		TracingStatistics sum;
+		boost::mutex::scoped_lock lock(registryMutex);
+		for (const TracingStatistics *statistics : registry) {
+			sum.add(*statistics);
+		}
+		return sum;
+	}
+
+	std::vector<TracingStatistics> TracingStatistics::perThread() {
+
+		boost::mutex::scoped_lock lock(registryMutex);
+		std::vector<TracingStatistics> result;
+		for (const TracingStatistics *statistics : registry) {
+			result.push_back(*statistics);
+		}
+		return result;
+	}
+
+	void TracingStatistics::reset() {
+
+		boost::mutex::scoped_lock lock(registryMutex);
+		for (TracingStatistics *statistics : registry) {
+			for (int c = 0; c < NUM_COUNTERS; c++) {
+				statistics->_counts[c].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void TracingStatistics::recordTermination(Tracer::traceState state) {
+
+		switch (state) {
+			case Tracer::state_terrain:
+				increment(counter_terrain);
+				break;
+			case Tracer::state_out_of_bounds:
+				increment(counter_escapes);
+				break;
+			case Tracer::state_no_propagation:
+				increment(counter_no_propagation);
+				break;
+			case Tracer::state_nan:
+				increment(counter_nan_aborts);
+				break;
+			case Tracer::state_tracing_limit:
+				increment(counter_tracing_limit_aborts);
+				break;
+			default:
+				break;
+		}
+	}
+
+	uint64_t TracingStatistics::get(counter c) const {
+
+		return _counts[c].load(std::memory_order_relaxed);
+	}
+
+	const char* TracingStatistics::getName(counter c) {
+
+		static const char* names[NUM_COUNTERS] = {"steps", "reflections", "refractions", "terrain",
+				"escapes", "no propagation", "NaN aborts", "tracing limit aborts"};
+		return names[c];
+	}
+
+	std::ostream& operator<<(std::ostream &strm, const TracingStatistics &statistics) {
+
+		for (int c = 0; c < TracingStatistics::NUM_COUNTERS; c++) {
+			TracingStatistics::counter name = (TracingStatistics::counter)c;
+			strm << (c > 0 ? ", " : "") << TracingStatistics::getName(name) << ": " << statistics.get(name);
+		}
+		return strm;
+	}
+
+	void TracingStatistics::add(const TracingStatistics &other) {
+
+		for (int c = 0; c < NUM_COUNTERS; c++) {
+			_counts[c].store(get((counter)c) + other.get((counter)c), std::memory_order_relaxed);
+		}
+	}
+
+} /* namespace core */
+} /* namespace raytracer */
@@ -0,0 +1,90 @@
+//============================================================================
+// Name        : TracingStatistics.h
+// Author      : Rian van Gijlswijk
+// Description : Per-thread counters of the tracing engines: steps, wave
+//				 behaviour and how rays end. Each thread only writes its own
+//				 counters, which are summed when they are reported.
+//============================================================================
+
+#ifndef CORE_TRACINGSTATISTICS_H_
+#define CORE_TRACINGSTATISTICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "../tracer/Tracer.h"
+
+namespace raytracer {
+namespace core {
+
+	class TracingStatistics {
+
+		public:
+			enum counter {
+				counter_steps = 0,
+				counter_reflections = 1,
+				counter_refractions = 2,
+				counter_terrain = 3,				// rays which ended on the terrain
+				counter_escapes = 4,				// rays which left the scene
+				counter_no_propagation = 5,
+				counter_nan_aborts = 6,
+				counter_tracing_limit_aborts = 7,
+				NUM_COUNTERS = 8
+			};
+
+			TracingStatistics();
+			TracingStatistics(const TracingStatistics &other);
+
+			/**
+			 * Counters of the calling thread. Threads register their counters
+			 * on first use, these are kept after the thread ends.
+			 */
+			static TracingStatistics& local();
+
+			/**
+			 * Sum of the counters of all threads
+			 */
+			static TracingStatistics aggregate();
+
+			/**
+			 * Counters of each thread which traced, in order of registration
+			 */
+			static std::vector<TracingStatistics> perThread();
+
+			/**
+			 * Set the counters of all threads to zero. Only to be called while
+			 * no thread is tracing.
+			 */
+			static void reset();
+
+			/**
+			 * Only the thread which owns the counters may increment them, so
+			 * there is no need for a locked read-modify-write
+			 */
+			void increment(counter c) {
+				_counts[c].store(_counts[c].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+
+			/**
+			 * Count the final state of a ray
+			 */
+			void recordTermination(tracer::Tracer::traceState state);
+
+			uint64_t get(counter c) const;
+			static const char* getName(counter c);
+
+			friend std::ostream& operator<<(std::ostream &strm, const TracingStatistics &statistics);
+
+		private:
+			void add(const TracingStatistics &other);
+
+			std::atomic<uint64_t> _counts[NUM_COUNTERS];
+			// keeps the counters of two threads out of the same cache line
+			char _padding[64];
+	};
+
+} /* namespace core */
+} /* namespace raytracer */
+
+#endif /* CORE_TRACINGSTATISTICS_H_ */
@@ -0,0 +1,91 @@
+//============================================================================
+// Name        : BinaryExporter.cpp
+// Author      : Rian van Gijlswijk
+// Description : Exports the records unformatted, at full precision
+//============================================================================
+
+#include <cstring>
+#include "BinaryExporter.h"
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+
+namespace raytracer {
+namespace exporter {
+
+	constexpr const char *BinaryExporter::MAGIC;
+	constexpr size_t BinaryExporter::MAGIC_SIZE;
+
+	BinaryExporter::BinaryExporter() {}
+
+	BinaryExporter::BinaryExporter(const char *filepath) {
+
+		// check if file exists
+		std::ifstream infile(filepath);
+		if (infile.good()) {
+			BOOST_LOG_TRIVIAL(fatal) << "file " << filepath << " already exists! Exiting.";
+			std::exit(1);
+		}
+	}
+
+	void BinaryExporter::open(const char *filepath) {
+
+		uint32_t recordSize = sizeof(Data);
+		_file.open(filepath, std::fstream::binary);
+		_file.write(MAGIC, MAGIC_SIZE);
+		_file.write((const char*)&recordSize, sizeof(recordSize));
+	}
+
+	void BinaryExporter::write(const Data *records, size_t count) {
+
+		_file.write((const char*)records, count * sizeof(Data));
+	}
+
+	void BinaryExporter::close() {
+
+		_file.close();
+	}
+
+	bool BinaryExporter::resume(const char *filepath) {
+
+		if (!BinaryReader(filepath).isOpen()) {
+			return false;
+		}
+		_file.open(filepath, std::fstream::binary | std::fstream::app);
+		return _file.is_open();
+	}
+
+	void BinaryExporter::flush() {
+
+		_file.flush();
+	}
+
+	BinaryReader::BinaryReader(const char *filepath) {
+
+		_file.open(filepath, std::fstream::binary);
+
+		char magic[BinaryExporter::MAGIC_SIZE];
+		uint32_t recordSize = 0;
+		_file.read(magic, BinaryExporter::MAGIC_SIZE);
+		_file.read((char*)&recordSize, sizeof(recordSize));
+		_isOpen = _file.good()
+				&& memcmp(magic, BinaryExporter::MAGIC, BinaryExporter::MAGIC_SIZE) == 0
+				&& recordSize == sizeof(Data);
+	}
+
+	bool BinaryReader::isOpen() const {
+
+		return _isOpen;
+	}
+
+	size_t BinaryReader::read(Data *records, size_t count) {
+
+		if (!_isOpen) {
+			return 0;
+		}
+		_file.read((char*)records, count * sizeof(Data));
+		return _file.gcount() / sizeof(Data);
+	}
+
+} /* namespace exporter */
+} /* namespace raytracer */
@@ -0,0 +1,68 @@
+//============================================================================
+// Name        : BinaryExporter.h
+// Author      : Rian van Gijlswijk
+// Description : Exports the records unformatted, at full precision, so that
+//				 they can be read back. Used for the output of shards, which
+//				 are merged into one file later.
+//============================================================================
+
+#ifndef EXPORTER_BINARYEXPORTER_H_
+#define EXPORTER_BINARYEXPORTER_H_
+
+#include <cstdint>
+#include <fstream>
+#include "IExporter.h"
+
+namespace raytracer {
+namespace exporter {
+
+	/**
+	 * The file starts with MAGIC and the size of a record, after which the
+	 * records follow as they are laid out in memory. Files can only be read
+	 * on the machine type they were written on.
+	 */
+	class BinaryExporter : public IExporter {
+
+		public:
+			BinaryExporter();
+			BinaryExporter(const char *filepath);
+			~BinaryExporter() {}
+			void open(const char *filepath);
+			void write(const Data *records, size_t count);
+			void close();
+			bool canResume() const { return true; }
+			bool resume(const char *filepath);
+			void flush();
+
+			static constexpr const char *MAGIC = "IRTDATA1";
+			static constexpr size_t MAGIC_SIZE = 8;
+
+		private:
+			std::ofstream _file;
+	};
+
+	class BinaryReader {
+
+		public:
+			/**
+			 * Open a file written by the BinaryExporter. isOpen() is false if
+			 * the file can not be read, or has a different format.
+			 */
+			BinaryReader(const char *filepath);
+
+			bool isOpen() const;
+
+			/**
+			 * Read up to count records, return the number read
+			 */
+			size_t read(Data *records, size_t count);
+
+		private:
+			std::ifstream _file;
+			bool _isOpen = false;
+	};
+
+} /* namespace exporter */
+} /* namespace raytracer */
+
+#endif /* EXPORTER_BINARYEXPORTER_H_ */
@@ -33,17 +33,36 @@ namespace exporter {
 		}
 	}
 
-	void CsvExporter::dump(const char *filepath, std::list<Data> dataset) {
-
-		std::ofstream data;
-		data.open(filepath);
-		data << "x,y\n";
-		while (!dataset.empty()) {
-			data << dataset.front().x << "," << dataset.front().y << "\n";
-			dataset.pop_front();
+	void CsvExporter::open(const char *filepath) {
+
+		_file.open(filepath);
+		_file << "x,y\n";
+	}
+
+	void CsvExporter::write(const Data *records, size_t count) {
+
+		for (const Data *d = records; d < records + count; d++) {
+			_file << d->x << "," << d->y << "\n";
 		}
-		data.close();
+	}
+
+	void CsvExporter::close() {
+
+		_file.close();
+	}
+
+	/**
+	 * The header is already in the file
+	 */
+	bool CsvExporter::resume(const char *filepath) {
+
+		_file.open(filepath, std::fstream::app);
+		return _file.is_open();
+	}
+
+	void CsvExporter::flush() {
 
+		_file.flush();
 	}
 
 } /* namespace exporter */
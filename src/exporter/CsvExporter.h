@@ -7,6 +7,7 @@
 #ifndef CsvEXPORTER_H_
 #define CsvEXPORTER_H_
 
+#include <fstream>
 #include "IExporter.h"
 
 namespace raytracer {
@@ -19,7 +20,15 @@ class CsvExporter : public IExporter {
 		CsvExporter();
 		CsvExporter(const char *filepath);
 		~CsvExporter() {}
-		void dump(const char *filepath, std::list<Data> dataset);
+		void open(const char *filepath);
+		void write(const Data *records, size_t count);
+		void close();
+		bool canResume() const { return true; }
+		bool resume(const char *filepath);
+		void flush();
+
+	private:
+		std::ofstream _file;
 
 };
 
@@ -33,8 +33,6 @@ namespace exporter {
 			double aoa = 0;
 			double n = 0;
 			scene::GeometryType collisionType = scene::GeometryType::none;
-
-			static constexpr int MAX_DATASET_SIZE = 1000000;
 	};
 
 } /* namespace exporter */
@@ -0,0 +1,190 @@
+//============================================================================
+// Name        : DataWriter.cpp
+// Author      : Rian van Gijlswijk
+// Description : Writes the results of the workers on a background thread
+//============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <boost/log/trivial.hpp>
+#include "DataWriter.h"
+
+namespace raytracer {
+namespace exporter {
+
+	namespace {
+
+		/**
+		 * Buffer of the calling thread, and the writer it belongs to. Writer
+		 * ids are never reused, so a buffer of a closed writer is not found.
+		 */
+		struct LocalBuffer {
+			uint64_t writer = 0;
+			std::vector<Data> *buffer = nullptr;
+		};
+
+		thread_local LocalBuffer localBuffer;
+		std::atomic<uint64_t> nextWriterId(1);
+	}
+
+	constexpr size_t DataWriter::BUFFER_SIZE;
+
+	DataWriter::DataWriter(IExporter *exporter, const char *filepath, size_t memoryBudget, bool resume) {
+
+		_exporter = exporter;
+		_filepath = filepath;
+		_memoryBudget = memoryBudget;
+		_bufferSize = std::max((size_t)1, std::min(BUFFER_SIZE, memoryBudget / (4 * sizeof(Data))));
+		_id = nextWriterId++;
+		if (!resume) {
+			_exporter->open(_filepath);
+		} else if (!_exporter->resume(_filepath)) {
+			BOOST_LOG_TRIVIAL(fatal) << "Can not write more results to " << _filepath << "! Exiting.";
+			std::exit(1);
+		}
+		_thread = boost::thread(&DataWriter::write, this);
+	}
+
+	DataWriter::~DataWriter() {
+
+		close();
+	}
+
+	void DataWriter::add(const Data &dat) {
+
+		LocalBuffer &local = localBuffer;
+		if (local.writer != _id) {
+			local.buffer = registerBuffer();
+			local.writer = _id;
+		}
+
+		if (local.buffer->size() >= _bufferSize && local.buffer->back().rayNumber != dat.rayNumber) {
+			submit(*local.buffer);
+		}
+		local.buffer->push_back(dat);
+	}
+
+	/**
+	 * The writer thread does not use the exporter while the queue is empty,
+	 * so the exporter can be flushed from the calling thread
+	 */
+	void DataWriter::flush() {
+
+		for (const std::unique_ptr<std::vector<Data> > &buffer : _buffers) {
+			if (!buffer->empty()) {
+				submit(*buffer);
+			}
+		}
+
+		boost::mutex::scoped_lock lock(_mutex);
+		while (_usedBytes > 0) {
+			_spaceAvailable.wait(lock);
+		}
+		_exporter->flush();
+	}
+
+	void DataWriter::close() {
+
+		if (!_thread.joinable()) {
+			return;
+		}
+
+		// buffers are not locked, the threads which own them have stopped adding
+		for (const std::unique_ptr<std::vector<Data> > &buffer : _buffers) {
+			if (!buffer->empty()) {
+				submit(*buffer);
+			}
+		}
+
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			_closing = true;
+		}
+		_batchAvailable.notify_one();
+		_thread.join();
+		_exporter->close();
+	}
+
+	size_t DataWriter::getBufferSize() const {
+
+		return _bufferSize;
+	}
+
+	size_t DataWriter::getMemoryBudget() const {
+
+		return _memoryBudget;
+	}
+
+	uint64_t DataWriter::getNumWaits() const {
+
+		boost::mutex::scoped_lock lock(_mutex);
+		return _numWaits;
+	}
+
+	std::vector<Data>* DataWriter::registerBuffer() {
+
+		std::vector<Data> *buffer = new std::vector<Data>();
+		buffer->reserve(_bufferSize);
+
+		boost::mutex::scoped_lock lock(_mutex);
+		_buffers.push_back(std::unique_ptr<std::vector<Data> >(buffer));
+		return buffer;
+	}
+
+	/**
+	 * Move the contents of a buffer to the queue. The memory budget only
+	 * holds back a batch if others are in the queue, so that a batch larger
+	 * than the budget is still written.
+	 */
+	void DataWriter::submit(std::vector<Data> &buffer) {
+
+		std::vector<Data> batch;
+		batch.swap(buffer);
+		buffer.reserve(_bufferSize);
+		size_t bytes = batch.size() * sizeof(Data);
+
+		boost::mutex::scoped_lock lock(_mutex);
+		if (_usedBytes > 0 && _usedBytes + bytes > _memoryBudget) {
+			_numWaits++;
+			while (_usedBytes > 0 && _usedBytes + bytes > _memoryBudget) {
+				_spaceAvailable.wait(lock);
+			}
+		}
+		_queue.push_back(std::move(batch));
+		_usedBytes += bytes;
+		lock.unlock();
+		_batchAvailable.notify_one();
+	}
+
+	/**
+	 * Main loop of the writer thread. The lock is released while the
+	 * exporter writes, so that workers can keep handing off buffers.
+	 */
+	void DataWriter::write() {
+
+		boost::mutex::scoped_lock lock(_mutex);
+		while (true) {
+			while (_queue.empty() && !_closing) {
+				_batchAvailable.wait(lock);
+			}
+			if (_queue.empty()) {
+				return;
+			}
+
+			std::vector<Data> batch = std::move(_queue.front());
+			_queue.pop_front();
+			lock.unlock();
+
+			_exporter->write(batch.data(), batch.size());
+			size_t bytes = batch.size() * sizeof(Data);
+			batch = std::vector<Data>();
+
+			lock.lock();
+			_usedBytes -= bytes;
+			_spaceAvailable.notify_all();
+		}
+	}
+
+} /* namespace exporter */
+} /* namespace raytracer */
@@ -0,0 +1,102 @@
+//============================================================================
+// Name        : DataWriter.h
+// Author      : Rian van Gijlswijk
+// Description : Writes the results of the workers on a background thread.
+//				 Every thread collects its results in a local buffer, which
+//				 is handed off whole to the writer through a bounded queue.
+//============================================================================
+
+#ifndef EXPORTER_DATAWRITER_H_
+#define EXPORTER_DATAWRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <boost/thread.hpp>
+#include "Data.h"
+#include "IExporter.h"
+
+namespace raytracer {
+namespace exporter {
+
+	class DataWriter {
+
+		public:
+			/**
+			 * Start the writer thread. memoryBudget is the number of bytes
+			 * of results which may be queued or being written at any time;
+			 * a thread handing off a buffer waits until there is room for it.
+			 * The file is opened with the exporter right away; with resume,
+			 * the records are written after those already in the file.
+			 */
+			DataWriter(IExporter *exporter, const char *filepath, size_t memoryBudget, bool resume = false);
+			~DataWriter();
+
+			/**
+			 * Add a result to the buffer of the calling thread. Only takes a
+			 * lock when the buffer is full and handed off. A full buffer is
+			 * handed off once a result of another ray is added, so the
+			 * results of a ray, added one after another, end up in one batch.
+			 */
+			void add(const Data &dat);
+
+			/**
+			 * Hand off the buffers of all threads and wait until they are
+			 * written and flushed to the file. Only to be called while no
+			 * thread adds results.
+			 */
+			void flush();
+
+			/**
+			 * Hand off the buffers of all threads, write them, stop the writer
+			 * thread and close the file. Only to be called once no thread adds
+			 * results.
+			 */
+			void close();
+
+			size_t getBufferSize() const;
+			size_t getMemoryBudget() const;
+
+			/**
+			 * Number of hand-offs which had to wait for the writer to free
+			 * memory
+			 */
+			uint64_t getNumWaits() const;
+
+			/**
+			 * Records per thread buffer. Smaller budgets use smaller buffers,
+			 * so that a few of them fit in the queue.
+			 */
+			static constexpr size_t BUFFER_SIZE = 8192;
+
+		private:
+			DataWriter(DataWriter const&);			// Don't Implement
+			void operator = (DataWriter const&);	// Don't implement
+			std::vector<Data>* registerBuffer();
+			void submit(std::vector<Data> &buffer);
+			void write();
+
+			IExporter *_exporter;
+			const char *_filepath;
+			size_t _memoryBudget;
+			size_t _bufferSize;
+			// identifies the writer in the buffer lookup of each thread
+			uint64_t _id;
+
+			mutable boost::mutex _mutex;
+			boost::condition_variable _batchAvailable;
+			boost::condition_variable _spaceAvailable;
+			std::vector<std::unique_ptr<std::vector<Data> > > _buffers;
+			std::deque<std::vector<Data> > _queue;
+			size_t _usedBytes = 0;
+			uint64_t _numWaits = 0;
+			bool _closing = false;
+			boost::thread _thread;
+	};
+
+} /* namespace exporter */
+} /* namespace raytracer */
+
+#endif /* EXPORTER_DATAWRITER_H_ */
@@ -1,12 +1,16 @@
 //============================================================================
 // Name        : IExporter.h
 // Author      : Rian van Gijlswijk
-// Description : Interface for data export implementation
+// Description : Interface for data export implementation. Exporters are
+//				 sinks: a file is opened, written in batches of records and
+//				 closed, so that a dataset does not have to be collected
+//				 before it is exported.
 //============================================================================
 
 #ifndef IEXPORTER_H_
 #define IEXPORTER_H_
 
+#include <cstddef>
 #include <list>
 #include "Data.h"
 
@@ -17,7 +21,8 @@ namespace exporter {
 		Csv = 1,
 		Matlab = 2,
 		Vtk = 3,
-		Json = 4
+		Json = 4,
+		Binary = 5
 	};
 
 	class IExporter {
@@ -26,7 +31,56 @@ namespace exporter {
 			IExporter() {}
 			IExporter(const char *filepath);
 			virtual ~IExporter() {}
-			virtual void dump(const char *filepath, std::list<Data> dataset) = 0;
+
+			/**
+			 * Open the file and write its header
+			 */
+			virtual void open(const char *filepath) = 0;
+
+			/**
+			 * Write count records. The records are borrowed, they are not
+			 * used after write() returns.
+			 */
+			virtual void write(const Data *records, size_t count) = 0;
+
+			/**
+			 * Write the footer of the file and close it
+			 */
+			virtual void close() = 0;
+
+			/**
+			 * Whether files of this format can be continued with resume()
+			 */
+			virtual bool canResume() const {
+				return false;
+			}
+
+			/**
+			 * Open a file which was written up to a checkpoint, to write
+			 * more records after it. Returns false if the format can not be
+			 * continued, because it has a footer or is written on close.
+			 */
+			virtual bool resume(const char *) {
+				return false;
+			}
+
+			/**
+			 * Pass the records written so far on to the file, so that its
+			 * size covers them
+			 */
+			virtual void flush() {}
+
+			/**
+			 * Export a complete dataset to a file
+			 */
+			void dump(const char *filepath, const std::list<Data> &dataset) {
+
+				open(filepath);
+				for (const Data &d : dataset) {
+					write(&d, 1);
+				}
+				close();
+			}
 
 	};
 
@@ -41,55 +41,65 @@ namespace exporter {
 	 * 	},{...}]
 	 * }
 	 */
-	void JsonExporter::dump(const char *filepath, std::list<Data> dataset) {
+	void JsonExporter::open(const char *filepath) {
 
-		std::ofstream datafile;
-		datafile.open(filepath, std::fstream::app);
+		_file.open(filepath);
+		_rayInProcess = 0;
 
 		// construct beginning of file
-		datafile 	<< "{\n"
-					<< "\"rays\": [\n";
+		_file 	<< "{\n"
+				<< "\"rays\": [\n";
+	}
+
+	/**
+	 * A ray gets a new header whenever its records are interrupted by those
+	 * of another ray. The DataWriter keeps the records of a ray together, so
+	 * every ray is written once.
+	 */
+	void JsonExporter::write(const Data *records, size_t count) {
 
-		// file body
-		int rayInProcess = 0;
-		while (!dataset.empty()) {
-			Data item = dataset.front();
+		for (const Data *item = records; item < records + count; item++) {
 
 			// generate header for this item
-			if (item.rayNumber > rayInProcess) {
-				if (rayInProcess == 0) {
-					datafile << "{";
+			if (item->rayNumber != _rayInProcess) {
+				if (_rayInProcess == 0) {
+					_file << "{";
 				} else {
-					datafile << "]]},{";
+					_file << "]]},{";
 				}
-				rayInProcess = item.rayNumber;
-				datafile 	<< "\n\"header\": {\n"
-						<< "\"o_p\": " << std::setprecision(3) << item.omega_p << ",\n"
-						<< "\"t_0\": " << std::setprecision(4) << item.theta_0 << ",\n"
-						<< "\"f\": " << std::setprecision(1) << item.frequency << ",\n"
-						<< "\"bId\": " << std::setprecision(1) << item.beaconId << ",\n"
-						<< "\"a_0\": " << std::setprecision(4) << item.azimuth_0 << "\n"
+				_rayInProcess = item->rayNumber;
+				_file 	<< "\n\"header\": {\n"
+						<< "\"o_p\": " << std::setprecision(3) << item->omega_p << ",\n"
+						<< "\"t_0\": " << std::setprecision(4) << item->theta_0 << ",\n"
+						<< "\"f\": " << std::setprecision(1) << item->frequency << ",\n"
+						<< "\"bId\": " << std::setprecision(1) << item->beaconId << ",\n"
+						<< "\"a_0\": " << std::setprecision(4) << item->azimuth_0 << "\n"
 						<< "},\n\"data\":[[\n";
 			} else {
-				datafile << "],[";
+				_file << "],[";
 			}
 
 			// generate body for this item
-			datafile << std::fixed << std::setprecision(2) << item.x << ",\n"
-				<< std::setprecision(2) << item.y << ",\n"
-				<< std::setprecision(2) << item.z << ",\n"
-				<< std::setprecision(4) << item.n_e << ",\n"
-				<< std::setprecision(6) << item.mu_r_sqrt << ",\n"
-				<< std::setprecision(12) << item.signalPower << ",\n"
-				<< std::setprecision(10) << item.timeOfFlight << ",\n"
-				<< std::setprecision(1) << item.collisionType << "\n";
-			dataset.pop_front();
+			_file << std::fixed << std::setprecision(2) << item->x << ",\n"
+				<< std::setprecision(2) << item->y << ",\n"
+				<< std::setprecision(2) << item->z << ",\n"
+				<< std::setprecision(4) << item->n_e << ",\n"
+				<< std::setprecision(6) << item->mu_r_sqrt << ",\n"
+				<< std::setprecision(12) << item->signalPower << ",\n"
+				<< std::setprecision(10) << item->timeOfFlight << ",\n"
+				<< std::setprecision(1) << item->collisionType << "\n";
 		}
+	}
 
-		// construct end of file
-		datafile	<< "]]}]\n}";
+	void JsonExporter::close() {
 
-		datafile.close();
+		// construct end of file
+		if (_rayInProcess == 0) {
+			_file << "]\n}";
+		} else {
+			_file << "]]}]\n}";
+		}
+		_file.close();
 	}
 
 } /* namespace exporter */
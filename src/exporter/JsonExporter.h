@@ -8,6 +8,7 @@
 #ifndef EXPORTER_JSONEXPORTER_H_
 #define EXPORTER_JSONEXPORTER_H_
 
+#include <fstream>
 #include "IExporter.h"
 
 namespace raytracer {
@@ -19,7 +20,14 @@ class JsonExporter : public IExporter {
 		JsonExporter();
 		JsonExporter(const char *filepath);
 		~JsonExporter() {}
-		void dump(const char *filepath, std::list<Data> dataset);
+		void open(const char *filepath);
+		void write(const Data *records, size_t count);
+		void close();
+
+	private:
+		std::ofstream _file;
+		// number of the ray whose data is being written, 0 before the first
+		int _rayInProcess = 0;
 
 };
 
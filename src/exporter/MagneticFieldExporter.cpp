@@ -17,19 +17,24 @@ namespace exporter {
 		// TODO Auto-generated constructor stub
 	}
 
-	void MagneticFieldExporter::dump(const char *filepath, std::list<Data> dataset) {
-
-		std::ofstream data;
-		data.open(filepath);
-		while (!dataset.empty()) {
-			data << std::fixed << std::setprecision(1) << dataset.front().rayNumber << ","
-					<< std::setprecision(6) << dataset.front().n << ","
-					<< std::setprecision(3) << dataset.front().omega_p << ","
-					<< std::setprecision(1) << dataset.front().frequency << "\n";
-			dataset.pop_front();
+	void MagneticFieldExporter::open(const char *filepath) {
+
+		_file.open(filepath);
+	}
+
+	void MagneticFieldExporter::write(const Data *records, size_t count) {
+
+		for (const Data *d = records; d < records + count; d++) {
+			_file << std::fixed << std::setprecision(1) << d->rayNumber << ","
+					<< std::setprecision(6) << d->n << ","
+					<< std::setprecision(3) << d->omega_p << ","
+					<< std::setprecision(1) << d->frequency << "\n";
 		}
-		data.close();
+	}
+
+	void MagneticFieldExporter::close() {
 
+		_file.close();
 	}
 
 } /* namespace exporter */
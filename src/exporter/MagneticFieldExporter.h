@@ -7,6 +7,7 @@
 #ifndef MATLABEXPORTER_H_
 #define MATLABEXPORTER_H_
 
+#include <fstream>
 #include "IExporter.h"
 
 namespace raytracer {
@@ -18,7 +19,12 @@ class MagneticFieldExporter : public IExporter {
 		MagneticFieldExporter();
 		MagneticFieldExporter(const char *filepath);
 		~MagneticFieldExporter() {}
-		void dump(const char *filepath, std::list<Data> dataset);
+		void open(const char *filepath);
+		void write(const Data *records, size_t count);
+		void close();
+
+	private:
+		std::ofstream _file;
 
 };
 
@@ -34,30 +34,49 @@ namespace exporter {
 		}
 	}
 
-	void MatlabExporter::dump(const char *filepath, std::list<Data> dataset) {
-
-		std::ofstream data;
-		data.open(filepath, std::fstream::app);
-		while (!dataset.empty()) {
-			data << std::fixed << std::setprecision(1) << dataset.front().rayNumber << ","
-				<< std::setprecision(2) << dataset.front().x << ","
-				<< std::setprecision(2) << dataset.front().y << ","
-				<< std::setprecision(2) << dataset.front().z << ","
-				<< std::setprecision(3) << dataset.front().omega_p << ","
-				<< std::setprecision(4) << dataset.front().n_e << ","
-				<< std::setprecision(6) << dataset.front().mu_r_sqrt << ","
-				<< std::setprecision(4) << dataset.front().theta_0 << ","
-				<< std::setprecision(1) << dataset.front().frequency << ","
-				<< std::setprecision(12) << dataset.front().signalPower << ","
-				<< std::setprecision(10) << dataset.front().timeOfFlight << ","
-				<< std::setprecision(1) << dataset.front().collisionType << ","
-				<< std::setprecision(1) << dataset.front().beaconId << ","
-				<< std::setprecision(4) << dataset.front().azimuth_0 << ","
-				<< std::setprecision(4) << dataset.front().aoa << "\n";
-			dataset.pop_front();
+	/**
+	 * The records are appended, the file is created by the constructor
+	 */
+	void MatlabExporter::open(const char *filepath) {
+
+		_file.open(filepath, std::fstream::app);
+	}
+
+	void MatlabExporter::write(const Data *records, size_t count) {
+
+		for (const Data *d = records; d < records + count; d++) {
+			_file << std::fixed << std::setprecision(1) << d->rayNumber << ","
+				<< std::setprecision(2) << d->x << ","
+				<< std::setprecision(2) << d->y << ","
+				<< std::setprecision(2) << d->z << ","
+				<< std::setprecision(3) << d->omega_p << ","
+				<< std::setprecision(4) << d->n_e << ","
+				<< std::setprecision(6) << d->mu_r_sqrt << ","
+				<< std::setprecision(4) << d->theta_0 << ","
+				<< std::setprecision(1) << d->frequency << ","
+				<< std::setprecision(12) << d->signalPower << ","
+				<< std::setprecision(10) << d->timeOfFlight << ","
+				<< std::setprecision(1) << d->collisionType << ","
+				<< std::setprecision(1) << d->beaconId << ","
+				<< std::setprecision(4) << d->azimuth_0 << ","
+				<< std::setprecision(4) << d->aoa << "\n";
 		}
-		data.close();
+	}
+
+	void MatlabExporter::close() {
+
+		_file.close();
+	}
+
+	bool MatlabExporter::resume(const char *filepath) {
+
+		open(filepath);
+		return _file.is_open();
+	}
+
+	void MatlabExporter::flush() {
 
+		_file.flush();
 	}
 
 } /* namespace exporter */
@@ -7,6 +7,7 @@
 #ifndef MATLABEXPORTER_H_
 #define MATLABEXPORTER_H_
 
+#include <fstream>
 #include "IExporter.h"
 
 namespace raytracer {
@@ -18,7 +19,15 @@ class MatlabExporter : public IExporter {
 		MatlabExporter();
 		MatlabExporter(const char *filepath);
 		~MatlabExporter() {}
-		void dump(const char *filepath, std::list<Data> dataset);
+		void open(const char *filepath);
+		void write(const Data *records, size_t count);
+		void close();
+		bool canResume() const { return true; }
+		bool resume(const char *filepath);
+		void flush();
+
+	private:
+		std::ofstream _file;
 
 };
 
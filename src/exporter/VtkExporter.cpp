@@ -8,6 +8,7 @@
 #include <iostream>
 #include <fstream>
 #include <cmath>
+#include <cstdio>
 #include "VtkExporter.h"
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
@@ -34,32 +35,53 @@ namespace exporter {
 		}
 	}
 
-	void VtkExporter::dump(const char *filepath, std::list<Data> dataset) {
+	void VtkExporter::open(const char *filepath) {
 
-		std::ofstream data;
-		int datasetSize = dataset.size();
-		data.open(filepath);
-
-		int numRays = 0;
-		for (std::list<Data>::const_iterator it = dataset.begin(), end = dataset.end(); it != end; ++it) {
-			const Data &elem = *it;
-			if (numRays < elem.rayNumber) {
-				numRays = elem.rayNumber;
+		_filepath = filepath;
+		_points.open(_filepath + ".points");
+		_lines.open(_filepath + ".lines");
+		_numPoints = 0;
+		_numLines = 0;
+		_numRays = 0;
+		_rayInProcess = 0;
+	}
+
+	/**
+	 * Every point is connected to the previous point of its ray. The records
+	 * of a ray come one after another, as the DataWriter keeps them together.
+	 */
+	void VtkExporter::write(const Data *records, size_t count) {
+
+		for (const Data *elem = records; elem < records + count; elem++) {
+			_points << std::fixed << (int)round(elem->x) << " "
+								<< (int)round(elem->y) << " "
+								<< (int)round(elem->z) << std::endl;
+
+			if (elem->rayNumber == _rayInProcess) {
+				_lines << "2 " << _lastPoint << " " << _numPoints << std::endl;
+				_numLines++;
+			} else {
+				_rayInProcess = elem->rayNumber;
+				_numRays++;
 			}
+			_lastPoint = _numPoints;
+			_numPoints++;
 		}
-		std::vector<std::vector<Data>> mappedDataset(numRays, std::vector<Data>(0));
+	}
 
-		// sort data
-		for (Data &elem : dataset) {
-			int rayN = elem.rayNumber-1;
-			mappedDataset[rayN].push_back(elem);
-		}
+	void VtkExporter::close() {
+
+		_points.close();
+		_lines.close();
+
+		std::ofstream data;
+		data.open(_filepath.c_str());
 
 		// header
 		data << "# vtk DataFile Version 3.0" << std::endl;
 
 		// title
-		data << numRays << " Rays in vtk format"  << std::endl;
+		data << _numRays << " Rays in vtk format"  << std::endl;
 
 		// data type
 		data << "ASCII" << std::endl;
@@ -68,31 +90,22 @@ namespace exporter {
 		data << "DATASET POLYDATA" << std::endl;
 
 		// dataset attributes - points
-		data << "POINTS " << datasetSize << " float" << std::endl;
-		for (const auto &n : mappedDataset) {
-			for (const Data &elem : n) {
-				data << std::fixed << (int)round(elem.x) << " "
-									<< (int)round(elem.y) << " "
-									<< (int)round(elem.z) << std::endl;
-			}
+		data << "POINTS " << _numPoints << " float" << std::endl;
+		if (_numPoints > 0) {
+			std::ifstream points((_filepath + ".points").c_str());
+			data << points.rdbuf();
 		}
 
 		// dataset attributes - lines
-		data << std::endl << "LINES " << datasetSize-numRays << " " << (datasetSize-numRays)*3 << std::endl;
-		int lastCounter = 0;
-		for (const auto &n : mappedDataset) {
-			int i = 0;
-			for (const Data &elem : n) {
-				if (elem.x != n.back().x) {
-					data << "2 " << lastCounter+i << " " << lastCounter+i+1 << std::endl;
-				}
-				i++;
-			}
-			lastCounter += i;
+		data << std::endl << "LINES " << _numLines << " " << _numLines*3 << std::endl;
+		if (_numLines > 0) {
+			std::ifstream lines((_filepath + ".lines").c_str());
+			data << lines.rdbuf();
 		}
 
 		data.close();
-
+		std::remove((_filepath + ".points").c_str());
+		std::remove((_filepath + ".lines").c_str());
 	}
 
 } /* namespace exporter */
@@ -9,6 +9,8 @@
 #ifndef VtkEXPORTER_H_
 #define VtkEXPORTER_H_
 
+#include <fstream>
+#include <string>
 #include "IExporter.h"
 
 namespace raytracer {
@@ -21,7 +23,23 @@ class VtkExporter : public IExporter {
 		VtkExporter();
 		VtkExporter(const char *filepath);
 		~VtkExporter() {}
-		void dump(const char *filepath, std::list<Data> dataset);
+		void open(const char *filepath);
+		void write(const Data *records, size_t count);
+		void close();
+
+	private:
+		std::string _filepath;
+		// points and lines are streamed to temporary files, as the header
+		// of each section holds its size
+		std::ofstream _points;
+		std::ofstream _lines;
+		int _numPoints = 0;
+		int _numLines = 0;
+		int _numRays = 0;
+		// number of the ray whose data is being written, 0 before the first
+		int _rayInProcess = 0;
+		// index of the last point of the ray in process
+		int _lastPoint = 0;
 
 };
 
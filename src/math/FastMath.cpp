@@ -0,0 +1,135 @@
+//============================================================================
+// Name        : FastMath.cpp
+// Author      : Rian van Gijlswijk
+// Description : Exponential and logarithm of many values at once
+//============================================================================
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include "FastMath.h"
+
+namespace raytracer {
+namespace math {
+
+	namespace {
+
+		const double LOG2E = 1.4426950408889634;
+		const double SQRT2 = 1.4142135623730951;
+
+		// ln(2) split in a part with trailing zero bits, so that k * LN2_HI is
+		// exact for the exponents k of a double, and the remainder
+		const double LN2_HI = 6.93147180369123816490e-01;
+		const double LN2_LO = 1.90821492927058770002e-10;
+
+		// adding 1.5 * 2^52 rounds a double to an integer, which then sits
+		// in the low bits of the mantissa
+		const double ROUNDING_SHIFT = 6755399441055744.0;
+
+		// 2^52 with the exponent bits of another double OR'ed into its mantissa
+		const uint64_t EXPONENT_SHIFT_BITS = 0x4330000000000000ULL;
+		const double EXPONENT_SHIFT = 4503599627370496.0;
+
+		const uint64_t MANTISSA_MASK = 0x000FFFFFFFFFFFFFULL;
+		const uint64_t ONE_BITS = 0x3FF0000000000000ULL;
+
+		const double INF = std::numeric_limits<double>::infinity();
+		const double NOT_A_NUMBER = std::numeric_limits<double>::quiet_NaN();
+
+		inline uint64_t toBits(double value) {
+
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		inline double fromBits(uint64_t bits) {
+
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+	}
+
+	/**
+	 * e^x = 2^k * e^r with k = round(x / ln(2)) and |r| <= ln(2)/2. e^r is
+	 * the Taylor series up to r^12, whose truncation error is below 2e-16.
+	 * 2^k is applied by adding k to the exponent bits of e^r.
+	 */
+	void FastMath::exp(const double *x, double *result, int count) {
+
+		for (int i = 0; i < count; i++) {
+			double value = x[i];
+			double clamped = value < EXP_MIN_ARGUMENT ? EXP_MIN_ARGUMENT : value;
+			clamped = clamped > EXP_MAX_ARGUMENT ? EXP_MAX_ARGUMENT : clamped;
+
+			double shifted = clamped * LOG2E + ROUNDING_SHIFT;
+			double k = shifted - ROUNDING_SHIFT;
+			double r = clamped - k * LN2_HI - k * LN2_LO;
+
+			double p = 1.0 / 479001600;
+			p = p * r + 1.0 / 39916800;
+			p = p * r + 1.0 / 3628800;
+			p = p * r + 1.0 / 362880;
+			p = p * r + 1.0 / 40320;
+			p = p * r + 1.0 / 5040;
+			p = p * r + 1.0 / 720;
+			p = p * r + 1.0 / 120;
+			p = p * r + 1.0 / 24;
+			p = p * r + 1.0 / 6;
+			p = p * r + 0.5;
+			p = p * r + 1.0;
+			p = p * r + 1.0;
+
+			double scaled = fromBits(toBits(p) + (toBits(shifted) << 52));
+
+			double bounded = value > EXP_MAX_ARGUMENT ? INF : scaled;
+			bounded = value < EXP_MIN_ARGUMENT ? 0 : bounded;
+			result[i] = value != value ? value : bounded;
+		}
+	}
+
+	/**
+	 * log(x) = e * ln(2) + log(m) with x = 2^e * m and m in [sqrt(2)/2, sqrt(2)].
+	 * log(m) = 2 * atanh(s) with s = (m - 1) / (m + 1), |s| < 0.172, is the
+	 * series up to s^19, whose truncation error is below 1e-16 relative to log(m).
+	 */
+	void FastMath::log(const double *x, double *result, int count) {
+
+		for (int i = 0; i < count; i++) {
+			double value = x[i];
+			uint64_t bits = toBits(value);
+
+			double m = fromBits((bits & MANTISSA_MASK) | ONE_BITS);
+			double e = fromBits((bits >> 52) | EXPONENT_SHIFT_BITS) - EXPONENT_SHIFT - 1023;
+			double halved = m * 0.5;
+			double incremented = e + 1;
+			bool large = m > SQRT2;
+			m = large ? halved : m;
+			e = large ? incremented : e;
+
+			double f = m - 1;
+			double s = f / (2 + f);
+			double s2 = s * s;
+
+			double p = 2.0 / 19;
+			p = p * s2 + 2.0 / 17;
+			p = p * s2 + 2.0 / 15;
+			p = p * s2 + 2.0 / 13;
+			p = p * s2 + 2.0 / 11;
+			p = p * s2 + 2.0 / 9;
+			p = p * s2 + 2.0 / 7;
+			p = p * s2 + 2.0 / 5;
+			p = p * s2 + 2.0 / 3;
+			p = p * s2;
+
+			double logarithm = e * LN2_HI + (e * LN2_LO + (2 * s + s * p));
+
+			double special = value == INF ? INF : NOT_A_NUMBER;
+			special = value == 0 ? -INF : special;
+			result[i] = value > 0 && value < INF ? logarithm : special;
+		}
+	}
+
+} /* namespace math */
+} /* namespace raytracer */
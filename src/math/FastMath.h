@@ -0,0 +1,43 @@
+//============================================================================
+// Name        : FastMath.h
+// Author      : Rian van Gijlswijk
+// Description : Exponential and logarithm of many values at once. The loops
+//				 only use arithmetic, bit operations and selects, so that the
+//				 compiler can vectorize them, unlike calls to libm.
+//============================================================================
+
+#ifndef MATH_FASTMATH_H_
+#define MATH_FASTMATH_H_
+
+namespace raytracer {
+namespace math {
+
+	class FastMath {
+
+		public:
+			/**
+			 * e^x for count values. The relative error is below EXP_MAX_ERROR
+			 * for x in [EXP_MIN_ARGUMENT, EXP_MAX_ARGUMENT]. Smaller values give
+			 * 0, larger values give infinity and NaN gives NaN.
+			 * result may be the same array as x.
+			 */
+			static void exp(const double *x, double *result, int count);
+
+			/**
+			 * Natural logarithm for count values. For positive normal x, the
+			 * error is below LOG_MAX_ERROR * max(1, |log(x)|). 0 gives -infinity,
+			 * infinity gives infinity, negative values and NaN give NaN.
+			 * Subnormal x are not supported. result may be the same array as x.
+			 */
+			static void log(const double *x, double *result, int count);
+
+			static constexpr double EXP_MIN_ARGUMENT = -708.0;
+			static constexpr double EXP_MAX_ARGUMENT = 709.0;
+			static constexpr double EXP_MAX_ERROR = 1e-15;
+			static constexpr double LOG_MAX_ERROR = 1e-15;
+	};
+
+} /* namespace math */
+} /* namespace raytracer */
+
+#endif /* MATH_FASTMATH_H_ */
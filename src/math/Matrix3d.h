@@ -1,12 +1,14 @@
 //============================================================================
 // Name        : Matrix3d.h
 // Author      : Rian van Gijlswijk
-// Description : A 3x3 matrix representation
+// Description : A 3x3 matrix representation. All operations are defined
+//				 inline, like those of Vector3d.
 //============================================================================
 
 #ifndef MATH_MATRIX3D_H_
 #define MATH_MATRIX3D_H_
 
+#include <cmath>
 #include "Vector3d.h"
 
 namespace raytracer {
@@ -15,43 +17,123 @@ namespace math {
 	class Matrix3d {
 
 		public:
-			Matrix3d();
-			Matrix3d(Vector3d xPos, Vector3d yPos, Vector3d zPos);
+			Matrix3d() {}
+
+			Matrix3d(const Vector3d &col1, const Vector3d &col2, const Vector3d &col3) {
+
+				// row, col
+				_matrix[0][0] = col1.x;
+				_matrix[0][1] = col1.y;
+				_matrix[0][2] = col1.z;
+				_matrix[1][0] = col2.x;
+				_matrix[1][1] = col2.y;
+				_matrix[1][2] = col2.z;
+				_matrix[2][0] = col3.x;
+				_matrix[2][1] = col3.y;
+				_matrix[2][2] = col3.z;
+			}
 
 			/**
 			 * Create a rotation matrix around a certain axis, following the right-hand rule
 			 * @param double angle: the angle in radians
 			 */
-			static Matrix3d createRotationMatrix(double angle, int axis);
+			static Matrix3d createRotationMatrix(double angle, int axis) {
+
+				Matrix3d m;
+				double c = cos(angle);
+				double s = sin(angle);
+
+				if (axis == ROTATION_X) {
+					m.set(0,0,1);
+					m.set(0,1,0);
+					m.set(0,2,0);
+					m.set(1,0,0);
+					m.set(1,1,c);
+					m.set(1,2,-s);
+					m.set(2,0,0);
+					m.set(2,1,s);
+					m.set(2,2,c);
+				} else if (axis == ROTATION_Y) {
+					m.set(0,0,c);
+					m.set(0,1,0);
+					m.set(0,2,s);
+					m.set(1,0,0);
+					m.set(1,1,1);
+					m.set(1,2,0);
+					m.set(2,0,-s);
+					m.set(2,1,0);
+					m.set(2,2,c);
+				} else if(axis == ROTATION_Z) {
+					m.set(0,0,c);
+					m.set(0,1,-s);
+					m.set(0,2,0);
+					m.set(1,0,s);
+					m.set(1,1,c);
+					m.set(1,2,0);
+					m.set(2,0,0);
+					m.set(2,1,0);
+					m.set(2,2,1);
+				}
 
-			static int	ROTATION_X,
-						ROTATION_Y,
-						ROTATION_Z;
+				return m;
+			}
+
+			static const int	ROTATION_X = 0,
+								ROTATION_Y = 1,
+								ROTATION_Z = 2;
 
 			/**
 			 * Get an individual element in the matrix
 			 */
-			double get(int i, int j);
+			double get(int i, int j) const {
+
+				return _matrix[i][j];
+			}
 
 			/**
 			 * Set an individual element in the matrix
 			 */
-			void set(int i, int j, double value);
+			void set(int i, int j, double value) {
+
+				_matrix[i][j] = value;
+			}
 
 			/**
 			 * Perform a full matrix multiplication.
 			 * @param Matrix3d m2: the RHS matrix
 			 */
-			Matrix3d multiply(Matrix3d m2);
-			Matrix3d operator*(Matrix3d m2) {
+			Matrix3d multiply(const Matrix3d &m2) const {
+
+				Matrix3d multipliedMatrix;
+
+				for(int i = 0; i < 3; i++) {
+					for (int j = 0; j < 3; j++) {
+						double val = 0;
+						for (int k = 0; k < 3; k++) {
+							val += get(i,k) * m2.get(k,j);
+						}
+						multipliedMatrix.set(i, j, val);
+					}
+				}
+
+				return multipliedMatrix;
+			}
+			Matrix3d operator*(const Matrix3d &m2) const {
+
 				return multiply(m2);
 			}
 
 			/**
 			 * Multiply this matrix with a vector
 			 */
-			Vector3d multiply(Vector3d vin);
-			Vector3d operator*(Vector3d vin) {
+			Vector3d multiply(const Vector3d &vin) const {
+
+				return Vector3d(vin.x * get(0,0) + vin.y * get(0,1) + vin.z * get(0,2),
+						vin.x * get(1,0) + vin.y * get(1,1) + vin.z * get(1,2),
+						vin.x * get(2,0) + vin.y * get(2,1) + vin.z * get(2,2));
+			}
+			Vector3d operator*(const Vector3d &vin) const {
+
 				return multiply(vin);
 			}
 
@@ -1,12 +1,15 @@
 //============================================================================
 // Name        : Vector3d.h
 // Author      : Rian van Gijlswijk
-// Description : Represents a vector in 3D space
+// Description : Represents a vector in 3D space. All operations are defined
+//				 inline, so that the compiler can inline and vectorize them
+//				 in every translation unit which uses them.
 //============================================================================
 
 #ifndef VECTOR3D_H_
 #define VECTOR3D_H_
 
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 
@@ -16,10 +19,10 @@ namespace math {
 class Vector3d {
 
 	public:
-		Vector3d();
-		Vector3d(double xPos, double yPos, double zPos);
+		constexpr Vector3d() : x(0.0), y(0.0), z(0.0) {}
+		constexpr Vector3d(double xPos, double yPos, double zPos) : x(xPos), y(yPos), z(zPos) {}
 
-		static Vector3d EQUINOX,
+		static const Vector3d EQUINOX,
 						SUBSOLAR,
 						POLAR,
 						CENTER;
@@ -28,73 +31,120 @@ class Vector3d {
 		/**
 		 * Magnitude of the vector
 		 */
-		double magnitude();
+		double magnitude() const {
+
+			return sqrt(x * x + y * y + z * z);
+		}
 
 		/**
-		 * Unit vector representation
+		 * Unit vector representation, with a single sqrt
 		 */
-		Vector3d norm();
+		Vector3d norm() const {
+
+			double m = magnitude();
+			return Vector3d(x / m, y / m, z / m);
+		}
 
 		/**
 		 * Euclidian distance between two 3D-points. The vectors are in this
 		 * case regarded as points in 3D space
 		 */
-		double distance(Vector3d v2);
+		double distance(const Vector3d &v2) const {
+
+			double dx = x - v2.x, dy = y - v2.y, dz = z - v2.z;
+			return sqrt(dx * dx + dy * dy + dz * dz);
+		}
 
 		/**
 		 * Cross product between this vector and another vector v2
 		 *
 		 * vector result = s1i + s2j + s3k = u × v
 		 */
-		Vector3d cross(Vector3d v2);
+		constexpr Vector3d cross(const Vector3d &v2) const {
+
+			return Vector3d(y * v2.z - z * v2.y, z * v2.x - x * v2.z, x * v2.y - y * v2.x);
+		}
 
 		/**
 		 * Return the angle theta between two vectors A and B where
 		 * theta = acos(A*B / (A.magnitude()*B.magnitude()))
 		 */
-		double angle(Vector3d v2);
+		double angle(const Vector3d &v2) const {
+
+			return acos(cosine(v2));
+		}
+
+		/**
+		 * Return the cosine of the angle theta between two vectors A and B,
+		 * cos(theta) = A*B / (A.magnitude()*B.magnitude()), without
+		 * the acos of angle()
+		 */
+		double cosine(const Vector3d &v2) const {
+
+			return dot(v2) / (magnitude() * v2.magnitude());
+		}
 
 		/**
 		 * Dot product between this vector and another vector v2
 		 */
-		double dot(Vector3d v2);
-		double operator*(Vector3d v2) {
+		constexpr double dot(const Vector3d &v2) const {
+
+			return x * v2.x + y * v2.y + z * v2.z;
+		}
+		constexpr double operator*(const Vector3d &v2) const {
+
 			return dot(v2);
 		}
 
 		/**
 		 * Multiply this vector with a constant value
 		 */
-		Vector3d multiply(double t);
-		Vector3d operator*(double t) {
+		constexpr Vector3d multiply(double t) const {
+
+			return Vector3d(x * t, y * t, z * t);
+		}
+		constexpr Vector3d operator*(double t) const {
+
 			return multiply(t);
 		}
 
 		/**
 		 * Divide this vector by a constant value
 		 */
-		Vector3d divide(double t);
-		Vector3d operator/(double t) {
+		constexpr Vector3d divide(double t) const {
+
+			return Vector3d(x / t, y / t, z / t);
+		}
+		constexpr Vector3d operator/(double t) const {
+
 			return divide(t);
 		}
 
 		/**
 		 * Add vector v2 to this vector
 		 */
-		Vector3d add(Vector3d v2);
-		Vector3d operator+(Vector3d v2) {
+		constexpr Vector3d add(const Vector3d &v2) const {
+
+			return Vector3d(x + v2.x, y + v2.y, z + v2.z);
+		}
+		constexpr Vector3d operator+(const Vector3d &v2) const {
+
 			return add(v2);
 		}
 
 		/**
 		 * Substract vector v2 from this vector
 		 */
-		Vector3d substract(Vector3d v2);
-		Vector3d operator-(Vector3d v2) {
+		constexpr Vector3d substract(const Vector3d &v2) const {
+
+			return Vector3d(x - v2.x, y - v2.y, z - v2.z);
+		}
+		constexpr Vector3d operator-(const Vector3d &v2) const {
+
 			return substract(v2);
 		}
 
-		bool operator!=(const Vector3d rhs) {
+		constexpr bool operator!=(const Vector3d &rhs) const {
 
 			return x != rhs.x || y != rhs.y || z != rhs.z;
 		}
@@ -103,7 +153,6 @@ class Vector3d {
 
 			return strm << std::fixed << std::setprecision(4) << "V3D (" << v.x << "," << v.y << "," << v.z << ")";
 		}
-
 };
 
 } /* namespace math */
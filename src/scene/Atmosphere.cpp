@@ -93,7 +93,7 @@ namespace scene {
 		double yAvg = (mesh3d.centerpoint.y + mesh3d.centerpoint.y)/2;
 		double zAvg = (mesh3d.centerpoint.z + mesh3d.centerpoint.z)/2;
 
-		return sqrt(pow(xAvg, 2) + pow(yAvg, 2) + pow(zAvg, 2)) - Application::getInstance().getCelestialConfig().getInt("radius");
+		return sqrt(pow(xAvg, 2) + pow(yAvg, 2) + pow(zAvg, 2)) - Application::getInstance().getSimulationContext().radius;
 	}
 
 	/**
@@ -57,7 +57,7 @@ namespace scene {
 		if (altitude < 1) {
 
 			altitude = sqrt(pow(mesh3d.centerpoint.x, 2) + pow(mesh3d.centerpoint.y, 2) + pow(mesh3d.centerpoint.z, 2))
-					- core::Application::getInstance().getCelestialConfig().getInt("radius");
+					- core::Application::getInstance().getSimulationContext().radius;
 		}
 	}
 	double Geometry::getAltitude() {
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include "Ionosphere.h"
 #include "GeometryType.h"
@@ -17,6 +18,7 @@
 #include "../math/NormalDistribution.h"
 #include "../math/Constants.h"
 #include "../math/ComplexNumberHelper.h"
+#include "../math/FastMath.h"
 
 namespace raytracer {
 namespace scene {
@@ -25,6 +27,11 @@ namespace scene {
 	using namespace exporter;
 	using namespace core;
 
+	const double Ionosphere::COS_HALF_PI = cos(Constants::PI / 2);
+	const double Ionosphere::SIN_HALF_PI = sin(Constants::PI / 2);
+	const double Ionosphere::COS_PI = cos(Constants::PI);
+	const double Ionosphere::SIN_PI = sin(Constants::PI);
+
 	Ionosphere::Ionosphere() : Geometry() {
 
 		type = GeometryType::ionosphere;
@@ -40,6 +47,15 @@ namespace scene {
 		type = GeometryType::ionosphere;
 	}
 
+	Ionosphere::Ionosphere(const IonosphereLayer &layer) : Geometry(layer.normal, layer.centerpoint) {
+
+		type = GeometryType::ionosphere;
+		mesh3d.size = layer.size;
+		layerHeight = layer.layerHeight;
+		_electronNumberDensity = layer.electronNumberDensity;
+		_peakElectronDensity = layer.peakElectronDensity;
+	}
+
 	/**
 	 * Precalculate fixed values for this ionospheric layer. Assume static ionosphere as the
 	 * time periods that we're interested in are an order of magnitude lower than the processes
@@ -51,36 +67,106 @@ namespace scene {
 	}
 
 	/**
-	 * Interaction between ray and ionospheric layer
+	 * Interaction between ray and ionospheric layer. Without magnetic field,
+	 * the plasma frequency, refractive index and incidence cosine are derived
+	 * once and shared by the wave behaviour, the new direction, the
+	 * attenuation, the delays and the export. The result is that of
+	 * determineWaveBehaviour(), reflect() or refract(), attenuate(),
+	 * rangeDelay(), phaseAdvance(), timeDelay() and exportData() in sequence,
+	 * which are still used in a magnetized ionosphere.
 	 */
 	void Ionosphere::interact(Ray *r, Vector3d &hitpos) {
 
+		if (getMagneticFieldStrengthFromConfig() > 0) {
+			interact<true>(r, hitpos);
+		} else {
+			interact<false>(r, hitpos);
+		}
+	}
+
+	template <bool MagneticField>
+	void Ionosphere::interact(Ray *r, Vector3d &hitpos) {
+
 		BOOST_LOG_TRIVIAL(debug) << "Interact with ionosphere at alt " << r->altitude;
 		altitude = r->altitude;
 
 		setup();
 
-		int waveBehaviour = determineWaveBehaviour(r);
-
-		if (waveBehaviour == Ray::wave_reflection) {
-			reflect(r);
-		} else if (waveBehaviour == Ray::wave_refraction) {
-			refract(r);
+		if (MagneticField) {
+			int waveBehaviour = determineWaveBehaviour(r);
+
+			if (waveBehaviour == Ray::wave_reflection) {
+				reflect(r);
+			} else if (waveBehaviour == Ray::wave_refraction) {
+				refract(r);
+			}
+			r->o = hitpos;
+
+			attenuate(r);
+			rangeDelay(r);
+			phaseAdvance(r);
+			timeDelay(r);
+			exportData(r);
+			return;
 		}
-		r->o = hitpos;
 
-		attenuate(r);
-		rangeDelay(r);
-		phaseAdvance(r);
-		timeDelay(r);
+		double angularFrequency = 2 * Constants::PI * r->frequency;
+		double plasmaFrequencySquared = _electronNumberDensity * pow(Constants::ELEMENTARY_CHARGE, 2)
+				/ (Constants::ELECTRON_MASS * Constants::PERMITTIVITY_VACUUM);
+		double X = plasmaFrequencySquared / (angularFrequency * angularFrequency);
+		double Z = _collisionFrequency / angularFrequency;
+		double refractiveIndex = sqrt(1 - X);
+		double previousRefractiveIndex = r->previousRefractiveIndex;
+
+		Vector3d normal = mesh3d.normal;
+		double normalMagnitude = normal.magnitude();
+		double cosIncidence = std::abs(r->d * normal) / (r->d.magnitude() * normalMagnitude);
+		double sinIncidence = sqrt(1 - cosIncidence * cosIncidence);
+		// determineWaveBehaviour() reduces incident angles above Constants::PI/2
+		double sinReducedIncidence = sinIncidence;
+		if (cosIncidence < COS_HALF_PI) {
+			sinReducedIncidence = sinIncidence * COS_HALF_PI - cosIncidence * SIN_HALF_PI;
+		}
 
-		if (Application::getInstance().includeMagneticFieldEffects()) {
+		// the incident angle is at least the critical angle when its sine is
+		// at least n / n_previous, see determineWaveBehaviour()
+		if (X > 1 || (previousRefractiveIndex > refractiveIndex
+				&& sinReducedIncidence >= refractiveIndex / previousRefractiveIndex)) {
+			r->behaviour = Ray::wave_reflection;
+			double cosine = r->d.y > 0 ? cosIncidence : COS_PI * cosIncidence + SIN_PI * sinIncidence;
+			r->d = (r->d - normal * 2 * cosine).norm();
+		} else {
+			r->behaviour = Ray::wave_refraction;
+			double ratio = previousRefractiveIndex / refractiveIndex;
+			double coefficient = ratio * cosIncidence - sqrt(1 - ratio * ratio * (1 - cosIncidence * cosIncidence));
+			if (r->d.y > 0)
+				r->d = (r->d * ratio - normal * coefficient).norm();
+			else
+				r->d = (r->d * ratio + normal * coefficient).norm();
+			r->previousRefractiveIndex = refractiveIndex;
+		}
+		r->o = hitpos;
 
+		// path length through the layer, see attenuate()
+		double cosRefraction = (normal * r->d) / (normalMagnitude * r->d.magnitude());
+		if (cosRefraction < COS_HALF_PI) {
+			cosRefraction = cosRefraction * COS_HALF_PI + sqrt(1 - cosRefraction * cosRefraction) * SIN_HALF_PI;
 		}
+		r->signalPower += -4.6e-5 * (_electronNumberDensity * Z / (angularFrequency * (1 + Z * Z)))
+				* layerHeight * cosRefraction;
 
-		exportData(r);
+		double TEC = getTEC();
+		double frequencySquared = r->frequency * r->frequency;
+		r->rangeDelay += 0.403 * TEC / frequencySquared;
+		r->phaseAdvance += (8.44e-7 / r->frequency) * TEC;
+		r->timeDelay += (1.34e-7 / frequencySquared) * TEC;
+
+		exportData(r, sqrt(plasmaFrequencySquared));
 	}
 
+	template void Ionosphere::interact<true>(Ray *r, Vector3d &hitpos);
+	template void Ionosphere::interact<false>(Ray *r, Vector3d &hitpos);
+
 	/**
 	 *
 	 */
@@ -89,15 +175,14 @@ namespace scene {
 		double refractiveIndex = 0;
 
 		// load magnetic field parameters
-		Json::Value magFields = Application::getInstance().getApplicationConfig()
-									.getArray("magneticFields");
-		double magneticFieldStrength = getMagneticFieldStrengthFromConfig();
+		const SimulationContext &context = Application::getInstance().getSimulationContext();
+		double magneticFieldStrength = context.getMagneticFieldStrength();
 
 		// calculate the nonlinear refractive index in a magnetized environment
 		if (magneticFieldStrength > 0) {
 			BOOST_LOG_TRIVIAL(debug) << "Retrieving refraction for magnetized ionosphere";
 			// todo: calculate correct angle to magnetic field
-			Vector3d k = Config::getVector3dFromObject(magFields[0].get("direction", ""));
+			Vector3d k = context.magneticFields[0].direction;
 			double angleToMagfield = 0;//acos(r->d.dot(k));
 			// NONLINEAR solver: iterate the part below
 			// todo: implement nonlinear solver iterator
@@ -108,10 +193,10 @@ namespace scene {
 		} else {
 			refractiveIndex = sqrt(getRefractiveIndexSquaredSimple(r, getPlasmaFrequency()));
 		}
-		double theta_i = getIncidentAngle(r);
+		double cosIncidence = getIncidentCosine(r);
 
 		double ratio = r->previousRefractiveIndex/refractiveIndex;
-		double coefficient = ratio * cos(theta_i) - sqrt(1 - pow(ratio, 2) * (1 - pow(cos(theta_i), 2)));
+		double coefficient = ratio * cosIncidence - sqrt(1 - pow(ratio, 2) * (1 - pow(cosIncidence, 2)));
 		Vector3d newR = Vector3d();
 
 		if (r->d.y > 0)
@@ -121,7 +206,7 @@ namespace scene {
 
 //		BOOST_LOG_TRIVIAL(debug) << std::fixed << "n1: " << r->previousRefractiveIndex << ", n2: " << refractiveIndex;
 //		BOOST_LOG_TRIVIAL(debug) << "REFRACT Alt: " << std::setprecision(0) << getAltitude() << "\tr.d_i: " << r->d << "\tr.d_r: " << newR;
-//		BOOST_LOG_TRIVIAL(debug) << "N: " << mesh3d.normal << "\tn1/n2: " << ratio << "\ttheta_i: " << theta_i*180/Constants::PI << "\ttheta_r: " << newR.angle(mesh3d.normal) * 180 / Constants::PI;
+//		BOOST_LOG_TRIVIAL(debug) << "N: " << mesh3d.normal << "\tn1/n2: " << ratio << "\ttheta_i: " << acos(cosIncidence)*180/Constants::PI << "\ttheta_r: " << newR.angle(mesh3d.normal) * 180 / Constants::PI;
 
 		r->d = newR.norm();
 		r->previousRefractiveIndex = refractiveIndex;
@@ -133,16 +218,17 @@ namespace scene {
 	void Ionosphere::reflect(Ray *r) {
 
 		double refractiveIndex = getRefractiveIndex(r, Ionosphere::REFRACTION_SIMPLE);
-		double theta_i = getIncidentAngle(r);
+		double cosIncidence = getIncidentCosine(r);
 
 		Vector3d newR = Vector3d();
 
+		// cos(Constants::PI - theta_i), expanded
 		if (r->d.y > 0)
-			newR = r->d - mesh3d.normal * 2 * cos(theta_i);
+			newR = r->d - mesh3d.normal * 2 * cosIncidence;
 		else
-			newR = r->d - mesh3d.normal * 2 * cos(Constants::PI - theta_i);
+			newR = r->d - mesh3d.normal * 2 * (COS_PI * cosIncidence + SIN_PI * sqrt(1 - pow(cosIncidence, 2)));
 
-		BOOST_LOG_TRIVIAL(debug) << std::fixed << "REFLECT Alt: " << std::setprecision(0) << getAltitude() << "\tr.d_i: " << r->d << "\tr.d_r: " << newR << "\tN: " << mesh3d.normal << "\ttheta_i: " << theta_i;
+		BOOST_LOG_TRIVIAL(debug) << std::fixed << "REFLECT Alt: " << std::setprecision(0) << getAltitude() << "\tr.d_i: " << r->d << "\tr.d_r: " << newR << "\tN: " << mesh3d.normal << "\ttheta_i: " << acos(cosIncidence);
 
 		r->d = newR.norm();
 		//r->previousRefractiveIndex = refractiveIndex;
@@ -160,11 +246,13 @@ namespace scene {
 	 */
 	void Ionosphere::attenuate(Ray *r) {
 
-		double theta_r = getMesh().normal.angle(r->d);
-		if (theta_r > Constants::PI/2) {
-			theta_r -= Constants::PI/2;
+		// angles theta_r above Constants::PI/2 are reduced by Constants::PI/2,
+		// cos(theta_r - Constants::PI/2) is expanded
+		double cosRefraction = getMesh().normal.cosine(r->d);
+		if (cosRefraction < COS_HALF_PI) {
+			cosRefraction = cosRefraction * COS_HALF_PI + sqrt(1 - pow(cosRefraction, 2)) * SIN_HALF_PI;
 		}
-		double magnitude = layerHeight * cos(theta_r);
+		double magnitude = layerHeight * cosRefraction;
 		double collisionFrequency = getCollisionFrequency();
 
 		double loss = -4.6e-5
@@ -206,6 +294,11 @@ namespace scene {
 
 	void Ionosphere::exportData(Ray *r) {
 
+		exportData(r, getPlasmaFrequency());
+	}
+
+	void Ionosphere::exportData(Ray *r, double plasmaFrequency) {
+
 		Data d;
 		d.x = r->o.x;
 		d.y = r->o.y;
@@ -213,7 +306,7 @@ namespace scene {
 		d.rayNumber = r->rayNumber;
 		d.mu_r_sqrt = pow(r->previousRefractiveIndex, 2);
 		d.n_e = getElectronNumberDensity();
-		d.omega_p = getPlasmaFrequency();
+		d.omega_p = plasmaFrequency;
 		d.theta_0 = r->originalAngle;
 		d.frequency = r->frequency;
 		d.signalPower = r->signalPower;
@@ -268,6 +361,11 @@ namespace scene {
 		_electronNumberDensity = n_e;
 	}
 
+	void Ionosphere::setPeakElectronDensity(double n_e) {
+
+		_peakElectronDensity = n_e;
+	}
+
 	/**
 	 * Add electrons with a certain density to the electron density already available in this layer.
 	 * This approach allows the superposition of multiple ionospheric profiles into one layer.
@@ -276,21 +374,98 @@ namespace scene {
 	void Ionosphere::superimposeElectronNumberDensity(double peakDensity, double peakAltitude, double neutralScaleHeight) {
 
 		double SZA = mesh3d.normal.angle(Vector3d::SUBSOLAR);
-		double correctedPeakAltitude = peakAltitude + 1e4 * log(1/cos(SZA));
-		double normalizedHeight = (getAltitude() - correctedPeakAltitude) / neutralScaleHeight;
 
 		if (peakDensity > _peakElectronDensity) {
 			_peakElectronDensity = peakDensity;
 		}
 
-		double electronNumberDensity = peakDensity *
-				exp(0.5f * (1.0f - normalizedHeight - (1.0 / cos(SZA)) * exp(-normalizedHeight) ));
-
-		_electronNumberDensity += electronNumberDensity;
+		_electronNumberDensity += getChapmanElectronNumberDensity(peakDensity, peakAltitude,
+				neutralScaleHeight, getAltitude(), SZA);
 
 		BOOST_LOG_TRIVIAL(debug) << "Set n_e at alt=" << altitude << " to " << _electronNumberDensity;
 	}
 
+	/**
+	 * Electron number density of a single chapman layer at a given altitude
+	 * and solar zenith angle
+	 * @unit: particles m^-3
+	 */
+	double Ionosphere::getChapmanElectronNumberDensity(double peakDensity, double peakAltitude,
+			double neutralScaleHeight, double altitude, double SZA) {
+
+		double correctedPeakAltitude = peakAltitude + 1e4 * log(1/cos(SZA));
+		double normalizedHeight = (altitude - correctedPeakAltitude) / neutralScaleHeight;
+
+		return peakDensity *
+				exp(0.5 * (1.0 - normalizedHeight - (1.0 / cos(SZA)) * exp(-normalizedHeight) ));
+	}
+
+	/**
+	 * Electron number density of a single chapman layer and its derivatives.
+	 * With z the normalized height and A = sec(SZA) * exp(-z):
+	 * dN/dh = N * (A - 1) / 2H
+	 * dN/dcos(SZA) = -N * sec(SZA) * (1e4/H - A * (1 + 1e4/H)) / 2
+	 * @unit: particles m^-3
+	 */
+	double Ionosphere::getChapmanElectronNumberDensity(double peakDensity, double peakAltitude,
+			double neutralScaleHeight, double altitude, double SZA,
+			double &derivativeAltitude, double &derivativeCosSZA) {
+
+		double secant = 1.0 / cos(SZA);
+		double correctedPeakAltitude = peakAltitude + 1e4 * log(secant);
+		double normalizedHeight = (altitude - correctedPeakAltitude) / neutralScaleHeight;
+		double absorption = secant * exp(-normalizedHeight);
+		double electronNumberDensity = peakDensity * exp(0.5 * (1.0 - normalizedHeight - absorption));
+		double peakShift = 1e4 / neutralScaleHeight;
+
+		derivativeAltitude = 0.5 * electronNumberDensity * (absorption - 1.0) / neutralScaleHeight;
+		derivativeCosSZA = -0.5 * electronNumberDensity * secant * (peakShift - absorption * (1.0 + peakShift));
+
+		return electronNumberDensity;
+	}
+
+	/**
+	 * Add the electron number density of a single chapman layer to count
+	 * (altitude, SZA) points. The exponential and logarithm are evaluated
+	 * with FastMath, in chunks that fit on the stack.
+	 * @unit: particles m^-3
+	 */
+	void Ionosphere::addChapmanElectronNumberDensity(double peakDensity, double peakAltitude,
+			double neutralScaleHeight, const double *altitude, const double *SZA,
+			double *electronNumberDensity, int count) {
+
+		const int chunkSize = 256;
+		double secant[chunkSize], normalizedHeight[chunkSize], scratch[chunkSize];
+
+		for (int start = 0; start < count; start += chunkSize) {
+			int n = std::min(chunkSize, count - start);
+			const double *alt = altitude + start;
+			const double *sza = SZA + start;
+			double *n_e = electronNumberDensity + start;
+
+			for (int i = 0; i < n; i++) {
+				secant[i] = 1.0 / cos(sza[i]);
+			}
+
+			FastMath::log(secant, scratch, n);
+			for (int i = 0; i < n; i++) {
+				double correctedPeakAltitude = peakAltitude + 1e4 * scratch[i];
+				normalizedHeight[i] = (alt[i] - correctedPeakAltitude) / neutralScaleHeight;
+				scratch[i] = -normalizedHeight[i];
+			}
+
+			FastMath::exp(scratch, scratch, n);
+			for (int i = 0; i < n; i++) {
+				scratch[i] = 0.5 * (1.0 - normalizedHeight[i] - secant[i] * scratch[i]);
+			}
+
+			FastMath::exp(scratch, scratch, n);
+			for (int i = 0; i < n; i++) {
+				n_e[i] += peakDensity * scratch[i];
+			}
+		}
+	}
+
 	/**
 	 * Compute the plasma refractive index. Three refractive methods are supplied:
 	 * - SIMPLE: The simplified method as described in Kelso, 1964, p.208
@@ -331,10 +506,9 @@ namespace scene {
 		double Y_T = 0;
 		double Y_L = 0;
 		if (Y > 0) {
-			Json::Value magFields = Application::getInstance().getApplicationConfig()
-							.getArray("magneticFields");
-			double BTot = getMagneticFieldStrengthFromConfig();
-			Vector3d k = Config::getVector3dFromObject(magFields[0].get("direction", ""));
+			const SimulationContext &context = Application::getInstance().getSimulationContext();
+			double BTot = context.getMagneticFieldStrength();
+			Vector3d k = context.magneticFields[0].direction;
 			Vector3d B = Vector3d(BTot * sin(angleToMagField), 0, BTot * cos(angleToMagField));
 			Y_T = Y * sin(angleToMagField); //Y * Y * k.cross(B).magnitude() / BTot;
 			Y_L = Y * cos(angleToMagField); //k.dot(B) / BTot;
@@ -395,8 +569,13 @@ namespace scene {
 	 */
 	double Ionosphere::getIncidentAngle(Ray *r) {
 
+		return acos(getIncidentCosine(r));
+	}
+
+	double Ionosphere::getIncidentCosine(Ray *r) {
+
 		// note: the ABSOLUTE angle. Angle between vectors doesnt work.
-		return acos(abs(r->d * mesh3d.normal) / (r->d.magnitude() * mesh3d.normal.magnitude()));
+		return abs(r->d * mesh3d.normal) / (r->d.magnitude() * mesh3d.normal.magnitude());
 	}
 
 	double Ionosphere::getCollisionFrequency() {
@@ -410,9 +589,24 @@ namespace scene {
 	 */
 	void Ionosphere::setCollisionFrequency() {
 
-		double nCO2 = Application::getInstance().getCelestialConfig().getDouble("surfaceNCO2")
-				* exp(-getAltitude() / Constants::NEUTRAL_SCALE_HEIGHT);
-		_collisionFrequency = 1.0436e-07 * nCO2;
+		const IonosphereTable &table = Application::getInstance().getIonosphereTable();
+		if (table.isBuilt()) {
+			_collisionFrequency = table.getCollisionFrequency(getAltitude());
+		} else {
+			_collisionFrequency = getCollisionFrequency(
+					Application::getInstance().getSimulationContext().surfaceNCO2, getAltitude());
+		}
+	}
+
+	/**
+	 * Electron-neutral collision frequency at a given altitude, for an
+	 * atmosphere with the given CO2 number density at the surface
+	 * @unit Hz
+	 */
+	double Ionosphere::getCollisionFrequency(double surfaceNCO2, double altitude) {
+
+		double nCO2 = surfaceNCO2 * exp(-altitude / Constants::NEUTRAL_SCALE_HEIGHT);
+		return 1.0436e-07 * nCO2;
 	}
 
 	void Ionosphere::setCollisionFrequency(double frequency) {
@@ -448,25 +642,23 @@ namespace scene {
 
 		r->behaviour = Ray::wave_none;
 
-		double criticalAngle;
 		double refractiveIndex = getRefractiveIndex(r, Ionosphere::REFRACTION_SIMPLE);
-		double incidentAngle = getIncidentAngle(r);
+		double cosIncidence = getIncidentCosine(r);
+		double sinIncidence = sqrt(1 - pow(cosIncidence, 2));
 		double angularFrequency = 2 * Constants::PI * r->frequency;
-		double epsilon = 1e-5;
 
-		if (incidentAngle > Constants::PI/2)
-			incidentAngle -= Constants::PI/2;
+		// incident angles above Constants::PI/2 are reduced by Constants::PI/2
+		if (cosIncidence < COS_HALF_PI)
+			sinIncidence = sinIncidence * COS_HALF_PI - cosIncidence * SIN_HALF_PI;
 
 		if (angularFrequency < getPlasmaFrequency())
 			r->behaviour = Ray::wave_reflection;
 		else {
 
-			if (refractiveIndex <= r->previousRefractiveIndex)
-				criticalAngle = asin(refractiveIndex / r->previousRefractiveIndex);
-			else
-				criticalAngle = asin(r->previousRefractiveIndex / refractiveIndex);
-
-			if (r->previousRefractiveIndex > refractiveIndex && incidentAngle >= criticalAngle)
+			// the incident angle is at least the critical angle asin(n / n_previous)
+			// when its sine is at least n / n_previous
+			if (r->previousRefractiveIndex > refractiveIndex
+					&& sinIncidence >= refractiveIndex / r->previousRefractiveIndex)
 				r->behaviour = Ray::wave_reflection;
 			else
 				r->behaviour = Ray::wave_refraction;
@@ -476,19 +668,12 @@ namespace scene {
 	}
 
 	/**
-	 * Retrieve the magnetic field strength from the current configuration file
-	 * Return 0 if the value cannot be found in the config
+	 * Retrieve the magnetic field strength from the simulation context
+	 * Return 0 if no magnetic fields are configured
 	 */
 	double Ionosphere::getMagneticFieldStrengthFromConfig() {
 
-		Json::Value magFields = Application::getInstance().getApplicationConfig()
-						.getArray("magneticFields");
-
-		if (magFields.isNull() || magFields.size() < 1) {
-			return 0;
-		}
-
-		return magFields[0].get("strength", "").asDouble();
+		return Application::getInstance().getSimulationContext().getMagneticFieldStrength();
 	}
 
 } /* namespace scene */
@@ -9,6 +9,7 @@
 #define IONOSPHERE_H_
 
 #include "Geometry.h"
+#include "IonosphereLayer.h"
 #include "../math/Vector2d.h"
 
 namespace raytracer {
@@ -22,6 +23,7 @@ namespace scene {
 			Ionosphere();
 			Ionosphere(Plane3d mesh);
 			Ionosphere(Vector3d n, Vector3d c);
+			Ionosphere(const IonosphereLayer &layer);
 			enum refractiveMethod {
 				REFRACTION_SIMPLE,		// According to Kelso, 1964
 				REFRACTION_AHDR			// Appleton-Hartree Dispersion Relation
@@ -35,9 +37,16 @@ namespace scene {
 			void setup();
 
 			/**
-			 * Interaction between ray and ionospheric layer
+			 * Interaction between ray and ionospheric layer: reflection or
+			 * refraction, attenuation, delays and export in a single pass
 			 */
 			void interact(Ray *r, Vector3d &hitpos);
+
+			/**
+			 * interact() for a known magnetic field option, see tracer::Physics.
+			 * Instantiated for both values.
+			 */
+			template <bool MagneticField> void interact(Ray *r, Vector3d &hitpos);
 			void refract(Ray *r);
 			void reflect(Ray *r);
 
@@ -57,6 +66,7 @@ namespace scene {
 			void phaseAdvance(Ray *r);
 			void timeDelay(Ray *r);
 			void exportData(Ray *r);
+			void exportData(Ray *r, double plasmaFrequency);
 
 			/**
 			 * Include the effects of magnetic fields
@@ -85,12 +95,42 @@ namespace scene {
 			 */
 			void superimposeElectronNumberDensity(double peakDensity, double peakAltitude, double neutralScaleHeight);
 
+			/**
+			 * Electron number density of a single chapman layer at a given altitude
+			 * and solar zenith angle
+			 * @unit: particles m^-3
+			 */
+			static double getChapmanElectronNumberDensity(double peakDensity, double peakAltitude,
+					double neutralScaleHeight, double altitude, double SZA);
+
+			/**
+			 * Electron number density of a single chapman layer, together with
+			 * its derivatives with respect to the altitude (m^-4) and with
+			 * respect to the cosine of the solar zenith angle (m^-3)
+			 * @unit: particles m^-3
+			 */
+			static double getChapmanElectronNumberDensity(double peakDensity, double peakAltitude,
+					double neutralScaleHeight, double altitude, double SZA,
+					double &derivativeAltitude, double &derivativeCosSZA);
+
+			/**
+			 * Add the electron number density of a single chapman layer to
+			 * electronNumberDensity, for count points at once. The difference
+			 * with getChapmanElectronNumberDensity is below 1e-13 times the
+			 * peak density for SZA up to 89 degrees.
+			 * @unit: particles m^-3
+			 */
+			static void addChapmanElectronNumberDensity(double peakDensity, double peakAltitude,
+					double neutralScaleHeight, const double *altitude, const double *SZA,
+					double *electronNumberDensity, int count);
+
 			/**
 			 * Use a chapmanProfile to calculate the electron number density
 			 * @unit: particles m^-3
 			 */
 			double getElectronNumberDensity();
 			void setElectronNumberDensity(double n_e);
+			void setPeakElectronDensity(double n_e);
 
 			/**
 			 * Compute the plasma refractive index. Three refractive methods are supplied:
@@ -112,6 +152,12 @@ namespace scene {
 			 */
 			double getIncidentAngle(Ray *r);
 
+			/**
+			 * Cosine of the incident angle, from the dot product of the ray
+			 * direction and the normal of the layer
+			 */
+			double getIncidentCosine(Ray *r);
+
 			/**
 			 * Model the collision frequency
 			 * @unit Hz
@@ -120,6 +166,13 @@ namespace scene {
 			void setCollisionFrequency();
 			void setCollisionFrequency(double freq);
 
+			/**
+			 * Electron-neutral collision frequency at a given altitude, for an
+			 * atmosphere with the given CO2 number density at the surface
+			 * @unit Hz
+			 */
+			static double getCollisionFrequency(double surfaceNCO2, double altitude);
+
 			/**
 			 * Calculate the electron angular gyrofrequency [rad s^-1]
 			 */
@@ -134,8 +187,8 @@ namespace scene {
 			int determineWaveBehaviour(Ray *r);
 
 			/**
-			 * Retrieve the magnetic field strength from the current configuration file
-			 * Return 0 if the value cannot be found in the config
+			 * Retrieve the magnetic field strength from the simulation context
+			 * Return 0 if no magnetic fields are configured
 			 */
 			double getMagneticFieldStrengthFromConfig();
 
@@ -144,6 +197,13 @@ namespace scene {
 			double electronDensityVariability = 0;
 			static constexpr double surfaceCollisionFrequency = 4.5e10;	// s^-1
 
+			/**
+			 * Cosine and sine of the rounded Constants::PI and of half of it,
+			 * with which the fused interaction reproduces the angle based
+			 * formulas of the separate interaction methods
+			 */
+			static const double COS_HALF_PI, SIN_HALF_PI, COS_PI, SIN_PI;
+
 		private:
 			double _electronNumberDensity = 0;	// m^-3
 			double _peakElectronDensity = 0;	// m^-3
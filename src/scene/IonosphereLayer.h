@@ -0,0 +1,29 @@
+//============================================================================
+// Name        : IonosphereLayer.h
+// Author      : Rian van Gijlswijk
+// Description : State of an ionospheric layer crossing, as found by the
+//				 scene manager. Passed by value so that an intersection with
+//				 the ionosphere does not require a heap allocated Ionosphere
+//============================================================================
+
+#ifndef SCENE_IONOSPHERELAYER_H_
+#define SCENE_IONOSPHERELAYER_H_
+
+#include "../math/Vector3d.h"
+
+namespace raytracer {
+namespace scene {
+
+	struct IonosphereLayer {
+		math::Vector3d normal;
+		math::Vector3d centerpoint;
+		double size = 0;					// m
+		double layerHeight = 0;				// m
+		double electronNumberDensity = 0;	// m^-3
+		double peakElectronDensity = 0;		// m^-3
+	};
+
+} /* namespace scene */
+} /* namespace raytracer */
+
+#endif /* SCENE_IONOSPHERELAYER_H_ */
@@ -0,0 +1,272 @@
+//============================================================================
+// Name        : IonosphereTable.cpp
+// Author      : Rian van Gijlswijk
+// Description : Precomputed electron number density and collision frequency
+//============================================================================
+
+#include <cmath>
+#include <algorithm>
+#include <boost/log/trivial.hpp>
+#include "IonosphereTable.h"
+#include "Ionosphere.h"
+
+namespace raytracer {
+namespace scene {
+
+	using namespace core;
+	using namespace math;
+
+	IonosphereTable::IonosphereTable() {}
+
+	/**
+	 * Sample the chapman layers of the context on a regular altitude x SZA
+	 * grid. The grid is refined until bilinear interpolation reproduces the
+	 * exact profile to within maxError, relative to the peak electron
+	 * density (and relative to the local value for the collision frequency).
+	 */
+	void IonosphereTable::build(const SimulationContext &context, double maxError) {
+
+		_built = false;
+		_layers = context.ionosphereLayers;
+		_surfaceNCO2 = context.surfaceNCO2;
+
+		// rays interact with the ionosphere up to one step outside of its boundaries
+		_minAltitude = context.ionosphereStart - context.ionosphereStep;
+		_maxAltitude = context.ionosphereEnd + context.ionosphereStep;
+
+		if (_layers.empty() || _maxAltitude <= _minAltitude) {
+			return;
+		}
+
+		_peakElectronDensity = 0;
+		for (const IonosphereLayerParameters &layer : _layers) {
+			_peakElectronDensity = std::max(_peakElectronDensity, layer.electronPeakDensity);
+		}
+
+		_altitudeStep = 1000;
+		_SZAStep = Constants::PI / 180.0;
+
+		for (int refinement = 0; refinement <= MAX_REFINEMENTS; refinement++) {
+
+			fill();
+
+			double altitudeError = std::max(measureError(0.5, 0), measureCollisionFrequencyError());
+			double SZAError = measureError(0, 0.5);
+			_maxError = std::max(std::max(altitudeError, SZAError), measureError(0.5, 0.5));
+
+			if (_maxError <= maxError) {
+				break;
+			}
+
+			if (refinement == MAX_REFINEMENTS || 4.0 * _numAltitudes * _numSZA > MAX_ENTRIES) {
+				BOOST_LOG_TRIVIAL(warning) << "Ionosphere table error bound of " << maxError
+						<< " not reached, using table with error " << _maxError;
+				break;
+			}
+
+			// the error in the cell center can exceed the bound while both
+			// axes are within it; refine both axes in that case
+			bool refineBoth = altitudeError <= maxError && SZAError <= maxError;
+			if (altitudeError > maxError || refineBoth) {
+				_altitudeStep /= 2;
+			}
+			if (SZAError > maxError || refineBoth) {
+				_SZAStep /= 2;
+			}
+		}
+
+		_built = true;
+
+		BOOST_LOG_TRIVIAL(info) << "Ionosphere table: " << _numAltitudes << "x" << _numSZA
+				<< " entries, dh=" << _altitudeStep << " m, dSZA=" << _SZAStep << " rad, max error " << _maxError;
+	}
+
+	bool IonosphereTable::isBuilt() const {
+
+		return _built;
+	}
+
+	/**
+	 * Interpolated electron number density. Points outside of the table
+	 * are evaluated exactly.
+	 * @unit: particles m^-3
+	 */
+	double IonosphereTable::getElectronNumberDensity(double altitude, double SZA) const {
+
+		if (!_built || altitude < _minAltitude || altitude > _maxAltitude || SZA < 0 || SZA > MAX_SZA) {
+			return evaluateElectronNumberDensity(altitude, SZA);
+		}
+
+		return interpolate(altitude, SZA);
+	}
+
+	/**
+	 * Plasma frequency belonging to the interpolated electron number density
+	 * @unit: rad s^-1
+	 */
+	double IonosphereTable::getPlasmaFrequency(double altitude, double SZA) const {
+
+		return sqrt(getElectronNumberDensity(altitude, SZA) * pow(Constants::ELEMENTARY_CHARGE, 2)
+				/ (Constants::ELECTRON_MASS * Constants::PERMITTIVITY_VACUUM));
+	}
+
+	/**
+	 * Interpolated electron-neutral collision frequency
+	 * @unit: Hz
+	 */
+	double IonosphereTable::getCollisionFrequency(double altitude) const {
+
+		if (!_built || altitude < _minAltitude || altitude > _maxAltitude) {
+			return evaluateCollisionFrequency(altitude);
+		}
+
+		double i = (altitude - _minAltitude) / _altitudeStep;
+		int i0 = std::min((int)i, _numAltitudes - 2);
+		double t = i - i0;
+
+		return (1 - t) * _collisionFrequency[i0] + t * _collisionFrequency[i0 + 1];
+	}
+
+	double IonosphereTable::getPeakElectronDensity() const {
+
+		return _peakElectronDensity;
+	}
+
+	double IonosphereTable::getMaxError() const {
+
+		return _maxError;
+	}
+
+	double IonosphereTable::getAltitudeStep() const {
+
+		return _altitudeStep;
+	}
+
+	double IonosphereTable::getSZAStep() const {
+
+		return _SZAStep;
+	}
+
+	/**
+	 * Exact evaluation of the superimposed chapman profiles
+	 * @unit: particles m^-3
+	 */
+	double IonosphereTable::evaluateElectronNumberDensity(double altitude, double SZA) const {
+
+		double electronNumberDensity = 0;
+		for (const IonosphereLayerParameters &layer : _layers) {
+			electronNumberDensity += Ionosphere::getChapmanElectronNumberDensity(layer.electronPeakDensity,
+					layer.peakProductionAltitude, layer.neutralScaleHeight, altitude, SZA);
+		}
+
+		return electronNumberDensity;
+	}
+
+	/**
+	 * Evaluation of the superimposed chapman profiles at count points at once
+	 * @unit: particles m^-3
+	 */
+	void IonosphereTable::evaluateElectronNumberDensity(const double *altitude, const double *SZA,
+			double *electronNumberDensity, int count) const {
+
+		std::fill(electronNumberDensity, electronNumberDensity + count, 0.0);
+		for (const IonosphereLayerParameters &layer : _layers) {
+			Ionosphere::addChapmanElectronNumberDensity(layer.electronPeakDensity, layer.peakProductionAltitude,
+					layer.neutralScaleHeight, altitude, SZA, electronNumberDensity, count);
+		}
+	}
+
+	double IonosphereTable::evaluateCollisionFrequency(double altitude) const {
+
+		return Ionosphere::getCollisionFrequency(_surfaceNCO2, altitude);
+	}
+
+	/**
+	 * Resize the grid to the current step sizes and evaluate all nodes
+	 */
+	void IonosphereTable::fill() {
+
+		_numAltitudes = std::max(2, (int)ceil((_maxAltitude - _minAltitude) / _altitudeStep) + 1);
+		_altitudeStep = (_maxAltitude - _minAltitude) / (_numAltitudes - 1);
+		_numSZA = std::max(2, (int)ceil(MAX_SZA / _SZAStep) + 1);
+		_SZAStep = MAX_SZA / (_numSZA - 1);
+
+		_electronNumberDensity.assign(_numAltitudes * _numSZA, 0);
+		_collisionFrequency.assign(_numAltitudes, 0);
+
+		// every row of the grid is evaluated at once
+		std::vector<double> altitudes(_numSZA), SZAs(_numSZA);
+		for (int j = 0; j < _numSZA; j++) {
+			SZAs[j] = j * _SZAStep;
+		}
+
+		for (int i = 0; i < _numAltitudes; i++) {
+			double altitude = _minAltitude + i * _altitudeStep;
+			_collisionFrequency[i] = evaluateCollisionFrequency(altitude);
+			std::fill(altitudes.begin(), altitudes.end(), altitude);
+			evaluateElectronNumberDensity(altitudes.data(), SZAs.data(), &_electronNumberDensity[i * _numSZA], _numSZA);
+		}
+	}
+
+	/**
+	 * Largest interpolation error of the electron number density, relative
+	 * to the peak density, at the given offset within each grid cell
+	 */
+	double IonosphereTable::measureError(double altitudeOffset, double SZAOffset) const {
+
+		int numSZA = _numSZA - 1;
+		std::vector<double> altitudes(numSZA), SZAs(numSZA), exact(numSZA);
+		for (int j = 0; j < numSZA; j++) {
+			SZAs[j] = (j + SZAOffset) * _SZAStep;
+		}
+
+		double maxError = 0;
+		for (int i = 0; i < _numAltitudes - 1; i++) {
+			double altitude = _minAltitude + (i + altitudeOffset) * _altitudeStep;
+			std::fill(altitudes.begin(), altitudes.end(), altitude);
+			evaluateElectronNumberDensity(altitudes.data(), SZAs.data(), exact.data(), numSZA);
+			for (int j = 0; j < numSZA; j++) {
+				double error = std::abs(interpolate(altitude, SZAs[j]) - exact[j]);
+				maxError = std::max(maxError, error / _peakElectronDensity);
+			}
+		}
+
+		return maxError;
+	}
+
+	double IonosphereTable::measureCollisionFrequencyError() const {
+
+		double maxError = 0;
+		for (int i = 0; i < _numAltitudes - 1; i++) {
+			double altitude = _minAltitude + (i + 0.5) * _altitudeStep;
+			double exact = evaluateCollisionFrequency(altitude);
+			double interpolated = 0.5 * (_collisionFrequency[i] + _collisionFrequency[i + 1]);
+			if (exact > 0) {
+				maxError = std::max(maxError, std::abs(interpolated - exact) / exact);
+			}
+		}
+
+		return maxError;
+	}
+
+	/**
+	 * Bilinear interpolation of the electron number density
+	 */
+	double IonosphereTable::interpolate(double altitude, double SZA) const {
+
+		double i = (altitude - _minAltitude) / _altitudeStep;
+		double j = SZA / _SZAStep;
+		int i0 = std::min((int)i, _numAltitudes - 2);
+		int j0 = std::min((int)j, _numSZA - 2);
+		double t = i - i0;
+		double u = j - j0;
+
+		const double *row0 = &_electronNumberDensity[i0 * _numSZA + j0];
+		const double *row1 = row0 + _numSZA;
+
+		return (1 - t) * ((1 - u) * row0[0] + u * row0[1])
+				+ t * ((1 - u) * row1[0] + u * row1[1]);
+	}
+
+} /* namespace scene */
+} /* namespace raytracer */
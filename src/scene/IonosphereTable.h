@@ -0,0 +1,119 @@
+//============================================================================
+// Name        : IonosphereTable.h
+// Author      : Rian van Gijlswijk
+// Description : Precomputed electron number density and collision frequency
+//				 of the scenario ionosphere, indexed by altitude and solar
+//				 zenith angle. The table is built once at start-up and is
+//				 read-only afterwards, so it can be shared between workers.
+//============================================================================
+
+#ifndef SCENE_IONOSPHERETABLE_H_
+#define SCENE_IONOSPHERETABLE_H_
+
+#include <vector>
+#include "../core/SimulationContext.h"
+#include "../math/Constants.h"
+
+namespace raytracer {
+namespace scene {
+
+	class IonosphereTable {
+
+		public:
+			IonosphereTable();
+
+			/**
+			 * Sample the chapman layers of the context on a regular altitude x SZA
+			 * grid. The grid is refined until bilinear interpolation reproduces the
+			 * exact profile to within maxError, relative to the peak electron
+			 * density (and relative to the local value for the collision frequency).
+			 */
+			void build(const core::SimulationContext &context, double maxError);
+			bool isBuilt() const;
+
+			/**
+			 * Interpolated electron number density. Points outside of the table
+			 * are evaluated exactly.
+			 * @unit: particles m^-3
+			 */
+			double getElectronNumberDensity(double altitude, double SZA) const;
+
+			/**
+			 * Plasma frequency belonging to the interpolated electron number density
+			 * @unit: rad s^-1
+			 */
+			double getPlasmaFrequency(double altitude, double SZA) const;
+
+			/**
+			 * Interpolated electron-neutral collision frequency
+			 * @unit: Hz
+			 */
+			double getCollisionFrequency(double altitude) const;
+
+			/**
+			 * The highest peak density of all layers
+			 * @unit: particles m^-3
+			 */
+			double getPeakElectronDensity() const;
+
+			/**
+			 * The largest interpolation error found while building the table,
+			 * relative to the peak electron density
+			 */
+			double getMaxError() const;
+			double getAltitudeStep() const;
+			double getSZAStep() const;
+
+			/**
+			 * Exact evaluation of the superimposed chapman profiles
+			 * @unit: particles m^-3
+			 */
+			double evaluateElectronNumberDensity(double altitude, double SZA) const;
+
+			/**
+			 * Evaluation of the superimposed chapman profiles at count points at
+			 * once, using the vectorized exponential and logarithm. Used to fill
+			 * the table; the difference with the exact evaluation is negligible
+			 * compared to the interpolation error.
+			 * @unit: particles m^-3
+			 */
+			void evaluateElectronNumberDensity(const double *altitude, const double *SZA,
+					double *electronNumberDensity, int count) const;
+			double evaluateCollisionFrequency(double altitude) const;
+
+			static constexpr double MAX_SZA = 89.0 * math::Constants::PI / 180.0;	// rad
+			static constexpr int MAX_REFINEMENTS = 8;
+			static constexpr int MAX_ENTRIES = 4000000;
+
+		private:
+			void fill();
+
+			/**
+			 * Largest interpolation error of the electron number density, relative
+			 * to the peak density, at the given offset within each grid cell
+			 * @param double altitudeOffset: fraction of the altitude step
+			 * @param double SZAOffset: fraction of the SZA step
+			 */
+			double measureError(double altitudeOffset, double SZAOffset) const;
+			double measureCollisionFrequencyError() const;
+			double interpolate(double altitude, double SZA) const;
+
+			std::vector<core::IonosphereLayerParameters> _layers;
+			std::vector<double> _electronNumberDensity;		// [altitude][SZA]
+			std::vector<double> _collisionFrequency;		// [altitude]
+			double _surfaceNCO2 = 0;
+			double _minAltitude = 0;
+			double _maxAltitude = 0;
+			double _altitudeStep = 0;
+			double _SZAStep = 0;
+			int _numAltitudes = 0;
+			int _numSZA = 0;
+			double _peakElectronDensity = 0;
+			double _maxError = 0;
+			bool _built = false;
+	};
+
+} /* namespace scene */
+} /* namespace raytracer */
+
+#endif /* SCENE_IONOSPHERETABLE_H_ */
@@ -11,6 +11,7 @@
 #include <algorithm> // remove and remove_if
 #include "SceneManager.h"
 #include "Geometry.h"
+#include "Ionosphere.h"
 #include "../core/Application.h"
 #include "../core/Config.h"
 
@@ -25,23 +26,26 @@ namespace scene {
 	/**
 	 *  Load celestial and application configuration values
 	 */
-	void SceneManager::loadStaticEnvironment() {
-		BOOST_LOG_TRIVIAL(debug) << "test SceneManager";
+	void SceneManager::loadStaticEnvironment(const SimulationContext &context, const IonosphereTable *table) {
+
+		_context = &context;
+		_table = table != nullptr && table->isBuilt() ? table : nullptr;
+		dh = context.ionosphereStep;
+		minH = context.ionosphereStart;
+		maxH = context.ionosphereEnd;
+		R = context.radius;
+		angularStepSize = context.angularStepSize;
+	}
+
+	const IonosphereTable* SceneManager::getIonosphereTable() const {
 
-		const Json::Value ionosphereConfig = Application::getInstance().getCelestialConfig().getObject("ionosphere");
-		dh = ionosphereConfig["step"].asInt();
-		minH = ionosphereConfig["start"].asInt();
-		maxH = ionosphereConfig["end"].asInt();
-		R = Application::getInstance().getCelestialConfig().getInt("radius");
-		angularStepSize = Application::getInstance().getApplicationConfig().getDouble("angularStepSize");
+		return _table;
 	}
 
 	/**
 	 * Find which object in the scene intersects with a ray
 	 */
-	Intersection SceneManager::intersect(Ray &r, Line3d & rayLine) {
-
-		static int foo = 0;
+	Intersection SceneManager::intersect(Ray &r, Line3d & rayLine) const {
 
 		Intersection finalHit;
 		//finalHit.g = new Geometry();//(Geometry*)malloc(sizeof(Geometry));
@@ -66,21 +70,25 @@ namespace scene {
 		BOOST_LOG_TRIVIAL(debug) << "Rayline intercept: " << rayLine.getVector() << ", old normal: " << oldNormal << ", colType: " << r.lastHitType;
 		BOOST_LOG_TRIVIAL(debug) << "curAlt: " << r.altitude << ", nextAlt:" << nextAlt;
 
-		if (nextAlt >= minH && nextAlt <= maxH) {
-			foo++;
+		// without a loaded environment, there is no ionosphere
+		if (_context != nullptr && nextAlt >= minH && nextAlt <= maxH) {
 			BOOST_LOG_TRIVIAL(debug) << "Use instant approach: goingup=" << goingUp;
 			double DA = R + r.altitude;
 			double DB = R + nextAlt;
 			// in x-y plane
 			Vector3d v1 = Vector3d(r.d.x, r.d.y, r.d.z);
 			Vector3d v2 = Vector3d(oldNormal.x, oldNormal.y, oldNormal.z);
-			double theta, dR;
+			// cos(theta) follows from the dot product. Going up, theta is
+			// Constants::PI minus the angle between the vectors, expanded with
+			// the sine and cosine of the rounded Constants::PI.
+			double cosine = v1.cosine(v2);
+			double cosTheta, dR;
 			if (goingUp) {
-				theta = Constants::PI - v1.angle(v2);
-				dR = sqrt(pow(DA, 2) * pow(cos(theta) ,2) - pow(DA, 2) + pow(DB, 2)) + DA * cos(theta);
+				cosTheta = Ionosphere::COS_PI * cosine + Ionosphere::SIN_PI * sqrt(1 - cosine * cosine);
+				dR = sqrt(pow(DA, 2) * pow(cosTheta, 2) - pow(DA, 2) + pow(DB, 2)) + DA * cosTheta;
 			} else {
-				theta = v1.angle(v2);
-				dR = -sqrt(pow(DA, 2) * pow(cos(theta) ,2) - pow(DA, 2) + pow(DB, 2)) - DA * cos(theta);
+				cosTheta = cosine;
+				dR = -sqrt(pow(DA, 2) * pow(cosTheta, 2) - pow(DA, 2) + pow(DB, 2)) - DA * cosTheta;
 			}
 			Vector3d dRv = r.o + r.d * dR;
 			BOOST_LOG_TRIVIAL(debug) << "dRv: " << dRv;
@@ -89,89 +97,366 @@ namespace scene {
 			BOOST_LOG_TRIVIAL(debug) << "normal created: " << dRv.norm();
 			BOOST_LOG_TRIVIAL(debug) << "r.d: " << r.d << " -> theta_i: " << r.d.angle(dRv.norm()) * 180.0 / Constants::PI;
 
-			// construct new ionosphere object
-			Plane3d mesh = Plane3d(dRv.norm(), dRv);
-			mesh.size = angularStepSize * R;
-			Ionosphere* io = new Ionosphere(mesh);
-			io->layerHeight = dh;
-
-			const Json::Value ionosphereConfig = Application::getInstance().getCelestialConfig().getObject("ionosphere");
-			for (int idx = 0; idx < ionosphereConfig["layers"].size(); idx++) {
-
-				double electronPeakDensity = atof(ionosphereConfig["layers"][idx].get("electronPeakDensity", "").asCString());
-				double peakProductionAltitude = ionosphereConfig["layers"][idx].get("peakProductionAltitude", "").asDouble();
-				double neutralScaleHeight = ionosphereConfig["layers"][idx].get("neutralScaleHeight", 11.1e3).asDouble();
+			// describe the crossed ionospheric layer
+			IonosphereLayer &layer = finalHit.layer;
+			layer.normal = dRv.norm();
+			layer.centerpoint = dRv;
+			layer.size = angularStepSize * R;
+			layer.layerHeight = dh;
+
+			double altitude = dRv.magnitude() - R;
+			double SZA = layer.normal.angle(Vector3d::SUBSOLAR);
+			if (_table != nullptr) {
+				layer.electronNumberDensity = _table->getElectronNumberDensity(altitude, SZA);
+				layer.peakElectronDensity = _table->getPeakElectronDensity();
+			} else {
+				for (const IonosphereLayerParameters &params : _context->ionosphereLayers) {
 
-				io->superimposeElectronNumberDensity(electronPeakDensity, peakProductionAltitude, neutralScaleHeight);
+					layer.electronNumberDensity += Ionosphere::getChapmanElectronNumberDensity(params.electronPeakDensity,
+							params.peakProductionAltitude, params.neutralScaleHeight, altitude, SZA);
+					layer.peakElectronDensity = max(layer.peakElectronDensity, params.electronPeakDensity);
+				}
 			}
-			BOOST_LOG_TRIVIAL(debug) << "Object created: " << io->mesh3d.centerpoint << " with alt: " << io->mesh3d.centerpoint.distance(Vector3d::CENTER) - R;
+			BOOST_LOG_TRIVIAL(debug) << "Layer created: " << layer.centerpoint << " with alt: " << altitude;
 
-			finalHit.pos = io->mesh3d.centerpoint;
-			finalHit.g = io;
+			finalHit.pos = layer.centerpoint;
+			finalHit.normal = layer.normal;
 			finalHit.o = GeometryType::ionosphere;
-			io = nullptr;
 
 		} else {
 			BOOST_LOG_TRIVIAL(debug) << "Use collision detection approach";
-			Vector3d pos;
-			list<Intersection*> hits = list<Intersection*>();
-			double epsilon = 1e-5;
+			double distance = 1e9;
+			int closestIndex = -1;
+			int numObjects = _sceneObjectsVector.size();
+
+			// Line3d::intersect only reports hits within half the mesh size of
+			// the mesh centerpoint (per axis), so only objects with their
+			// centerpoint within this reach of the ray line can be hit
+			double reach = rayLine.origin.distance(rayLine.destination)
+					+ 0.5 * sqrt(3.0) * _maxObjectSize + INDEX_MARGIN;
+			int minX = 0, maxX = -1, minY = 0, maxY = -1, minZ = 0, maxZ = -1;
+			double numCells = numObjects + 1.0;
+			if (_indexed) {
+				minX = getCellCoordinate(rayLine.origin.x - reach);
+				maxX = getCellCoordinate(rayLine.origin.x + reach);
+				minY = getCellCoordinate(rayLine.origin.y - reach);
+				maxY = getCellCoordinate(rayLine.origin.y + reach);
+				minZ = getCellCoordinate(rayLine.origin.z - reach);
+				maxZ = getCellCoordinate(rayLine.origin.z + reach);
+				numCells = (maxX - minX + 1.0) * (maxY - minY + 1.0) * (maxZ - minZ + 1.0);
+			}
 
-			for (Geometry* gp : _sceneObjectsVector) {
+			if (numCells <= numObjects) {
+				for (int x = minX; x <= maxX; x++) {
+					for (int y = minY; y <= maxY; y++) {
+						for (int z = minZ; z <= maxZ; z++) {
+							uint64_t key = getCellKey(x, y, z);
+							vector<uint64_t>::const_iterator cell = lower_bound(_cellKeys.begin(), _cellKeys.end(), key);
+							if (cell == _cellKeys.end() || *cell != key) {
+								continue;
+							}
+							int c = cell - _cellKeys.begin();
+							for (int k = _cellStart[c]; k < _cellStart[c + 1]; k++) {
+								testHit(_cellObjects[k], r, rayLine, finalHit, distance, closestIndex);
+							}
+						}
+					}
+				}
+			} else {
+				// long ray lines or no index: scan the whole scene
+				for (int i = 0; i < numObjects; i++) {
+					testHit(i, r, rayLine, finalHit, distance, closestIndex);
+				}
+			}
 
-				Plane3d mesh = gp->getMesh();
-				pos = rayLine.intersect(mesh);
+			if (_context != nullptr && _context->terrain == SimulationContext::terrain_sphere) {
+				intersectSphere(r, rayLine, finalHit, distance);
+			}
+		}
 
-				if (abs(pos.x) > epsilon || abs(pos.y) > epsilon || abs(pos.z) > epsilon) {
-					double smallestX = rayLine.origin.x;
-					double biggestX = rayLine.destination.x;
-					if (rayLine.destination.x < rayLine.origin.x) {
-						smallestX = rayLine.destination.x;
-						biggestX = rayLine.origin.x;
-					}
-					double smallestY = rayLine.origin.y;
-					double biggestY = rayLine.destination.y;
-					if (rayLine.destination.y < rayLine.origin.y) {
-						smallestY = rayLine.destination.y;
-						biggestY = rayLine.origin.y;
-					}
-					double smallestZ = rayLine.origin.z;
-					double biggestZ = rayLine.destination.z;
-					if (rayLine.destination.z < rayLine.origin.z) {
-						smallestZ = rayLine.destination.z;
-						biggestZ = rayLine.origin.z;
-					}
+		BOOST_LOG_TRIVIAL(debug) << finalHit.o << "\t" << finalHit.pos << "\t";
 
-					// is it within the scene and within the limits of the ray itself?
-					if (smallestY < (pos.y + epsilon) && biggestY > (pos.y - epsilon) &&
-							smallestX < (pos.x + epsilon) && biggestX > (pos.x - epsilon) &&
-							smallestZ < (pos.z + epsilon) && biggestZ > (pos.z - epsilon)) {
+		return finalHit;
+	}
 
-						Intersection* hit = new Intersection();
-						hit->pos = pos;
-						hit->o = gp->type;
-						hit->g = gp;
-						hits.push_back(hit);
-					}
-				}
+	/**
+	 * Distance over which the ray can travel in a straight line along
+	 * its direction without interacting with the scene: through vacuum
+	 * below and above the ionosphere, and through ionospheric layers
+	 * with a negligible plasma frequency. Returns 0 if skipping would
+	 * not save any steps.
+	 */
+	double SceneManager::getSkipDistance(Ray &r) const {
+
+		if (_context == nullptr) {
+			return 0;
+		}
+
+		bool goingUp = r.o * r.d > 0;
+		double nextAlt = goingUp ? r.altitude + dh : r.altitude - dh;
+
+		if (nextAlt >= minH && nextAlt <= maxH) {
+			return getLayerSkipDistance(r);
+		}
+
+		return getVacuumSkipDistance(r);
+	}
+
+	/**
+	 * Outside of the ionosphere, rays travel in straight lines until they
+	 * reach the ionosphere, leave the scene or get close to a scene object.
+	 */
+	double SceneManager::getVacuumSkipDistance(Ray &r) const {
+
+		double b = r.o * r.d;
+		double oo = r.o * r.o;
+		bool goingUp = b > 0;
+
+		// altitude band around the ray which contains no ionosphere and no
+		// scene objects. Objects can be hit anywhere up to _maxObjectReach.
+		double objectAltitude = max(0.0, _maxObjectReach - R);
+		double lowest, highest;
+		if (r.altitude < minH - dh) {
+			lowest = objectAltitude;
+			// end just above minH - dh, so the next step crosses the layer at minH
+			highest = minH - dh + SKIP_MARGIN;
+		} else if (goingUp || r.altitude > maxH + dh) {
+			lowest = goingUp ? objectAltitude : max(objectAltitude, maxH + dh);
+			// end just outside of the scene, so the next step terminates the ray
+			highest = _context->sceneBoundary - R + SKIP_MARGIN;
+		} else {
+			return 0;
+		}
+		if (r.altitude < lowest || r.altitude > highest) {
+			return 0;
+		}
+
+		// the altitude along a straight line is convex, so the line leaves the
+		// band at its upper boundary, or at its lower boundary on the way down
+		double distance = -b + sqrt(b * b - oo + pow(R + highest, 2));
+		double discriminant = b * b - oo + pow(R + lowest, 2);
+		if (!goingUp && discriminant >= 0) {
+			distance = min(distance, max(0.0, -b - sqrt(discriminant)));
+		}
+
+		return distance > Ray::magnitude ? distance : 0;
+	}
+
+	/**
+	 * Inside of the ionosphere, layers are crossed one step of dh at a time.
+	 * Layers where the plasma frequency is a negligible fraction of the wave
+	 * frequency hardly refract the ray, so these are crossed in a straight
+	 * line. The ray is placed on the last negligible layer, such that the
+	 * next step crosses the first layer that matters. Layers which could
+	 * reflect the ray at its incident angle are never skipped.
+	 */
+	double SceneManager::getLayerSkipDistance(Ray &r) const {
+
+		double ratio = _context->skipPlasmaFrequencyRatio;
+		if (_table == nullptr || ratio <= 0) {
+			return 0;
+		}
+
+		double b = r.o * r.d;
+		double oo = r.o * r.o;
+		bool goingUp = b > 0;
+		double angularFrequency = 2 * Constants::PI * r.frequency;
+		double maxX = ratio * ratio;
+		double distance = 0;
+
+		for (int k = 1; ; k++) {
+			double altitude = goingUp ? r.altitude + k * dh : r.altitude - k * dh;
+			if (altitude < minH || altitude > maxH) {
+				break;
+			}
+
+			double discriminant = b * b - oo + pow(R + altitude, 2);
+			if (discriminant < 0) {
+				// the line turns around above this layer
+				break;
 			}
+			double layerDistance = goingUp ? -b + sqrt(discriminant) : -b - sqrt(discriminant);
 
-			if (hits.size() > 0) {
-				// evaluate which hit is closest
-				double distance = 1e9;
+			Vector3d pos = r.o + r.d * layerDistance;
+			Vector3d normal = pos.norm();
+			double X = pow(_table->getPlasmaFrequency(altitude, normal.angle(Vector3d::SUBSOLAR)) / angularFrequency, 2);
+			if (X >= maxX) {
+				break;
+			}
 
-				for (Intersection* i : hits) {
-					if (r.o.distance(i->pos) < distance && r.lastHitNormal != i->g->mesh3d.normal) {
-						finalHit = *i;
-						distance = r.o.distance(i->pos);
-					}
+			// same criterion as Ionosphere::determineWaveBehaviour, on the sine
+			// of the incident angle instead of the angle itself
+			double refractiveIndex = sqrt(1 - X);
+			double cosIncidence = abs(r.d * normal) / r.d.magnitude();
+			if (refractiveIndex <= r.previousRefractiveIndex
+					&& sqrt(1 - cosIncidence * cosIncidence) >= refractiveIndex / r.previousRefractiveIndex) {
+				break;
+			}
+
+			distance = layerDistance;
+		}
+
+		return distance;
+	}
+
+	/**
+	 * Test a single scene object for intersection with the ray line.
+	 * The hit is kept if it is closer than the closest hit so far,
+	 * ties are won by the object which comes first in the scene.
+	 */
+	void SceneManager::testHit(int index, Ray &r, Line3d &rayLine, Intersection &closestHit,
+			double &distance, int &closestIndex) const {
+
+		Geometry* gp = _sceneObjectsVector[index];
+		double epsilon = 1e-5;
+
+		Plane3d mesh = gp->getMesh();
+		Vector3d pos = rayLine.intersect(mesh);
+
+		if (abs(pos.x) > epsilon || abs(pos.y) > epsilon || abs(pos.z) > epsilon) {
+			double smallestX = rayLine.origin.x;
+			double biggestX = rayLine.destination.x;
+			if (rayLine.destination.x < rayLine.origin.x) {
+				smallestX = rayLine.destination.x;
+				biggestX = rayLine.origin.x;
+			}
+			double smallestY = rayLine.origin.y;
+			double biggestY = rayLine.destination.y;
+			if (rayLine.destination.y < rayLine.origin.y) {
+				smallestY = rayLine.destination.y;
+				biggestY = rayLine.origin.y;
+			}
+			double smallestZ = rayLine.origin.z;
+			double biggestZ = rayLine.destination.z;
+			if (rayLine.destination.z < rayLine.origin.z) {
+				smallestZ = rayLine.destination.z;
+				biggestZ = rayLine.origin.z;
+			}
+
+			// is it within the scene and within the limits of the ray itself?
+			if (smallestY < (pos.y + epsilon) && biggestY > (pos.y - epsilon) &&
+					smallestX < (pos.x + epsilon) && biggestX > (pos.x - epsilon) &&
+					smallestZ < (pos.z + epsilon) && biggestZ > (pos.z - epsilon) &&
+					r.lastHitNormal != gp->mesh3d.normal) {
+
+				double hitDistance = r.o.distance(pos);
+				if (hitDistance < distance || (hitDistance == distance && index < closestIndex)) {
+					closestHit.pos = pos;
+					closestHit.o = gp->type;
+					closestHit.g = gp;
+					closestHit.normal = gp->mesh3d.normal;
+					distance = hitDistance;
+					closestIndex = index;
 				}
 			}
 		}
+	}
 
-		BOOST_LOG_TRIVIAL(debug) << finalHit.o << "\t" << finalHit.pos << "\t";
+	/**
+	 * Closed-form intersection of the ray line with the surface of the
+	 * celestial body, modelled as a sphere with the scenario radius. The hit
+	 * is kept if it is closer than the closest hit so far. A ray line
+	 * starting below the surface hits the terrain at its origin.
+	 */
+	void SceneManager::intersectSphere(Ray &r, Line3d &rayLine, Intersection &closestHit, double &distance) const {
+
+		Vector3d ab = rayLine.destination - rayLine.origin;
+		double a = ab * ab;
+		double b = 2 * (rayLine.origin * ab);
+		double c = rayLine.origin * rayLine.origin - R * R;
+		double discriminant = b * b - 4 * a * c;
+
+		double t;
+		if (c <= 0) {
+			t = 0;
+		} else if (discriminant < 0 || a == 0) {
+			return;
+		} else {
+			// the nearest root, where the line enters the sphere
+			t = (-b - sqrt(discriminant)) / (2 * a);
+			if (t < 0 || t > 1) {
+				return;
+			}
+		}
 
-		return finalHit;
+		Vector3d pos = rayLine.origin + ab * t;
+		double hitDistance = r.o.distance(pos);
+		if (hitDistance < distance) {
+			closestHit.pos = pos;
+			closestHit.normal = pos.norm();
+			closestHit.o = GeometryType::terrain;
+			distance = hitDistance;
+		}
+	}
+
+	/**
+	 * Bucket the scene objects in a uniform grid of cells, so that
+	 * intersect only tests the objects near the ray instead of the
+	 * whole scene. The index is dropped whenever the scene changes.
+	 */
+	void SceneManager::buildIndex() {
+
+		_cellKeys.clear();
+		_cellStart.clear();
+		_cellObjects.clear();
+		_indexed = false;
+		_maxObjectSize = 0;
+
+		double maxCoordinate = 0;
+		for (Geometry* gp : _sceneObjectsVector) {
+			Vector3d &c = gp->mesh3d.centerpoint;
+			_maxObjectSize = max(_maxObjectSize, gp->mesh3d.size);
+			maxCoordinate = max(maxCoordinate, max(abs(c.x), max(abs(c.y), abs(c.z))));
+		}
+
+		// cells are about the size of the largest object, but the cell
+		// coordinates of all objects must fit in CELL_BITS
+		_cellSize = max(_maxObjectSize, 2.0 * maxCoordinate / CELL_OFFSET);
+		if (_sceneObjectsVector.empty() || _cellSize <= 0) {
+			return;
+		}
+
+		vector< pair<uint64_t, int> > entries;
+		entries.reserve(_sceneObjectsVector.size());
+		for (size_t i = 0; i < _sceneObjectsVector.size(); i++) {
+			Vector3d &c = _sceneObjectsVector[i]->mesh3d.centerpoint;
+			entries.push_back(make_pair(getCellKey(getCellCoordinate(c.x), getCellCoordinate(c.y),
+					getCellCoordinate(c.z)), (int)i));
+		}
+		std::sort(entries.begin(), entries.end());
+
+		_cellObjects.reserve(entries.size());
+		for (size_t k = 0; k < entries.size(); k++) {
+			if (k == 0 || entries[k].first != entries[k - 1].first) {
+				_cellKeys.push_back(entries[k].first);
+				_cellStart.push_back(k);
+			}
+			_cellObjects.push_back(entries[k].second);
+		}
+		_cellStart.push_back(entries.size());
+		_indexed = true;
+
+		BOOST_LOG_TRIVIAL(info) << "Scene index: " << _sceneObjectsVector.size() << " objects in "
+				<< _cellKeys.size() << " cells of " << _cellSize << " m";
+	}
+
+	bool SceneManager::isIndexed() const {
+
+		return _indexed;
+	}
+
+	int SceneManager::getCellCoordinate(double position) const {
+
+		double cell = floor(position / _cellSize);
+
+		return (int)max(-(double)CELL_OFFSET, min((double)CELL_OFFSET - 1, cell));
+	}
+
+	uint64_t SceneManager::getCellKey(int x, int y, int z) const {
+
+		return ((uint64_t)(x + CELL_OFFSET) << (2 * CELL_BITS))
+				| ((uint64_t)(y + CELL_OFFSET) << CELL_BITS)
+				| (uint64_t)(z + CELL_OFFSET);
 	}
 
 	/**
@@ -180,12 +465,18 @@ namespace scene {
 	void SceneManager::addToScene(Geometry* obj) {
 
 		_sceneObjectsVector.push_back(obj);
+		_indexed = false;
+
+		// Line3d::intersect accepts hits up to half the mesh size from the
+		// centerpoint along each axis
+		Vector3d &c = obj->mesh3d.centerpoint;
+		_maxObjectReach = max(_maxObjectReach, sqrt(c * c + 0.75 * pow(obj->mesh3d.size, 2)));
 	}
 
 	/**
 	 * Return a list of all objects in the scene
 	 */
-	vector<Geometry*> SceneManager::getScene() {
+	const vector<Geometry*>& SceneManager::getScene() const {
 
 		return _sceneObjectsVector;
 	}
@@ -196,6 +487,8 @@ namespace scene {
 	void SceneManager::removeAllFromScene() {
 
 		_sceneObjectsVector.clear();
+		_indexed = false;
+		_maxObjectReach = 0;
 	}
 
 	/**
@@ -204,6 +497,7 @@ namespace scene {
 	void SceneManager::sortScene() {
 
 		std::sort(_sceneObjectsVector.begin(), _sceneObjectsVector.end(), Geometry::Compare());
+		_indexed = false;
 	}
 
 } /* namespace scene */
@@ -9,11 +9,14 @@
 #define SCENEMANAGER_H_
 
 #include <list>
+#include <cstdint>
 #include <vector> // the general-purpose vector container
 #include "../math/Line2d.h"
 #include "../math/Line3d.h"
 #include "../tracer/Ray.h"
 #include "../tracer/Intersection.h"
+#include "../core/SimulationContext.h"
+#include "IonosphereTable.h"
 #include "Geometry.h"
 
 namespace raytracer {
@@ -28,14 +31,34 @@ namespace scene {
 			SceneManager();
 
 			/**
-			 * Find which object in the scene intersects with a ray
+			 * Find which object in the scene intersects with a ray. The scene
+			 * is not modified, so this may be called from multiple threads at
+			 * once without locking.
 			 */
-			Intersection intersect(Ray &r, Line3d &rayLine);
+			Intersection intersect(Ray &r, Line3d &rayLine) const;
 
 			/**
-			 *  Load celestial and application configuration values
+			 * Distance over which the ray can travel in a straight line along
+			 * its direction without interacting with the scene: through vacuum
+			 * below and above the ionosphere, and through ionospheric layers
+			 * with a negligible plasma frequency. Returns 0 if skipping would
+			 * not save any steps.
 			 */
-			void loadStaticEnvironment();
+			double getSkipDistance(Ray &r) const;
+
+			/**
+			 *  Load celestial and application configuration values. The context
+			 *  and the table must outlive this scene manager. Without a (built)
+			 *  table, electron densities are evaluated for every layer.
+			 */
+			void loadStaticEnvironment(const core::SimulationContext &context,
+					const IonosphereTable *table = nullptr);
+
+			/**
+			 * The table from which electron densities of ionospheric layers
+			 * are taken, or nullptr if they are evaluated for every layer
+			 */
+			const IonosphereTable* getIonosphereTable() const;
 
 			/**
 			 * Add an object to the scene
@@ -50,13 +73,21 @@ namespace scene {
 			/**
 			 * Return a list of all objects in the scene
 			 */
-			std::vector<Geometry*> getScene();
+			const std::vector<Geometry*>& getScene() const;
 
 			/**
 			 * Sort all the objects in the scene by altitude for easier lookup
 			 */
 			void sortScene();
 
+			/**
+			 * Bucket the scene objects in a uniform grid of cells, so that
+			 * intersect only tests the objects near the ray instead of the
+			 * whole scene. The index is dropped whenever the scene changes.
+			 */
+			void buildIndex();
+			bool isIndexed() const;
+
 		private:
 			/**
 			 * Retrieve a list of scene objects which have a possibility of
@@ -65,13 +96,42 @@ namespace scene {
 			std::vector<Geometry*> getPossibleHits(Ray &r, Line3d & rayLine);
 			bool isInvalid(Geometry* g);
 
+			/**
+			 * Test a single scene object for intersection with the ray line.
+			 * The hit is kept if it is closer than the closest hit so far,
+			 * ties are won by the object which comes first in the scene.
+			 */
+			void testHit(int index, Ray &r, Line3d &rayLine, Intersection &closestHit,
+					double &distance, int &closestIndex) const;
+			void intersectSphere(Ray &r, Line3d &rayLine, Intersection &closestHit, double &distance) const;
+			double getVacuumSkipDistance(Ray &r) const;
+			double getLayerSkipDistance(Ray &r) const;
+			uint64_t getCellKey(int x, int y, int z) const;
+			int getCellCoordinate(double position) const;
+
 			std::vector<Geometry*> _sceneObjectsVector;
 
-			double dh;
-			double minH;
-			double maxH;
-			double R;
-			double angularStepSize;
+			// scene index: object indices grouped per cell, cells sorted by key
+			std::vector<uint64_t> _cellKeys;
+			std::vector<int> _cellStart;
+			std::vector<int> _cellObjects;
+			double _cellSize = 0;
+			double _maxObjectSize = 0;
+			double _maxObjectReach = 0;			// m, from the center, of any point where an object can be hit
+			bool _indexed = false;
+
+			static constexpr int CELL_BITS = 21;
+			static constexpr int CELL_OFFSET = 1 << (CELL_BITS - 1);
+			static constexpr double INDEX_MARGIN = 1.0;		// m, absorbs rounding in Line3d::intersect
+			static constexpr double SKIP_MARGIN = 1e-3;		// m, places skipped rays beyond band boundaries
+
+			const core::SimulationContext *_context = nullptr;
+			const IonosphereTable *_table = nullptr;
+			double dh = 0;
+			double minH = 0;
+			double maxH = 0;
+			double R = 0;
+			double angularStepSize = 0;
 	};
 
 } /* namespace scene */
@@ -0,0 +1,211 @@
+//============================================================================
+// Name        : Scheduler.cpp
+// Author      : Rian van Gijlswijk
+// Description : Work-stealing scheduler of the tracing tasks
+//============================================================================
+
+#include <algorithm>
+#include "Scheduler.h"
+
+namespace raytracer {
+namespace threading {
+
+	constexpr size_t Scheduler::CHUNKS_PER_THREAD;
+	constexpr size_t Scheduler::MAX_CHUNK_SIZE;
+
+	Scheduler::Scheduler(int numThreads) {
+
+		_remaining.store(0);
+		_numSteals.store(0);
+		_cancelled.store(false);
+
+		numThreads = std::max(1, numThreads);
+		for (int t = 0; t < numThreads; t++) {
+			_queues.push_back(std::unique_ptr<Queue>(new Queue()));
+		}
+		for (int t = 0; t < numThreads; t++) {
+			_threads.create_thread(boost::bind(&Scheduler::loop, this, t));
+		}
+	}
+
+	Scheduler::~Scheduler() {
+
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			_stopping = true;
+		}
+		_started.notify_all();
+		_threads.join_all();
+	}
+
+	/**
+	 * Every thread is given a contiguous part of the range, from which it
+	 * takes chunks. The chunks are only cut when they are taken, so the
+	 * queues do not grow with the size of the range.
+	 */
+	void Scheduler::run(size_t numItems, const Task &task) {
+
+		if (numItems == 0) {
+			return;
+		}
+
+		size_t numThreads = _queues.size();
+
+		// the task is published before the chunks, which threads still
+		// working on the previous run may take right away
+		boost::mutex::scoped_lock lock(_mutex);
+		_task = &task;
+		_remaining.store(numItems);
+		_chunkSize = getChunkSize(numItems);
+		for (size_t t = 0; t < numThreads; t++) {
+			Chunk part = {t * numItems / numThreads, (t + 1) * numItems / numThreads};
+			if (part.end > part.begin) {
+				boost::mutex::scoped_lock queueLock(_queues[t]->mutex);
+				_queues[t]->chunks.push_back(part);
+			}
+		}
+
+		_generation++;
+		_started.notify_all();
+
+		while (_remaining.load() > 0) {
+			_finished.wait(lock);
+		}
+		_task = nullptr;
+	}
+
+	size_t Scheduler::getChunkSize(size_t numItems) const {
+
+		size_t chunkSize = numItems / (_queues.size() * CHUNKS_PER_THREAD);
+		return std::max((size_t)1, std::min(MAX_CHUNK_SIZE, chunkSize));
+	}
+
+	int Scheduler::getNumThreads() const {
+
+		return _queues.size();
+	}
+
+	void Scheduler::cancel() {
+
+		_cancelled.store(true);
+	}
+
+	bool Scheduler::isCancelled() const {
+
+		return _cancelled.load();
+	}
+
+	uint64_t Scheduler::getNumSteals() const {
+
+		return _numSteals.load();
+	}
+
+	/**
+	 * Main loop of a thread: wait for a run, and work on it until there are
+	 * no chunks left
+	 */
+	void Scheduler::loop(int thread) {
+
+		uint64_t generation = 0;
+		boost::mutex::scoped_lock lock(_mutex);
+		while (true) {
+			while (_generation == generation && !_stopping) {
+				_started.wait(lock);
+			}
+			if (_stopping) {
+				return;
+			}
+
+			generation = _generation;
+			lock.unlock();
+			work(thread);
+			lock.lock();
+		}
+	}
+
+	/**
+	 * The task is only used while a chunk is held, a run does not end
+	 * before all of its chunks are done
+	 */
+	void Scheduler::work(int thread) {
+
+		Chunk chunk;
+		while (true) {
+			if (!pop(thread, chunk)) {
+				if (steal(thread)) {
+					continue;
+				}
+				return;
+			}
+
+			for (size_t index = chunk.begin; index < chunk.end && !_cancelled.load(std::memory_order_relaxed); index++) {
+				(*_task)(index);
+			}
+
+			size_t size = chunk.end - chunk.begin;
+			if (_remaining.fetch_sub(size) == size) {
+				boost::mutex::scoped_lock lock(_mutex);
+				_finished.notify_all();
+			}
+		}
+	}
+
+	/**
+	 * Cut a chunk from the front of the first range of the thread
+	 */
+	bool Scheduler::pop(int thread, Chunk &chunk) {
+
+		Queue &queue = *_queues[thread];
+		boost::mutex::scoped_lock lock(queue.mutex);
+		if (queue.chunks.empty()) {
+			return false;
+		}
+
+		Chunk &front = queue.chunks.front();
+		chunk.begin = front.begin;
+		chunk.end = std::min(front.begin + _chunkSize, front.end);
+		front.begin = chunk.end;
+		if (front.begin == front.end) {
+			queue.chunks.pop_front();
+		}
+		return true;
+	}
+
+	/**
+	 * Move the last range of the first thread which has any to the queue of
+	 * this thread. If it is the only range left, its first half is left to
+	 * the thread.
+	 */
+	bool Scheduler::steal(int thread) {
+
+		int numThreads = _queues.size();
+		for (int offset = 1; offset < numThreads; offset++) {
+			Queue &victim = *_queues[(thread + offset) % numThreads];
+			Chunk range;
+			{
+				boost::mutex::scoped_lock lock(victim.mutex);
+				if (victim.chunks.empty()) {
+					continue;
+				}
+
+				range = victim.chunks.back();
+				victim.chunks.pop_back();
+				if (victim.chunks.empty() && range.end - range.begin > 1) {
+					size_t middle = range.begin + (range.end - range.begin) / 2;
+					Chunk kept = {range.begin, middle};
+					victim.chunks.push_back(kept);
+					range.begin = middle;
+				}
+			}
+
+			Queue &queue = *_queues[thread];
+			boost::mutex::scoped_lock lock(queue.mutex);
+			queue.chunks.push_back(range);
+			_numSteals++;
+			return true;
+		}
+		return false;
+	}
+
+} /* namespace threading */
+} /* namespace raytracer */
@@ -0,0 +1,110 @@
+//============================================================================
+// Name        : Scheduler.h
+// Author      : Rian van Gijlswijk
+// Description : Work-stealing scheduler which runs a task for every index of
+//				 a range on a fixed set of threads. Every thread has a deque
+//				 of ranges of indices, from which it takes chunks; a thread
+//				 which runs out of work steals from the others.
+//============================================================================
+
+#ifndef THREADING_SCHEDULER_H_
+#define THREADING_SCHEDULER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <boost/thread.hpp>
+
+namespace raytracer {
+namespace threading {
+
+	class Scheduler {
+
+		public:
+			typedef std::function<void(size_t)> Task;
+
+			/**
+			 * Start numThreads threads, which wait for run() to be called
+			 */
+			Scheduler(int numThreads);
+			~Scheduler();
+
+			/**
+			 * Run task(index) for every index in [0, numItems) and wait until
+			 * all have finished. Consecutive indices are mostly run by the
+			 * same thread, in increasing order.
+			 */
+			void run(size_t numItems, const Task &task);
+
+			/**
+			 * Skip the indices which have not been started, in this and all
+			 * later runs. Only stores a flag, so that it can be called from a
+			 * signal handler.
+			 */
+			void cancel();
+			bool isCancelled() const;
+
+			/**
+			 * Number of indices per chunk for a run of numItems. Every thread
+			 * gets several chunks, so that chunks can be stolen when some
+			 * indices take much longer than others.
+			 */
+			size_t getChunkSize(size_t numItems) const;
+
+			int getNumThreads() const;
+
+			/**
+			 * Number of chunks taken from another thread, since the start
+			 */
+			uint64_t getNumSteals() const;
+
+			static constexpr size_t CHUNKS_PER_THREAD = 16;
+			static constexpr size_t MAX_CHUNK_SIZE = 64;
+
+		private:
+			struct Chunk {
+				size_t begin;
+				size_t end;
+			};
+
+			/**
+			 * Ranges of indices of a thread. The owner takes chunks from the
+			 * front, other threads steal ranges from the back.
+			 */
+			struct Queue {
+				boost::mutex mutex;
+				std::deque<Chunk> chunks;
+				// keeps the locks of two threads out of the same cache line
+				char padding[64];
+			};
+
+			Scheduler(Scheduler const&);			// Don't Implement
+			void operator = (Scheduler const&);	// Don't implement
+			void loop(int thread);
+			void work(int thread);
+			bool pop(int thread, Chunk &chunk);
+			bool steal(int thread);
+
+			std::vector<std::unique_ptr<Queue> > _queues;
+			boost::thread_group _threads;
+
+			boost::mutex _mutex;
+			boost::condition_variable _started;
+			boost::condition_variable _finished;
+			const Task *_task = nullptr;
+			uint64_t _generation = 0;
+			bool _stopping = false;
+			size_t _chunkSize = 1;
+			std::atomic<size_t> _remaining;
+			std::atomic<uint64_t> _numSteals;
+			std::atomic<bool> _cancelled;
+	};
+
+} /* namespace threading */
+} /* namespace raytracer */
+
+#endif /* THREADING_SCHEDULER_H_ */
@@ -8,44 +8,79 @@
 #include <cmath>
 #include <boost/log/trivial.hpp>
 #include "Worker.h"
+#include "../tracer/Tracer.h"
+#include "../tracer/PacketTracer.h"
+#include "../tracer/HaselgroveTracer.h"
 #include "../core/Application.h"
 #include "../core/CommandLine.h"
+#include "../core/TracingStatistics.h"
 
 namespace raytracer {
 namespace threading {
 
 	using namespace math;
 	using namespace tracer;
+	using namespace scene;
 	using namespace boost::log;
 
 	Worker::Worker() {
 
 	}
 
-	boost::thread* Worker::start(Ray r) {
-
-		return new boost::thread(&Worker::process, this, r);
-	}
-
-	void Worker::process(Ray r) {
+	Tracer::traceState Worker::process(Ray r) {
 
 		BOOST_LOG_TRIVIAL(info) << "Worker started for ray " << r.rayNumber;
 
-		r.trace();
+		const SimulationContext &context = Application::getInstance().getSimulationContext();
+		Tracer::traceState state;
+		if (context.engine == SimulationContext::engine_haselgrove
+				|| context.engine == SimulationContext::engine_linear_layers) {
+			HaselgroveTracer tracer(r, context);
+			state = tracer.run();
+		} else {
+			std::shared_ptr<const SceneManager> scene = Application::getInstance().getSceneManager();
+			Tracer tracer(r, context, *scene);
+			state = tracer.run();
+		}
+		TracingStatistics::local().recordTermination(state);
 
 		BOOST_LOG_TRIVIAL(info) << "Worker ended for ray " << r.rayNumber;
 
+		int numCompleted = ++Application::getInstance().numCompletedWorkers;
 		if (Application::getInstance().getVerbosity() > boost::log::trivial::info) {
 			char buffer[80];
-			sprintf(buffer, "Progress: %d/%d (%4.2f\%)", r.rayNumber, Application::getInstance().numWorkers,
-					100.0*r.rayNumber/((double)Application::getInstance().numWorkers));
+			sprintf(buffer, "Progress: %d/%d (%4.2f%%)", numCompleted, Application::getInstance().numWorkers,
+					100.0*numCompleted/((double)Application::getInstance().numWorkers));
 			CommandLine::getInstance().updateBody(buffer);
 		}
+
+		return state;
 	}
 
-	void Worker::schedule(boost::threadpool::pool *tp, Ray r) {
+	std::vector<Tracer::traceState> Worker::processPacket(std::vector<Ray> rays) {
+
+		BOOST_LOG_TRIVIAL(info) << "Worker started for rays " << rays.front().rayNumber << " to " << rays.back().rayNumber;
+
+		std::shared_ptr<const SceneManager> scene = Application::getInstance().getSceneManager();
+		PacketTracer tracer(Application::getInstance().getSimulationContext(), *scene);
+		tracer.run(rays.data(), rays.size());
+		std::vector<Tracer::traceState> states;
+		for (int lane = 0; lane < (int)rays.size(); lane++) {
+			states.push_back(tracer.getState(lane));
+			TracingStatistics::local().recordTermination(states.back());
+		}
+
+		BOOST_LOG_TRIVIAL(info) << "Worker ended for rays " << rays.front().rayNumber << " to " << rays.back().rayNumber;
+
+		int numCompleted = Application::getInstance().numCompletedWorkers += rays.size();
+		if (Application::getInstance().getVerbosity() > boost::log::trivial::info) {
+			char buffer[80];
+			sprintf(buffer, "Progress: %d/%d (%4.2f%%)", numCompleted, Application::getInstance().numWorkers,
+					100.0*numCompleted/((double)Application::getInstance().numWorkers));
+			CommandLine::getInstance().updateBody(buffer);
+		}
 
-		tp->schedule(boost::bind(&Worker::process, this, r));
+		return states;
 	}
 
 } /* namespace threading */
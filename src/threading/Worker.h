@@ -1,16 +1,16 @@
 //============================================================================
 // Name        : Worker.h
 // Author      : Rian van Gijlswijk
-// Description : Worker handles the raytracing of one ray. This allows multi-
-//				 threading of raytracing
+// Description : Worker handles the raytracing of one ray, or of a packet of
+//				 rays. Workers are run by the Scheduler.
 //============================================================================
 
 #ifndef WORKER_H_
 #define WORKER_H_
 
+#include <vector>
 #include "../tracer/Ray.h"
-#include "../../contrib/threadpool/threadpool.hpp"
-#include <boost/thread.hpp>
+#include "../tracer/Tracer.h"
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
 
@@ -23,12 +23,17 @@ namespace threading {
 
 		public:
 			Worker();
-			boost::thread* start(Ray r);
-			void process(Ray r);
-			void schedule(boost::threadpool::pool *tp, Ray r);
 
-		private:
-			boost::thread thread;
+			/**
+			 * Trace a ray, return the state its tracing ended in
+			 */
+			Tracer::traceState process(Ray r);
+
+			/**
+			 * Trace a packet of rays together, see PacketTracer. Returns the
+			 * state the tracing of each ray ended in.
+			 */
+			std::vector<Tracer::traceState> processPacket(std::vector<Ray> rays);
 	};
 
 } /* namespace threading */
@@ -0,0 +1,559 @@
+//============================================================================
+// Name        : HaselgroveTracer.cpp
+// Author      : Rian van Gijlswijk
+// Description : Tracing engine which integrates the Haselgrove ray equations
+//============================================================================
+
+#include <cmath>
+#include <algorithm>
+#include "HaselgroveTracer.h"
+#include "../core/Application.h"
+#include "../core/TracingStatistics.h"
+#include "../scene/Ionosphere.h"
+#include "../math/Constants.h"
+
+namespace raytracer {
+namespace tracer {
+
+	using namespace scene;
+	using namespace core;
+	using namespace math;
+
+	namespace {
+
+		// Dormand-Prince 5(4) tableau
+		const double A21 = 1.0/5;
+		const double A31 = 3.0/40, A32 = 9.0/40;
+		const double A41 = 44.0/45, A42 = -56.0/15, A43 = 32.0/9;
+		const double A51 = 19372.0/6561, A52 = -25360.0/2187, A53 = 64448.0/6561, A54 = -212.0/729;
+		const double A61 = 9017.0/3168, A62 = -355.0/33, A63 = 46732.0/5247, A64 = 49.0/176, A65 = -5103.0/18656;
+		const double B1 = 35.0/384, B3 = 500.0/1113, B4 = 125.0/192, B5 = -2187.0/6784, B6 = 11.0/84;
+
+		// difference between the fifth and fourth order solutions
+		const double E1 = 71.0/57600, E3 = -71.0/16695, E4 = 71.0/1920, E5 = -17253.0/339200,
+				E6 = 22.0/525, E7 = -1.0/40;
+	}
+
+	HaselgroveTracer::HaselgroveTracer(Ray &r, const SimulationContext &context)
+			: _ray(r), _context(context) {
+
+		_state = Tracer::state_tracing;
+		_angularFrequency = 2 * Constants::PI * r.frequency;
+		_stepSize = context.ionosphereStep > 0 ? context.ionosphereStep : 1000;
+		_statistics = &TracingStatistics::local();
+	}
+
+	/**
+	 * Perform one step. The ray keeps tracing until it hits the ground,
+	 * leaves the scene or exceeds the tracing limit.
+	 */
+	Tracer::traceState HaselgroveTracer::step() {
+
+		if (isTerminated()) {
+			return _state;
+		}
+
+		// isnan check
+		if (_ray.o.x != _ray.o.x || _ray.o.y != _ray.o.y) {
+			_state = Tracer::state_nan;
+			return _state;
+		}
+
+		// limit the simulation to avoid unnecessary calculations
+		if (_ray.o.distance(Vector3d(0,0,0)) > _context.sceneBoundary) {
+			BOOST_LOG_TRIVIAL(info) << "Ray " << _ray.rayNumber << " result: Out of scene bounds!";
+			_state = Tracer::state_out_of_bounds;
+			return _state;
+		}
+		if (_ray.tracings >= _context.tracingLimit) {
+			BOOST_LOG_TRIVIAL(info) << "Ray " << _ray.rayNumber << " result: Tracing limit exceeded!";
+			_state = Tracer::state_tracing_limit;
+			return _state;
+		}
+
+		_ray.updateAltitude(_context.radius);
+
+		if (!_inIonosphere && isInIonosphere(_ray.altitude)) {
+			enterIonosphere();
+		}
+
+		if (isTerminated()) {
+			return _state;
+		} else if (_inIonosphere && _context.engine == SimulationContext::engine_linear_layers) {
+			crossLayer();
+		} else if (_inIonosphere) {
+			integrate();
+		} else {
+			propagate();
+		}
+
+		return _state;
+	}
+
+	/**
+	 * Move the ray in a straight line to the ionosphere, the terrain or
+	 * the scene boundary. Exported as a step without collision, or as a
+	 * terrain hit.
+	 */
+	void HaselgroveTracer::propagate() {
+
+		Vector3d direction = _ray.d.norm();
+		double b = _ray.o * direction;
+		double c = _ray.o * _ray.o;
+		double bottom = _context.radius + _context.ionosphereStart;
+		double top = _context.radius + _context.ionosphereEnd;
+
+		// distance along the line to the sphere with radius R is
+		// -b +- sqrt(b^2 - |o|^2 + R^2)
+		double distance;
+		GeometryType type = GeometryType::none;
+		if (sqrt(c) < bottom) {
+			double terrain = b * b - c + pow(_context.radius, 2);
+			if (b < 0 && terrain >= 0) {
+				distance = -b - sqrt(terrain);
+				type = GeometryType::terrain;
+			} else {
+				distance = -b + sqrt(b * b - c + pow(bottom, 2)) + BOUNDARY_MARGIN;
+			}
+		} else {
+			double ionosphere = b * b - c + pow(top, 2);
+			if (b < 0 && ionosphere >= 0) {
+				distance = -b - sqrt(ionosphere) + BOUNDARY_MARGIN;
+			} else {
+				distance = -b + sqrt(b * b - c + pow(_context.sceneBoundary, 2)) + BOUNDARY_MARGIN;
+			}
+		}
+
+		Vector3d destination = _ray.o + direction * distance;
+
+		_ray.lastHitType = type;
+		_ray.lastHitNormal = Vector3d();
+		_ray.lastHitPos = destination;
+		_ray.calculateTimeOfFlight(destination);
+
+		_statistics->increment(TracingStatistics::counter_steps);
+		_ray.tracings++;
+
+		_ray.prev = _ray.d;
+		_ray.o = destination;
+		_ray.exportData(type);
+
+		if (type == GeometryType::terrain) {
+			BOOST_LOG_TRIVIAL(info) << "Ray " << _ray.rayNumber << " result: terrain";
+			_state = Tracer::state_terrain;
+		}
+	}
+
+	/**
+	 * Perform one accepted integration step through the ionosphere. A step
+	 * is retried with a smaller size if its error exceeds the tolerance, or
+	 * if it ends too far beyond the boundaries of the ionosphere.
+	 */
+	void HaselgroveTracer::integrate() {
+
+		double y[STATE_SIZE], dydt[STATE_SIZE];
+		double h = _stepSize;
+		double error, altitude;
+
+		while (true) {
+			error = attemptStep(h, y, dydt);
+			if (error != error) {
+				_state = Tracer::state_nan;
+				return;
+			}
+
+			if (error > 1 && h > MIN_STEP) {
+				_rejectedSteps++;
+				h = std::max(MIN_STEP, h * std::max(0.2, 0.9 * pow(error, -0.2)));
+				continue;
+			}
+
+			altitude = sqrt(y[0] * y[0] + y[1] * y[1] + y[2] * y[2]) - _context.radius;
+			double boundary = altitude < _context.ionosphereStart ? _context.ionosphereStart : _context.ionosphereEnd;
+			if (!isInIonosphere(altitude) && std::abs(altitude - boundary) > BOUNDARY_TOLERANCE && h > MIN_STEP) {
+				// aim for the boundary, assuming the altitude changes linearly over the step
+				double fraction = (boundary - _ray.altitude) / (altitude - _ray.altitude);
+				h = std::max(MIN_STEP, h * fraction + 0.5 * BOUNDARY_TOLERANCE);
+				continue;
+			}
+
+			break;
+		}
+
+		std::copy(dydt, dydt + STATE_SIZE, _dydt);
+		advance(h, y);
+
+		double growth = error > 0 ? 0.9 * pow(error, -0.2) : 5.0;
+		_stepSize = std::min(MAX_STEP, h * std::min(5.0, std::max(0.2, growth)));
+	}
+
+	/**
+	 * Cross one layer of the piecewise linear medium. With n^2 = a + g * z in
+	 * the flat-layer approximation, where z is the altitude along the vertical
+	 * at the start of the layer, the ray equations have the exact solution
+	 *  r(P') = r0 + k0 * P' + g/4 * P'^2 * up
+	 *  k(P') = k0 + g/2 * P' * up
+	 * which is followed until the spherical altitude leaves the layer.
+	 */
+	void HaselgroveTracer::crossLayer() {
+
+		Vector3d origin = _ray.o;
+		double distance = origin.magnitude();
+		Vector3d up = origin / distance;
+		double altitude = distance - _context.radius;
+		Vector3d k = Vector3d(_y[3], _y[4], _y[5]);
+		double verticalK = k * up;
+
+		// a ray on a boundary crosses the layer in its direction
+		double dh = _context.ionosphereStep;
+		int numLayers = std::max(1, (int)ceil((_context.ionosphereEnd - _context.ionosphereStart) / dh));
+		double position = (altitude - _context.ionosphereStart) / dh;
+		int layer = verticalK >= 0 ? (int)floor(position) : (int)ceil(position) - 1;
+		layer = std::min(std::max(layer, 0), numLayers - 1);
+		double bottom = _context.ionosphereStart + layer * dh;
+		double top = std::min(_context.ionosphereEnd, bottom + dh);
+
+		double SZA = acos(up * Vector3d::SUBSOLAR);
+		double lower = getRefractiveIndexSquared(bottom, SZA);
+		double gradient = (getRefractiveIndexSquared(top, SZA) - lower) / (top - bottom);
+		double refractiveIndexSquared = lower + gradient * (altitude - bottom);
+
+		// the medium is discontinuous between layers in spherical geometry.
+		// Keep the horizontal wave vector (Snell's law) and match |k| = n.
+		Vector3d horizontalK = k - up * verticalK;
+		double verticalKSquared = refractiveIndexSquared - horizontalK * horizontalK;
+		if (verticalKSquared > 0) {
+			k = horizontalK + up * (verticalK >= 0 ? sqrt(verticalKSquared) : -sqrt(verticalKSquared));
+		} else {
+			k = horizontalK - up * verticalK;
+		}
+
+		double c = 0.25 * gradient;
+		double exitPath = getLayerExitPath(origin, k, up, c, bottom, top);
+		Vector3d destination = origin + k * exitPath + up * (c * exitPath * exitPath);
+
+		double y[STATE_SIZE];
+		y[0] = destination.x;
+		y[1] = destination.y;
+		y[2] = destination.z;
+		y[3] = k.x + up.x * (2 * c * exitPath);
+		y[4] = k.y + up.y * (2 * c * exitPath);
+		y[5] = k.z + up.z * (2 * c * exitPath);
+
+		// signal loss by Simpson's rule, with the electron number density of
+		// the linear medium
+		double X = getPlasmaFrequencyFactor();
+		double loss = 0;
+		for (int i = 0; i <= 2; i++) {
+			double path = 0.5 * i * exitPath;
+			double z = altitude + (k * up) * path + c * path * path;
+			double electronNumberDensity = (1 - (lower + gradient * (z - bottom))) / X;
+			Vector3d waveVector = k + up * (2 * c * path);
+			double point = (origin + k * path + up * (c * path * path)).magnitude() - _context.radius;
+			loss += (i == 1 ? 4 : 1) * getAbsorption(electronNumberDensity, point) * waveVector.magnitude();
+		}
+		y[6] = _y[6] + loss * exitPath / 6;
+
+		advance(exitPath, y);
+	}
+
+	/**
+	 * Group path after which the parabolic path leaves the layer between
+	 * the altitudes bottom and top. The path is sampled up to the exit in
+	 * the flat-layer approximation and beyond, the crossing is bisected.
+	 */
+	double HaselgroveTracer::getLayerExitPath(Vector3d origin, Vector3d k, Vector3d up, double c,
+			double bottom, double top) {
+
+		double altitude = origin.magnitude() - _context.radius;
+		double a = k * up;
+
+		// smallest positive root of altitude + a * t + c * t^2 = boundary
+		double flatExit = 0;
+		for (double boundary : {bottom, top}) {
+			double d = altitude - boundary;
+			double discriminant = a * a - 4 * c * d;
+			if (discriminant < 0) {
+				continue;
+			}
+			double roots[2];
+			if (c == 0) {
+				roots[0] = roots[1] = a != 0 ? -d / a : 0;
+			} else {
+				roots[0] = (-a - sqrt(discriminant)) / (2 * c);
+				roots[1] = (-a + sqrt(discriminant)) / (2 * c);
+			}
+			for (double root : roots) {
+				if (root > 0 && (flatExit == 0 || root < flatExit)) {
+					flatExit = root;
+				}
+			}
+		}
+		if (flatExit == 0) {
+			flatExit = top - bottom;
+		}
+
+		double inside = 0, outside = 0;
+		double start = 0, end = flatExit;
+		for (int extension = 0; extension < LAYER_EXIT_EXTENSIONS && outside == 0; extension++) {
+			for (int i = 1; i <= LAYER_EXIT_SAMPLES; i++) {
+				double t = start + (end - start) * i / LAYER_EXIT_SAMPLES;
+				double h = (origin + k * t + up * (c * t * t)).magnitude() - _context.radius;
+				if (h < bottom || h > top) {
+					outside = t;
+					break;
+				}
+				inside = t;
+			}
+			start = end;
+			end *= 2;
+		}
+		if (outside == 0) {
+			return inside;
+		}
+
+		// the exit lies beyond the boundary, so the next layer is found
+		while (outside - inside > LAYER_EXIT_PRECISION) {
+			double t = 0.5 * (inside + outside);
+			double h = (origin + k * t + up * (c * t * t)).magnitude() - _context.radius;
+			if (h < bottom || h > top) {
+				outside = t;
+			} else {
+				inside = t;
+			}
+		}
+
+		return outside;
+	}
+
+	/**
+	 * Complete a step of group path h, which ends in state y
+	 */
+	void HaselgroveTracer::advance(double h, const double *y) {
+
+		Vector3d destination = Vector3d(y[0], y[1], y[2]);
+		Vector3d k = Vector3d(y[3], y[4], y[5]);
+
+		_ray.timeOfFlight += h / Constants::C;
+		_ray.signalPower += y[6] - _y[6];
+		std::copy(y, y + STATE_SIZE, _y);
+
+		_statistics->increment(TracingStatistics::counter_steps);
+		_ray.tracings++;
+
+		// on the dispersion surface |k| = n
+		double refractiveIndex = k.magnitude();
+		_ray.prev = _ray.d;
+		if (refractiveIndex > 0) {
+			_ray.d = k / refractiveIndex;
+		}
+		_ray.previousRefractiveIndex = refractiveIndex;
+		_ray.o = destination;
+		_ray.lastHitType = GeometryType::ionosphere;
+		_ray.lastHitNormal = destination.norm();
+		_ray.lastHitPos = destination;
+		_ray.exportData(GeometryType::ionosphere);
+
+		if (!isInIonosphere(destination.magnitude() - _context.radius)) {
+			_inIonosphere = false;
+		}
+	}
+
+	/**
+	 * Dormand-Prince step of size h from _y. The derivative at the end of the
+	 * step is returned in dydt, and is reused as the first stage of the next step.
+	 */
+	double HaselgroveTracer::attemptStep(double h, double *y, double *dydt) {
+
+		double k2[STATE_SIZE], k3[STATE_SIZE], k4[STATE_SIZE], k5[STATE_SIZE], k6[STATE_SIZE];
+		const double *k1 = _dydt;
+		double stage[STATE_SIZE];
+
+		for (int i = 0; i < STATE_SIZE; i++) {
+			stage[i] = _y[i] + h * A21 * k1[i];
+		}
+		evaluate(stage, k2);
+		for (int i = 0; i < STATE_SIZE; i++) {
+			stage[i] = _y[i] + h * (A31 * k1[i] + A32 * k2[i]);
+		}
+		evaluate(stage, k3);
+		for (int i = 0; i < STATE_SIZE; i++) {
+			stage[i] = _y[i] + h * (A41 * k1[i] + A42 * k2[i] + A43 * k3[i]);
+		}
+		evaluate(stage, k4);
+		for (int i = 0; i < STATE_SIZE; i++) {
+			stage[i] = _y[i] + h * (A51 * k1[i] + A52 * k2[i] + A53 * k3[i] + A54 * k4[i]);
+		}
+		evaluate(stage, k5);
+		for (int i = 0; i < STATE_SIZE; i++) {
+			stage[i] = _y[i] + h * (A61 * k1[i] + A62 * k2[i] + A63 * k3[i] + A64 * k4[i] + A65 * k5[i]);
+		}
+		evaluate(stage, k6);
+		for (int i = 0; i < STATE_SIZE; i++) {
+			y[i] = _y[i] + h * (B1 * k1[i] + B3 * k3[i] + B4 * k4[i] + B5 * k5[i] + B6 * k6[i]);
+		}
+		evaluate(y, dydt);
+
+		// the position is scaled by the distance from the center, the wave
+		// vector by its magnitude in vacuum. The signal loss is not controlled.
+		double positionScale = _context.haselgroveTolerance * sqrt(_y[0] * _y[0] + _y[1] * _y[1] + _y[2] * _y[2]);
+		double waveVectorScale = _context.haselgroveTolerance;
+		double error = 0;
+		for (int i = 0; i < 6; i++) {
+			double e = h * (E1 * k1[i] + E3 * k3[i] + E4 * k4[i] + E5 * k5[i] + E6 * k6[i] + E7 * dydt[i]);
+			double scaled = std::abs(e) / (i < 3 ? positionScale : waveVectorScale);
+			// propagate NaN
+			error = scaled > error || scaled != scaled ? scaled : error;
+		}
+
+		return error;
+	}
+
+	/**
+	 * Derivative of the state: the ray equations and the attenuation of
+	 * Ionosphere::attenuate per unit of path length.
+	 */
+	double HaselgroveTracer::evaluate(const double *y, double *dydt) const {
+
+		dydt[0] = y[3];
+		dydt[1] = y[4];
+		dydt[2] = y[5];
+		dydt[3] = dydt[4] = dydt[5] = dydt[6] = 0;
+
+		double distance = sqrt(y[0] * y[0] + y[1] * y[1] + y[2] * y[2]);
+		double altitude = distance - _context.radius;
+		if (!isInIonosphere(altitude)) {
+			return 1.0;
+		}
+
+		Vector3d up = Vector3d(y[0], y[1], y[2]) / distance;
+		double cosSZA = up * Vector3d::SUBSOLAR;
+		double derivativeAltitude, derivativeCosSZA;
+		double electronNumberDensity = getElectronNumberDensity(altitude, acos(cosSZA),
+				derivativeAltitude, derivativeCosSZA);
+
+		// grad(h) = up, grad(cos(SZA)) = (subsolar - cos(SZA) * up) / |r|
+		Vector3d gradient = up * derivativeAltitude
+				+ (Vector3d::SUBSOLAR - up * cosSZA) * (derivativeCosSZA / distance);
+
+		double X = getPlasmaFrequencyFactor();
+		dydt[3] = -0.5 * X * gradient.x;
+		dydt[4] = -0.5 * X * gradient.y;
+		dydt[5] = -0.5 * X * gradient.z;
+
+		double pathLength = sqrt(y[3] * y[3] + y[4] * y[4] + y[5] * y[5]);
+		dydt[6] = getAbsorption(electronNumberDensity, altitude) * pathLength;
+
+		return 1 - X * electronNumberDensity;
+	}
+
+	/**
+	 * Sum of the chapman layers of the context, and its derivatives with
+	 * respect to the altitude and the cosine of the SZA
+	 */
+	double HaselgroveTracer::getElectronNumberDensity(double altitude, double SZA,
+			double &derivativeAltitude, double &derivativeCosSZA) const {
+
+		double electronNumberDensity = 0;
+		derivativeAltitude = derivativeCosSZA = 0;
+		for (const IonosphereLayerParameters &layer : _context.ionosphereLayers) {
+			double dh, dcos;
+			electronNumberDensity += Ionosphere::getChapmanElectronNumberDensity(layer.electronPeakDensity,
+					layer.peakProductionAltitude, layer.neutralScaleHeight, altitude, SZA, dh, dcos);
+			derivativeAltitude += dh;
+			derivativeCosSZA += dcos;
+		}
+
+		return electronNumberDensity;
+	}
+
+	double HaselgroveTracer::getRefractiveIndexSquared(double altitude, double SZA) const {
+
+		double derivativeAltitude, derivativeCosSZA;
+
+		return 1 - getPlasmaFrequencyFactor()
+				* getElectronNumberDensity(altitude, SZA, derivativeAltitude, derivativeCosSZA);
+	}
+
+	/**
+	 * X per unit of electron number density: e^2 / (m_e * e_0 * w^2)
+	 */
+	double HaselgroveTracer::getPlasmaFrequencyFactor() const {
+
+		return pow(Constants::ELEMENTARY_CHARGE, 2)
+				/ (Constants::ELECTRON_MASS * Constants::PERMITTIVITY_VACUUM * pow(_angularFrequency, 2));
+	}
+
+	/**
+	 * Absorption of Ionosphere::attenuate per unit of path length
+	 * @unit: dB m^-1
+	 */
+	double HaselgroveTracer::getAbsorption(double electronNumberDensity, double altitude) const {
+
+		double collisionFrequency = Ionosphere::getCollisionFrequency(_context.surfaceNCO2, altitude);
+
+		return -4.6e-5 * (electronNumberDensity * collisionFrequency
+				/ (pow(_angularFrequency, 2) + pow(collisionFrequency, 2)));
+	}
+
+	bool HaselgroveTracer::isInIonosphere(double altitude) const {
+
+		return altitude >= _context.ionosphereStart && altitude <= _context.ionosphereEnd;
+	}
+
+	/**
+	 * Start integrating at the current ray position. The wave vector has
+	 * magnitude n, so that the ray starts on the dispersion surface.
+	 */
+	void HaselgroveTracer::enterIonosphere() {
+
+		Vector3d direction = _ray.d.norm();
+		_y[0] = _ray.o.x;
+		_y[1] = _ray.o.y;
+		_y[2] = _ray.o.z;
+		_y[3] = _y[4] = _y[5] = _y[6] = 0;
+
+		double refractiveIndexSquared = evaluate(_y, _dydt);
+		if (refractiveIndexSquared <= 0) {
+			BOOST_LOG_TRIVIAL(info) << "Ray " << _ray.rayNumber << " result: no propagation";
+			_state = Tracer::state_no_propagation;
+			return;
+		}
+
+		double refractiveIndex = sqrt(refractiveIndexSquared);
+		_y[3] = direction.x * refractiveIndex;
+		_y[4] = direction.y * refractiveIndex;
+		_y[5] = direction.z * refractiveIndex;
+		evaluate(_y, _dydt);
+
+		_ray.previousRefractiveIndex = refractiveIndex;
+		_inIonosphere = true;
+	}
+
+	/**
+	 * Step the ray until it terminates and return the final state
+	 */
+	Tracer::traceState HaselgroveTracer::run() {
+
+		while (step() == Tracer::state_tracing);
+
+		return _state;
+	}
+
+	Tracer::traceState HaselgroveTracer::getState() {
+
+		return _state;
+	}
+
+	bool HaselgroveTracer::isTerminated() {
+
+		return _state != Tracer::state_tracing;
+	}
+
+	int HaselgroveTracer::getRejectedSteps() {
+
+		return _rejectedSteps;
+	}
+
+} /* namespace tracer */
+} /* namespace raytracer */
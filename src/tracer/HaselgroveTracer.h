@@ -0,0 +1,158 @@
+//============================================================================
+// Name        : HaselgroveTracer.h
+// Author      : Rian van Gijlswijk
+// Description : Tracing engine which integrates the Haselgrove ray equations
+//				 through a continuous ionosphere, instead of refracting at
+//				 discrete layers. Uses the embedded Dormand-Prince 5(4)
+//				 Runge-Kutta method, so that the step size follows the
+//				 gradients of the refractive index, or the exact solution in
+//				 layers with a linear n^2.
+//============================================================================
+
+#ifndef TRACER_HASELGROVETRACER_H_
+#define TRACER_HASELGROVETRACER_H_
+
+#include "Ray.h"
+#include "Tracer.h"
+#include "../core/SimulationContext.h"
+
+namespace raytracer {
+namespace tracer {
+
+	/**
+	 * The ray equations of an isotropic, unmagnetized plasma with
+	 * n^2 = 1 - X, in the group path P' as independent variable:
+	 *  dr/dP' = k
+	 *  dk/dP' = grad(n^2) / 2
+	 * where |k| = n. The time of flight is P' / c.
+	 * The electron number density is the sum of the chapman layers of the
+	 * context between ionosphere.start and ionosphere.end, evaluated exactly.
+	 * Outside of that band the ray travels in straight lines, and the terrain
+	 * is the sphere with the scenario radius.
+	 * With engine_linear_layers, n^2 is instead interpolated linearly between
+	 * the altitudes ionosphere.step apart, at the SZA where the ray enters a
+	 * layer, and each layer is crossed in a single parabolic step.
+	 */
+	class HaselgroveTracer {
+
+		public:
+			HaselgroveTracer(Ray &r, const core::SimulationContext &context);
+
+			/**
+			 * Advance the ray by a single step: a straight line up to the next
+			 * boundary of the ionosphere or the terrain, or one accepted
+			 * integration step within the ionosphere. Every step is exported.
+			 */
+			Tracer::traceState step();
+
+			/**
+			 * Step the ray until it terminates and return the final state
+			 */
+			Tracer::traceState run();
+
+			Tracer::traceState getState();
+			bool isTerminated();
+
+			/**
+			 * Number of integration steps which were rejected because their
+			 * error estimate exceeded the tolerance
+			 */
+			int getRejectedSteps();
+
+			static constexpr double MIN_STEP = 1e-2;				// m
+			static constexpr double MAX_STEP = 50e3;				// m
+			static constexpr double BOUNDARY_TOLERANCE = 1.0;		// m, allowed overshoot of the ionosphere boundaries
+			static constexpr double BOUNDARY_MARGIN = 1e-3;			// m, places straight lines beyond boundaries
+			static constexpr int LAYER_EXIT_SAMPLES = 8;
+			static constexpr int LAYER_EXIT_EXTENSIONS = 8;
+			static constexpr double LAYER_EXIT_PRECISION = 1e-6;	// m
+
+		private:
+			static constexpr int STATE_SIZE = 7;	// position, wave vector, signal loss [dB]
+
+			/**
+			 * Move the ray in a straight line to the ionosphere, the terrain or
+			 * the scene boundary
+			 */
+			void propagate();
+
+			/**
+			 * Perform one accepted integration step through the ionosphere
+			 */
+			void integrate();
+
+			/**
+			 * Cross one layer of the piecewise linear medium in a single step
+			 */
+			void crossLayer();
+
+			/**
+			 * Group path after which the parabola r0 + k * t + c * t^2 * up
+			 * leaves the layer between the altitudes bottom and top
+			 */
+			double getLayerExitPath(Vector3d origin, Vector3d k, Vector3d up, double c,
+					double bottom, double top);
+
+			/**
+			 * Complete a step of group path h, which ends in state y
+			 */
+			void advance(double h, const double *y);
+
+			/**
+			 * Dormand-Prince step of size h from _y, with _dydt the derivative
+			 * at _y. Returns the error estimate relative to the tolerance.
+			 */
+			double attemptStep(double h, double *y, double *dydt);
+
+			/**
+			 * Derivative of the state. Returns n^2 at the position of the state.
+			 */
+			double evaluate(const double *y, double *dydt) const;
+
+			/**
+			 * Sum of the chapman layers of the context, and its derivatives
+			 * @unit: particles m^-3
+			 */
+			double getElectronNumberDensity(double altitude, double SZA,
+					double &derivativeAltitude, double &derivativeCosSZA) const;
+			double getRefractiveIndexSquared(double altitude, double SZA) const;
+
+			/**
+			 * X = 1 - n^2 per unit of electron number density
+			 */
+			double getPlasmaFrequencyFactor() const;
+
+			/**
+			 * Absorption of Ionosphere::attenuate per unit of path length
+			 * @unit: dB m^-1
+			 */
+			double getAbsorption(double electronNumberDensity, double altitude) const;
+
+			/**
+			 * Whether the altitude lies within the ionosphere
+			 */
+			bool isInIonosphere(double altitude) const;
+
+			/**
+			 * Start integrating at the current ray position, with the wave
+			 * vector along the ray direction
+			 */
+			void enterIonosphere();
+
+			Ray &_ray;
+			const core::SimulationContext &_context;
+			Tracer::traceState _state;
+			bool _inIonosphere = false;
+			double _angularFrequency;
+			double _stepSize;
+			int _rejectedSteps = 0;
+			double _y[STATE_SIZE];
+			double _dydt[STATE_SIZE];
+			// counters of the thread which constructed the tracer
+			core::TracingStatistics *_statistics;
+	};
+
+} /* namespace tracer */
+} /* namespace raytracer */
+
+#endif /* TRACER_HASELGROVETRACER_H_ */
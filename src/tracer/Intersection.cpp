@@ -10,9 +10,16 @@
 namespace raytracer {
 namespace tracer {
 
+	/**
+	 * Shared placeholder for intersections without a scene object, so that
+	 * constructing an intersection does not allocate
+	 */
+	static Geometry emptyGeometry;
+
 	Intersection::Intersection() {
 
-		g = new Geometry();
+		g = &emptyGeometry;
+		normal = emptyGeometry.mesh3d.normal;
 	}
 
 	Intersection::~Intersection() {
@@ -21,6 +28,6 @@ namespace tracer {
 	}
 
 
-} /* namespace engine */
+} /* namespace tracer */
 } /* namespace raytracer */
 
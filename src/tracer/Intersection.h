@@ -13,6 +13,7 @@
 #include "../math/Vector3d.h"
 #include "../scene/Geometry.h"
 #include "../scene/GeometryType.h"
+#include "../scene/IonosphereLayer.h"
 
 namespace raytracer {
 namespace tracer {
@@ -25,25 +26,21 @@ namespace tracer {
 		public:
 			Intersection();
 			~Intersection();
-			Intersection(Intersection const& copy) {
-				r = copy.r;
-				o = copy.o;
-				pos = copy.pos;
-				memcpy(g, copy.g, sizeof g);
-			}
-			Intersection& operator=(const Intersection& rhs) {
-				if (this != &rhs) {
-					r = rhs.r;
-					o = rhs.o;
-					pos = rhs.pos;
-					memcpy(g, rhs.g, sizeof g);
-				}
-				return *this;
-			}
-			Ray r;
 			GeometryType o = GeometryType::none;
 			Geometry* g;
 			Vector3d pos;
+
+			/**
+			 * Normal of the surface that was hit. Not every hit has a
+			 * scene object (e.g. ionospheric layers, analytic terrain).
+			 */
+			Vector3d normal;
+
+			/**
+			 * Layer state, only valid if o is ionosphere. Ionospheric layers
+			 * are not part of the scene and thus have no Geometry.
+			 */
+			IonosphereLayer layer;
 	};
 
 } /* namespace tracer */
@@ -0,0 +1,358 @@
+//============================================================================
+// Name        : PacketTracer.cpp
+// Author      : Rian van Gijlswijk
+// Description : Traces a packet of rays together
+//============================================================================
+
+#include <cmath>
+#include "PacketTracer.h"
+#include "../core/Application.h"
+#include "../core/TracingStatistics.h"
+#include "../exporter/Data.h"
+#include "../scene/Ionosphere.h"
+#include "../math/Constants.h"
+
+namespace raytracer {
+namespace tracer {
+
+	using namespace scene;
+	using namespace core;
+	using namespace exporter;
+	using namespace math;
+
+	PacketTracer::PacketTracer(const SimulationContext &context, const SceneManager &scene)
+			: _context(context), _scene(scene) {
+
+		_table = scene.getIonosphereTable();
+
+		// same source of collision frequencies as Ionosphere::setCollisionFrequency
+		const IonosphereTable &collisionTable = Application::getInstance().getIonosphereTable();
+		_collisionTable = collisionTable.isBuilt() ? &collisionTable : nullptr;
+
+		// the magnetized refractive index is not vectorized
+		_vectorized = _table != nullptr && context.getMagneticFieldStrength() <= 0;
+
+		_run = selectPhysics<RunSelector>(context);
+		_statistics = &TracingStatistics::local();
+	}
+
+	void PacketTracer::run(Ray *rays, int numRays) {
+
+		(this->*_run)(rays, numRays);
+	}
+
+	/**
+	 * Every iteration, the rays which are about to cross an ionospheric layer
+	 * are collected in a packet and advanced together. The remaining rays
+	 * take a single step with their own Tracer, which also decides when a
+	 * ray terminates.
+	 */
+	template <class P>
+	void PacketTracer::runWith(Ray *rays, int numRays) {
+
+		std::vector<Tracer> tracers;
+		tracers.reserve(numRays);
+		for (int i = 0; i < numRays; i++) {
+			tracers.push_back(Tracer(rays[i], _context, _scene));
+		}
+
+		bool tracing = true;
+		while (tracing) {
+			tracing = false;
+			_numSlots = 0;
+			for (int i = 0; i < numRays; i++) {
+				if (tracers[i].isTerminated()) {
+					continue;
+				}
+				tracing = true;
+				if (!P::magneticField && _vectorized && addLayerCrossing<P>(rays[i], _numSlots)) {
+					_lane[_numSlots++] = i;
+				} else {
+					tracers[i].step();
+				}
+			}
+
+			if (_numSlots > 0) {
+				crossLayers(rays);
+			}
+		}
+
+		_states.clear();
+		for (int i = 0; i < numRays; i++) {
+			_states.push_back(tracers[i].getState());
+		}
+	}
+
+	Tracer::traceState PacketTracer::getState(int lane) {
+
+		return _states[lane];
+	}
+
+	bool PacketTracer::isVectorized() {
+
+		return _vectorized;
+	}
+
+	/**
+	 * Repeats the checks of Tracer::step() and SceneManager::intersect() which
+	 * precede a layer crossing. Rays which fail any of them are stepped by
+	 * their Tracer instead.
+	 */
+	template <class P>
+	bool PacketTracer::addLayerCrossing(Ray &r, int slot) {
+
+		// isnan check
+		if (r.o.x != r.o.x || r.o.y != r.o.y) {
+			return false;
+		}
+
+		Vector3d rayEnd;
+		double planar = sqrt(r.d.x * r.d.x + r.d.y * r.d.y);
+		rayEnd.x = r.o.x + Ray::magnitude * (planar > 0 ? r.d.x / planar : 1);
+		rayEnd.y = r.o.y + Ray::magnitude * (planar > 0 ? r.d.y / planar : 0);
+		rayEnd.z = r.o.z + Ray::magnitude * r.d.z;
+
+		if (r.o.distance(Vector3d(0,0,0)) > _context.sceneBoundary || r.tracings >= _context.tracingLimit) {
+			return false;
+		}
+
+		r.updateAltitude(_context.radius);
+		if (P::skipEmptySpace && _scene.getSkipDistance(r) > 0) {
+			return false;
+		}
+
+		double originDistance = r.o.distance(Vector3d::CENTER);
+		bool goingUp = originDistance < rayEnd.distance(Vector3d::CENTER);
+		double nextAltitude;
+		if (goingUp) {
+			nextAltitude = originDistance - _context.radius + _context.ionosphereStep;
+		} else {
+			nextAltitude = originDistance - _context.radius - _context.ionosphereStep;
+		}
+		if (!(nextAltitude >= _context.ionosphereStart && nextAltitude <= _context.ionosphereEnd)) {
+			return false;
+		}
+
+		_verticalSign[slot] = goingUp ? 1 : -1;
+		_nextAltitude[slot] = nextAltitude;
+
+		return true;
+	}
+
+	void PacketTracer::crossLayers(Ray *rays) {
+
+		gather(rays);
+		intersectLayers();
+		interact();
+		scatter(rays);
+	}
+
+	/**
+	 * Copy the state of the rays in the packet to the slots. Empty slots
+	 * repeat the first ray, so that every kernel can run over the full
+	 * packet without checking which slots are in use.
+	 */
+	void PacketTracer::gather(Ray *rays) {
+
+		for (int k = 0; k < PACKET_SIZE; k++) {
+			int slot = k < _numSlots ? k : 0;
+			Ray &r = rays[_lane[slot]];
+			Vector3d oldNormal = r.lastHitType == GeometryType::none ? r.o.norm() : r.lastHitNormal;
+
+			_verticalSign[k] = _verticalSign[slot];
+			_nextAltitude[k] = _nextAltitude[slot];
+			_ox[k] = r.o.x;
+			_oy[k] = r.o.y;
+			_oz[k] = r.o.z;
+			_dx[k] = r.d.x;
+			_dy[k] = r.d.y;
+			_dz[k] = r.d.z;
+			_oldNx[k] = oldNormal.x;
+			_oldNy[k] = oldNormal.y;
+			_oldNz[k] = oldNormal.z;
+			_altitude[k] = r.altitude;
+			_frequency[k] = r.frequency;
+			_previousRefractiveIndex[k] = r.previousRefractiveIndex;
+		}
+	}
+
+	/**
+	 * Layer crossing of SceneManager::intersect(). Calls to libm are kept in
+	 * loops of their own, so that the arithmetic in between can be
+	 * vectorized by the compiler.
+	 */
+	void PacketTracer::intersectLayers() {
+
+		const double R = _context.radius;
+		const double subsolarMagnitude = Vector3d::SUBSOLAR.magnitude();
+
+		for (int k = 0; k < PACKET_SIZE; k++) {
+			double dot = _dx[k] * _oldNx[k] + _dy[k] * _oldNy[k] + _dz[k] * _oldNz[k];
+			double magnitudes = sqrt(pow(_dx[k], 2) + pow(_dy[k], 2) + pow(_dz[k], 2))
+					* sqrt(pow(_oldNx[k], 2) + pow(_oldNy[k], 2) + pow(_oldNz[k], 2));
+			_scratch[k] = dot / magnitudes;
+		}
+		for (int k = 0; k < PACKET_SIZE; k++) {
+			double cosine = _scratch[k];
+			double sine = sqrt(1 - cosine * cosine);
+			_scratch[k] = _verticalSign[k] > 0 ? Ionosphere::COS_PI * cosine + Ionosphere::SIN_PI * sine : cosine;
+		}
+
+		for (int k = 0; k < PACKET_SIZE; k++) {
+			double DA = R + _altitude[k];
+			double DB = R + _nextAltitude[k];
+			double cosTheta = _scratch[k];
+			double root = sqrt(pow(DA, 2) * pow(cosTheta, 2) - pow(DA, 2) + pow(DB, 2));
+			double dR = _verticalSign[k] * (root + DA * cosTheta);
+
+			_px[k] = _ox[k] + _dx[k] * dR;
+			_py[k] = _oy[k] + _dy[k] * dR;
+			_pz[k] = _oz[k] + _dz[k] * dR;
+
+			double magnitude = sqrt(pow(_px[k], 2) + pow(_py[k], 2) + pow(_pz[k], 2));
+			_nx[k] = _px[k] / magnitude;
+			_ny[k] = _py[k] / magnitude;
+			_nz[k] = _pz[k] / magnitude;
+			_layerAltitude[k] = magnitude - R;
+
+			double normalMagnitude = sqrt(pow(_nx[k], 2) + pow(_ny[k], 2) + pow(_nz[k], 2));
+			_scratch[k] = (_nx[k] * Vector3d::SUBSOLAR.x + _ny[k] * Vector3d::SUBSOLAR.y + _nz[k] * Vector3d::SUBSOLAR.z)
+					/ (normalMagnitude * subsolarMagnitude);
+
+			_distance[k] = sqrt(pow(_ox[k] - _px[k], 2) + pow(_oy[k] - _py[k], 2) + pow(_oz[k] - _pz[k], 2));
+		}
+		for (int k = 0; k < PACKET_SIZE; k++) {
+			_SZA[k] = acos(_scratch[k]);
+		}
+
+		for (int k = 0; k < PACKET_SIZE; k++) {
+			_electronNumberDensity[k] = _table->getElectronNumberDensity(_layerAltitude[k], _SZA[k]);
+			if (_collisionTable != nullptr) {
+				_collisionFrequency[k] = _collisionTable->getCollisionFrequency(_altitude[k]);
+			} else {
+				_collisionFrequency[k] = Ionosphere::getCollisionFrequency(_context.surfaceNCO2, _altitude[k]);
+			}
+		}
+	}
+
+	/**
+	 * Reflection or refraction and attenuation of Ionosphere::interact(), for
+	 * an ionosphere without magnetic field. Both the reflected and the
+	 * refracted direction are calculated for every slot, the wave behaviour
+	 * selects one of them.
+	 */
+	void PacketTracer::interact() {
+
+		for (int k = 0; k < PACKET_SIZE; k++) {
+			double angularFrequency = 2 * Constants::PI * _frequency[k];
+			double plasmaFrequencySquared = _electronNumberDensity[k] * pow(Constants::ELEMENTARY_CHARGE, 2)
+					/ (Constants::ELECTRON_MASS * Constants::PERMITTIVITY_VACUUM);
+			double X = plasmaFrequencySquared / (angularFrequency * angularFrequency);
+			double n = sqrt(1 - X);
+			double previous = _previousRefractiveIndex[k];
+			_plasmaFrequency[k] = sqrt(plasmaFrequencySquared);
+			_refractiveIndex[k] = n;
+
+			double dot = _dx[k] * _nx[k] + _dy[k] * _ny[k] + _dz[k] * _nz[k];
+			double normalMagnitude = sqrt(pow(_nx[k], 2) + pow(_ny[k], 2) + pow(_nz[k], 2));
+			double cosIncidence = fabs(dot) / (sqrt(pow(_dx[k], 2) + pow(_dy[k], 2) + pow(_dz[k], 2))
+					* normalMagnitude);
+			double sinIncidence = sqrt(1 - cosIncidence * cosIncidence);
+			double sinReducedIncidence = cosIncidence < Ionosphere::COS_HALF_PI
+					? sinIncidence * Ionosphere::COS_HALF_PI - cosIncidence * Ionosphere::SIN_HALF_PI
+					: sinIncidence;
+
+			// wave behaviour, see Ionosphere::interact()
+			bool reflects = (X > 1) | ((previous > n) & (sinReducedIncidence >= n / previous));
+			_reflects[k] = reflects;
+
+			// a reflected ray going down uses the complementary angle
+			double complementaryCosine = Ionosphere::COS_PI * cosIncidence + Ionosphere::SIN_PI * sinIncidence;
+			double reflectionCosine = _dy[k] > 0 ? cosIncidence : complementaryCosine;
+
+			double ratio = previous / n;
+			double coefficient = ratio * cosIncidence - sqrt(1 - ratio * ratio * (1 - cosIncidence * cosIncidence));
+			double sign = _dy[k] > 0 ? -1 : 1;
+
+			double reflectedX = _dx[k] - _nx[k] * 2 * reflectionCosine;
+			double reflectedY = _dy[k] - _ny[k] * 2 * reflectionCosine;
+			double reflectedZ = _dz[k] - _nz[k] * 2 * reflectionCosine;
+			double refractedX = _dx[k] * ratio + sign * (_nx[k] * coefficient);
+			double refractedY = _dy[k] * ratio + sign * (_ny[k] * coefficient);
+			double refractedZ = _dz[k] * ratio + sign * (_nz[k] * coefficient);
+
+			double x = reflects ? reflectedX : refractedX;
+			double y = reflects ? reflectedY : refractedY;
+			double z = reflects ? reflectedZ : refractedZ;
+			double magnitude = sqrt(pow(x, 2) + pow(y, 2) + pow(z, 2));
+
+			_dx[k] = x / magnitude;
+			_dy[k] = y / magnitude;
+			_dz[k] = z / magnitude;
+			_previousRefractiveIndex[k] = reflects ? previous : n;
+
+			// attenuation along the path through the layer
+			double cosRefraction = (_nx[k] * _dx[k] + _ny[k] * _dy[k] + _nz[k] * _dz[k])
+					/ (normalMagnitude * sqrt(pow(_dx[k], 2) + pow(_dy[k], 2) + pow(_dz[k], 2)));
+			double reducedCosRefraction = cosRefraction * Ionosphere::COS_HALF_PI
+					+ sqrt(1 - cosRefraction * cosRefraction) * Ionosphere::SIN_HALF_PI;
+			cosRefraction = cosRefraction < Ionosphere::COS_HALF_PI ? reducedCosRefraction : cosRefraction;
+
+			double Z = _collisionFrequency[k] / angularFrequency;
+			_signalLoss[k] = -4.6e-5 * (_electronNumberDensity[k] * Z / (angularFrequency * (1 + Z * Z)))
+					* _context.ionosphereStep * cosRefraction;
+		}
+	}
+
+	/**
+	 * Write the slots back to their rays and export the crossings, with the
+	 * bookkeeping of Tracer::step() and Ionosphere::interact()
+	 */
+	void PacketTracer::scatter(Ray *rays) {
+
+		for (int k = 0; k < _numSlots; k++) {
+			Ray &r = rays[_lane[k]];
+
+			r.lastHitType = GeometryType::ionosphere;
+			r.lastHitNormal = Vector3d(_nx[k], _ny[k], _nz[k]);
+			r.lastHitPos = Vector3d(_px[k], _py[k], _pz[k]);
+			r.timeOfFlight += _distance[k] / Constants::C;
+
+			_statistics->increment(TracingStatistics::counter_steps);
+			_statistics->increment(_reflects[k] != 0 ? TracingStatistics::counter_reflections
+					: TracingStatistics::counter_refractions);
+			r.tracings++;
+
+			r.prev = r.d;
+			r.behaviour = _reflects[k] != 0 ? Ray::wave_reflection : Ray::wave_refraction;
+			r.d = Vector3d(_dx[k], _dy[k], _dz[k]);
+			r.previousRefractiveIndex = _previousRefractiveIndex[k];
+			r.o = r.lastHitPos;
+			r.signalPower += _signalLoss[k];
+
+			double TEC = _electronNumberDensity[k] * _context.ionosphereStep;
+			r.rangeDelay += 0.403 * TEC / pow(r.frequency, 2);
+			r.phaseAdvance += (8.44e-7 / r.frequency) * TEC;
+			r.timeDelay += (1.34e-7 / pow(r.frequency, 2)) * TEC;
+
+			Data d;
+			d.x = r.o.x;
+			d.y = r.o.y;
+			d.z = r.o.z;
+			d.rayNumber = r.rayNumber;
+			d.mu_r_sqrt = pow(r.previousRefractiveIndex, 2);
+			d.n_e = _electronNumberDensity[k];
+			d.omega_p = _plasmaFrequency[k];
+			d.theta_0 = r.originalAngle;
+			d.frequency = r.frequency;
+			d.signalPower = r.signalPower;
+			d.timeOfFlight = r.timeOfFlight;
+			d.collisionType = GeometryType::ionosphere;
+			d.beaconId = r.originBeaconId;
+			d.azimuth_0 = r.originalAzimuth;
+			Application::getInstance().addToDataset(d);
+		}
+	}
+
+} /* namespace tracer */
+} /* namespace raytracer */
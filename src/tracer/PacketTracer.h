@@ -0,0 +1,120 @@
+//============================================================================
+// Name        : PacketTracer.h
+// Author      : Rian van Gijlswijk
+// Description : Traces a packet of rays together. Ionospheric layer crossings
+//				 of all rays in the packet are calculated at once on a
+//				 structure-of-arrays copy of the ray state, all other steps
+//				 are left to the scalar Tracer of each ray.
+//============================================================================
+
+#ifndef TRACER_PACKETTRACER_H_
+#define TRACER_PACKETTRACER_H_
+
+#include <cstdint>
+#include <vector>
+#include "Ray.h"
+#include "Tracer.h"
+#include "../core/SimulationContext.h"
+#include "../scene/SceneManager.h"
+#include "../scene/IonosphereTable.h"
+
+namespace raytracer {
+namespace tracer {
+
+	class PacketTracer {
+
+		public:
+			/**
+			 * Number of rays in a packet. Eight doubles fill two AVX2 or one
+			 * AVX-512 register.
+			 */
+			static constexpr int PACKET_SIZE = 8;
+
+			PacketTracer(const core::SimulationContext &context, const scene::SceneManager &scene);
+
+			/**
+			 * Trace at most PACKET_SIZE rays until all of them have terminated.
+			 * The rays end up in the same state, and export the same data, as
+			 * when each of them is traced by its own Tracer.
+			 */
+			void run(Ray *rays, int numRays);
+
+			/**
+			 * Final state of a ray of the last run
+			 */
+			Tracer::traceState getState(int lane);
+
+			/**
+			 * Whether layer crossings are calculated per packet. Without an
+			 * ionosphere table or with a magnetic field, every step is left
+			 * to the scalar Tracer.
+			 */
+			bool isVectorized();
+
+		private:
+			/**
+			 * run() compiled for the Physics P of the context
+			 */
+			template <class P> void runWith(Ray *rays, int numRays);
+
+			struct RunSelector {
+				typedef void (PacketTracer::*result_type)(Ray *rays, int numRays);
+				template <class P> static result_type select() {
+					return &PacketTracer::runWith<P>;
+				}
+			};
+
+			/**
+			 * Whether the next step of the ray is a crossing of an ionospheric
+			 * layer. If so, the ray is added to the packet.
+			 */
+			template <class P> bool addLayerCrossing(Ray &r, int lane);
+
+			/**
+			 * Advance all rays in the packet through their next layer
+			 */
+			void crossLayers(Ray *rays);
+			void gather(Ray *rays);
+			void intersectLayers();
+			void interact();
+			void scatter(Ray *rays);
+
+			const core::SimulationContext &_context;
+			const scene::SceneManager &_scene;
+			const scene::IonosphereTable *_table;
+			const scene::IonosphereTable *_collisionTable;
+			bool _vectorized;
+			void (PacketTracer::*_run)(Ray *rays, int numRays);
+			core::TracingStatistics *_statistics;
+			std::vector<Tracer::traceState> _states;
+
+			// packet, in structure-of-arrays form. Slots beyond _numSlots
+			// repeat the first ray, their results are discarded.
+			int _numSlots = 0;
+			int _lane[PACKET_SIZE];
+			alignas(64) double _verticalSign[PACKET_SIZE];		// 1 for rays going up, -1 going down
+			alignas(64) double _nextAltitude[PACKET_SIZE];
+			alignas(64) double _ox[PACKET_SIZE], _oy[PACKET_SIZE], _oz[PACKET_SIZE];
+			alignas(64) double _dx[PACKET_SIZE], _dy[PACKET_SIZE], _dz[PACKET_SIZE];
+			alignas(64) double _oldNx[PACKET_SIZE], _oldNy[PACKET_SIZE], _oldNz[PACKET_SIZE];
+			alignas(64) double _altitude[PACKET_SIZE];
+			alignas(64) double _frequency[PACKET_SIZE];
+			alignas(64) double _previousRefractiveIndex[PACKET_SIZE];
+			alignas(64) double _px[PACKET_SIZE], _py[PACKET_SIZE], _pz[PACKET_SIZE];
+			alignas(64) double _nx[PACKET_SIZE], _ny[PACKET_SIZE], _nz[PACKET_SIZE];
+			alignas(64) double _layerAltitude[PACKET_SIZE];
+			alignas(64) double _SZA[PACKET_SIZE];
+			alignas(64) double _electronNumberDensity[PACKET_SIZE];
+			alignas(64) double _collisionFrequency[PACKET_SIZE];
+			alignas(64) double _plasmaFrequency[PACKET_SIZE];
+			alignas(64) double _refractiveIndex[PACKET_SIZE];
+			alignas(64) int64_t _reflects[PACKET_SIZE];		// 1 if the wave is reflected, 0 if refracted
+			alignas(64) double _distance[PACKET_SIZE];
+			alignas(64) double _signalLoss[PACKET_SIZE];
+			alignas(64) double _scratch[PACKET_SIZE];
+	};
+
+} /* namespace tracer */
+} /* namespace raytracer */
+
+#endif /* TRACER_PACKETTRACER_H_ */
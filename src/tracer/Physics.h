@@ -0,0 +1,60 @@
+//============================================================================
+// Name        : Physics.h
+// Author      : Rian van Gijlswijk
+// Description : Compile-time physics options of the tracing engines. The
+//				 options of a run are looked up once, after which the
+//				 engines step with code specialized for them.
+//============================================================================
+
+#ifndef TRACER_PHYSICS_H_
+#define TRACER_PHYSICS_H_
+
+#include "../core/SimulationContext.h"
+
+namespace raytracer {
+namespace tracer {
+
+	/**
+	 * Physics policy of the tracing engines. Code which depends on an option
+	 * tests the static member, a constant expression, so that the branches
+	 * of the other options are removed when compiled.
+	 */
+	template <bool MagneticField, bool SkipEmptySpace, bool SphereTerrain>
+	struct Physics {
+
+		// magnetized refractive index, see Ionosphere::interact
+		static constexpr bool magneticField = MagneticField;
+		// emptySpaceSkipping.enabled
+		static constexpr bool skipEmptySpace = SkipEmptySpace;
+		// ideal sphere instead of terrain patches
+		static constexpr bool sphereTerrain = SphereTerrain;
+	};
+
+	/**
+	 * Return Selector::select<P>() for the Physics P of the context. A
+	 * selector returns pointers to, or objects holding, the specializations
+	 * of an engine.
+	 */
+	template <class Selector>
+	typename Selector::result_type selectPhysics(const core::SimulationContext &context) {
+
+		int options = (context.getMagneticFieldStrength() > 0 ? 4 : 0)
+				+ (context.skipEmptySpace ? 2 : 0)
+				+ (context.terrain == core::SimulationContext::terrain_sphere ? 1 : 0);
+
+		switch (options) {
+			case 0: return Selector::template select<Physics<false, false, false> >();
+			case 1: return Selector::template select<Physics<false, false, true> >();
+			case 2: return Selector::template select<Physics<false, true, false> >();
+			case 3: return Selector::template select<Physics<false, true, true> >();
+			case 4: return Selector::template select<Physics<true, false, false> >();
+			case 5: return Selector::template select<Physics<true, false, true> >();
+			case 6: return Selector::template select<Physics<true, true, false> >();
+			default: return Selector::template select<Physics<true, true, true> >();
+		}
+	}
+
+} /* namespace tracer */
+} /* namespace raytracer */
+
+#endif /* TRACER_PHYSICS_H_ */
@@ -0,0 +1,244 @@
+//============================================================================
+// Name        : QuasiParabolicTracer.cpp
+// Author      : Rian van Gijlswijk
+// Description : Analytic ray tracing through a multi-segment quasi-parabolic
+//				 fit of the scenario ionosphere
+//============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <boost/log/trivial.hpp>
+#include "QuasiParabolicTracer.h"
+#include "../scene/Ionosphere.h"
+#include "../math/Constants.h"
+
+namespace raytracer {
+namespace tracer {
+
+	using namespace core;
+	using namespace scene;
+	using namespace math;
+
+	namespace {
+
+		inline double clampUnit(double value) {
+
+			return std::max(-1.0, std::min(1.0, value));
+		}
+	}
+
+	QuasiParabolicTracer::QuasiParabolicTracer(const SimulationContext &context, double SZA,
+			double launchAltitude) : _context(context), _SZA(SZA) {
+
+		_launchRadius = context.radius + launchAltitude;
+		for (const IonosphereLayerParameters &layer : context.ionosphereLayers) {
+			_peakElectronDensity = std::max(_peakElectronDensity, layer.electronPeakDensity);
+		}
+
+		_maxError = fit(context.ionosphereStart, context.ionosphereEnd);
+
+		BOOST_LOG_TRIVIAL(debug) << "Quasi-parabolic fit of " << _segments.size() << " segments, max error " << _maxError;
+	}
+
+	/**
+	 * The segment interpolates n_e * r^2 at its bottom, middle and top. The
+	 * Newton form of the interpolant is used to measure the error, since it
+	 * is better conditioned than the coefficients a, b and c.
+	 */
+	double QuasiParabolicTracer::fit(double bottom, double top) {
+
+		double R = _context.radius;
+		double middle = 0.5 * (bottom + top);
+		double r1 = R + bottom, r2 = R + middle, r3 = R + top;
+		double p1 = evaluateElectronNumberDensity(bottom) * r1 * r1;
+		double p2 = evaluateElectronNumberDensity(middle) * r2 * r2;
+		double p3 = evaluateElectronNumberDensity(top) * r3 * r3;
+
+		double d1 = (p2 - p1) / (r2 - r1);
+		double d2 = (p3 - p2) / (r3 - r2);
+		double d12 = (d2 - d1) / (r3 - r1);
+
+		double maxError = 0;
+		for (double fraction : {0.25, 0.75}) {
+			double r = r1 + fraction * (r3 - r1);
+			double interpolated = (p1 + (r - r1) * (d1 + (r - r2) * d12)) / (r * r);
+			double error = std::abs(interpolated - evaluateElectronNumberDensity(r - R));
+			maxError = std::max(maxError, error / _peakElectronDensity);
+		}
+
+		if (maxError > _context.quasiParabolicMaxError && top - bottom > 2 * MIN_THICKNESS) {
+			// segments are appended from the bottom up
+			double lower = fit(bottom, middle);
+			return std::max(lower, fit(middle, top));
+		}
+
+		Segment s;
+		s.bottom = r1;
+		s.top = r3;
+		s.a = d12;
+		s.b = d1 - d12 * (r1 + r2);
+		s.c = p1 - d1 * r1 + d12 * r1 * r2;
+		_segments.push_back(s);
+
+		return maxError;
+	}
+
+	/**
+	 * The ray rises through the empty space below the ionosphere and through
+	 * the segments, until n^2 r^2 - K^2 has a root in a segment. It then
+	 * descends symmetrically to the terrain. A ray which does not reflect is
+	 * followed up to the scene boundary.
+	 */
+	QuasiParabolicTracer::Path QuasiParabolicTracer::trace(double zenithAngle, double frequency) const {
+
+		Path path;
+		double R = _context.radius;
+		double K = _launchRadius * sin(zenithAngle);
+		double KK = K * K;
+		double angularFrequency = 2 * Constants::PI * frequency;
+		double plasmaFrequencyFactor = pow(Constants::ELEMENTARY_CHARGE, 2)
+				/ (Constants::ELECTRON_MASS * Constants::PERMITTIVITY_VACUUM * angularFrequency * angularFrequency);
+
+		double bottom = R + _context.ionosphereStart;
+		double top = R + _context.ionosphereEnd;
+
+		// the part of the path which both legs share
+		double angle = 0, groupPath = 0;
+		double apogee = top;
+
+		for (const Segment &s : _segments) {
+			double A = 1 - plasmaFrequencyFactor * s.a;
+			double B = -plasmaFrequencyFactor * s.b;
+			double C = -plasmaFrequencyFactor * s.c - KK;
+
+			// first root of A r^2 + B r + C above the bottom of the segment
+			double reflection = s.top + 1;
+			double discriminant = B * B - 4 * A * C;
+			if (discriminant >= 0) {
+				double q = -0.5 * (B + std::copysign(sqrt(discriminant), B));
+				for (double root : {q / A, C / q}) {
+					if (root >= s.bottom - ROOT_TOLERANCE && root < reflection) {
+						reflection = std::max(root, s.bottom);
+					}
+				}
+			}
+
+			if (reflection <= s.top) {
+				integrate(A, B, C, K, s.bottom, reflection, angle, groupPath);
+				apogee = reflection;
+				path.reflected = true;
+				break;
+			}
+			integrate(A, B, C, K, s.bottom, s.top, angle, groupPath);
+		}
+
+		double upAngle = 0, upGroupPath = 0;
+		integrate(1, 0, -KK, K, _launchRadius, bottom, upAngle, upGroupPath);
+		path.apogee = apogee - R;
+		path.apogeeRange = R * (upAngle + angle);
+		path.apogeeGroupPath = upGroupPath + groupPath;
+
+		double downAngle = 0, downGroupPath = 0;
+		if (path.reflected) {
+			integrate(1, 0, -KK, K, R, bottom, downAngle, downGroupPath);
+			path.arrivalAngle = asin(clampUnit(K / R));
+			downAngle += angle;
+			downGroupPath += groupPath;
+		} else {
+			integrate(1, 0, -KK, K, top, _context.sceneBoundary, downAngle, downGroupPath);
+			path.arrivalAngle = asin(clampUnit(K / _context.sceneBoundary));
+		}
+
+		path.groundRange = path.apogeeRange + R * downAngle;
+		path.groupPath = path.apogeeGroupPath + downGroupPath;
+		path.timeOfFlight = path.groupPath / Constants::C;
+
+		return path;
+	}
+
+	/**
+	 * With X = A r^2 + B r + C, disc = B^2 - 4 A C:
+	 *  int dr / sqrt(X)		= ln(2 sqrt(A X) + 2 A r + B) / sqrt(A)				A > 0
+	 *							= -asin((2 A r + B) / sqrt(disc)) / sqrt(-A)			A < 0
+	 *  int r dr / sqrt(X)		= sqrt(X) / A - B / (2 A) * int dr / sqrt(X)
+	 *  int dr / (r sqrt(X))	= -ln((2 sqrt(C X) + B r + 2 C) / r) / sqrt(C)		C > 0
+	 *							= asin((B r + 2 C) / (r sqrt(disc))) / sqrt(-C)		C < 0
+	 * The logarithms are also antiderivatives with the sign of their second
+	 * term flipped, which avoids cancellation where that term is negative.
+	 */
+	void QuasiParabolicTracer::integrate(double A, double B, double C, double K, double r1, double r2,
+			double &angle, double &groupPath) {
+
+		double root1 = sqrt(std::max(0.0, (A * r1 + B) * r1 + C));
+		double root2 = sqrt(std::max(0.0, (A * r2 + B) * r2 + C));
+		double discriminant = std::max(0.0, B * B - 4 * A * C);
+		double middle = 0.5 * (r1 + r2);
+
+		if (A == 0) {
+			groupPath += 2 * ((B * r2 - 2 * C) * root2 - (B * r1 - 2 * C) * root1) / (3 * B * B);
+		} else {
+			double inverse = 0;
+			if (B == 0) {
+				// the term vanishes, as in empty space
+			} else if (A > 0) {
+				double sign = 2 * A * middle + B < 0 ? -1 : 1;
+				double sqrtA = sqrt(A);
+				inverse = sign * log((2 * sqrtA * root2 + sign * (2 * A * r2 + B))
+						/ (2 * sqrtA * root1 + sign * (2 * A * r1 + B))) / sqrtA;
+			} else {
+				double sqrtDiscriminant = sqrt(discriminant);
+				inverse = (asin(clampUnit((2 * A * r1 + B) / sqrtDiscriminant))
+						- asin(clampUnit((2 * A * r2 + B) / sqrtDiscriminant))) / sqrt(-A);
+			}
+			groupPath += (root2 - root1) / A - B / (2 * A) * inverse;
+		}
+
+		if (K == 0) {
+			// radial rays do not advance over the ground
+		} else if (C == 0) {
+			angle += K * 2 * (root1 / r1 - root2 / r2) / B;
+		} else if (C > 0) {
+			double sign = B * middle + 2 * C < 0 ? -1 : 1;
+			double sqrtC = sqrt(C);
+			angle += K * sign * log((2 * sqrtC * root1 + sign * (B * r1 + 2 * C)) * r2
+					/ ((2 * sqrtC * root2 + sign * (B * r2 + 2 * C)) * r1)) / sqrtC;
+		} else {
+			double sqrtDiscriminant = sqrt(discriminant);
+			angle += K * (asin(clampUnit((B * r2 + 2 * C) / (r2 * sqrtDiscriminant)))
+					- asin(clampUnit((B * r1 + 2 * C) / (r1 * sqrtDiscriminant)))) / sqrt(-C);
+		}
+	}
+
+	double QuasiParabolicTracer::getElectronNumberDensity(double altitude) const {
+
+		double r = _context.radius + altitude;
+		for (const Segment &s : _segments) {
+			if (r >= s.bottom && r <= s.top) {
+				return ((s.a * r + s.b) * r + s.c) / (r * r);
+			}
+		}
+		return 0;
+	}
+
+	const std::vector<QuasiParabolicTracer::Segment>& QuasiParabolicTracer::getSegments() const {
+
+		return _segments;
+	}
+
+	double QuasiParabolicTracer::getMaxError() const {
+
+		return _maxError;
+	}
+
+	double QuasiParabolicTracer::evaluateElectronNumberDensity(double altitude) const {
+
+		double electronNumberDensity = 0;
+		for (const IonosphereLayerParameters &layer : _context.ionosphereLayers) {
+			electronNumberDensity += Ionosphere::getChapmanElectronNumberDensity(layer.electronPeakDensity,
+					layer.peakProductionAltitude, layer.neutralScaleHeight, altitude, _SZA);
+		}
+		return electronNumberDensity;
+	}
+
+} /* namespace tracer */
+} /* namespace raytracer */
@@ -0,0 +1,128 @@
+//============================================================================
+// Name        : QuasiParabolicTracer.h
+// Author      : Rian van Gijlswijk
+// Description : Analytic ray tracing through a multi-segment quasi-parabolic
+//				 fit of the scenario ionosphere. The ground range, group path
+//				 and apogee of a ray follow in closed form, so that large
+//				 sweeps of elevations and frequencies take microseconds per ray.
+//============================================================================
+
+#ifndef TRACER_QUASIPARABOLICTRACER_H_
+#define TRACER_QUASIPARABOLICTRACER_H_
+
+#include <vector>
+#include "../core/SimulationContext.h"
+
+namespace raytracer {
+namespace tracer {
+
+	/**
+	 * The chapman layers of the context, evaluated at a single SZA, are
+	 * interpolated between ionosphere.start and ionosphere.end by segments
+	 * in which n_e * r^2 is a quadratic polynomial of the distance r to the
+	 * center. Quasi-parabolic layers (Croft & Hoogasian, 1968) and the
+	 * inverted layers which join them are special cases of such segments.
+	 * In each segment n^2 r^2 is then a quadratic polynomial as well, and
+	 * the integrals over a ray path of Bouguer's invariant n r sin(i) = K
+	 * have closed forms:
+	 *  ground angle	int K / (r sqrt(n^2 r^2 - K^2)) dr
+	 *  group path		int r / sqrt(n^2 r^2 - K^2) dr
+	 * The medium is spherically symmetric, unmagnetized and loss free.
+	 */
+	class QuasiParabolicTracer {
+
+		public:
+			/**
+			 * A segment between the distances bottom and top from the center,
+			 * in which n_e * r^2 = a * r^2 + b * r + c
+			 */
+			struct Segment {
+				double bottom;		// m
+				double top;			// m
+				double a;			// m^-3
+				double b;			// m^-2
+				double c;			// m^-1
+			};
+
+			/**
+			 * A ray launched from the launch radius, and received at the
+			 * terrain radius if it is reflected. Ranges are measured along
+			 * the terrain sphere.
+			 */
+			struct Path {
+				bool reflected = false;
+				double groundRange = 0;			// m, up to the terrain or the scene boundary
+				double groupPath = 0;			// m
+				double timeOfFlight = 0;		// s
+				double apogee = 0;				// m, altitude of the highest point
+				double apogeeRange = 0;			// m
+				double apogeeGroupPath = 0;		// m
+				double arrivalAngle = 0;		// rad, zenith angle at the end of the path
+			};
+
+			/**
+			 * Fit the ionosphere of the context at the given SZA, bisecting the
+			 * segments until the fit is within context.quasiParabolicMaxError
+			 * of the exact profile, relative to the highest peak density.
+			 * The launch altitude is relative to the terrain.
+			 */
+			QuasiParabolicTracer(const core::SimulationContext &context, double SZA,
+					double launchAltitude);
+
+			/**
+			 * Trace a ray with the given zenith angle at launch
+			 * @param zenithAngle: rad
+			 * @param frequency: Hz
+			 */
+			Path trace(double zenithAngle, double frequency) const;
+
+			/**
+			 * Electron number density of the fitted profile
+			 * @unit: particles m^-3
+			 */
+			double getElectronNumberDensity(double altitude) const;
+
+			const std::vector<Segment>& getSegments() const;
+
+			/**
+			 * The largest difference between the fit and the exact profile,
+			 * relative to the highest peak density
+			 */
+			double getMaxError() const;
+
+			static constexpr double MIN_THICKNESS = 1.0;		// m
+			static constexpr double ROOT_TOLERANCE = 1e-6;	// m
+
+		private:
+			/**
+			 * Interpolate the exact profile between two altitudes, bisecting
+			 * until the error at the quarter points of every segment is small
+			 * enough. Returns the largest error.
+			 */
+			double fit(double bottom, double top);
+
+			/**
+			 * Exact electron number density of the chapman layers of the context
+			 * @unit: particles m^-3
+			 */
+			double evaluateElectronNumberDensity(double altitude) const;
+
+			/**
+			 * Add the ground angle and group path between the distances r1 and r2
+			 * in a part of the path where n^2 r^2 - K^2 = A r^2 + B r + C
+			 */
+			static void integrate(double A, double B, double C, double K, double r1, double r2,
+					double &angle, double &groupPath);
+
+			const core::SimulationContext &_context;
+			double _SZA;
+			double _launchRadius;
+			double _peakElectronDensity = 0;
+			double _maxError = 0;
+			std::vector<Segment> _segments;
+	};
+
+} /* namespace tracer */
+} /* namespace raytracer */
+
+#endif /* TRACER_QUASIPARABOLICTRACER_H_ */
@@ -26,7 +26,6 @@ namespace tracer {
 		public:
 			Ray();
 			~Ray();
-			int trace();
 			void calculateTimeOfFlight(Vector3d rayEnd);
 			double calculateTerrainAngle();
 			double getNormalAngle();
@@ -40,7 +39,7 @@ namespace tracer {
 			void setAngle(double angleRad);
 			void setAngle(Vector3d angle);
 			void exportData(GeometryType collisionType);
-			void updateAltitude();
+			void updateAltitude(double radius);
 
 			/**
 			 * Origin
@@ -65,7 +64,7 @@ namespace tracer {
 			double timeDelay = 0.0;
 			double phaseAdvance = 0.0;
 			double altitude = 0.0;
-			GeometryType lastHitType;
+			GeometryType lastHitType = GeometryType::none;
 			Vector3d lastHitNormal;
 			Vector3d lastHitPos;
 			Vector3d prev;
@@ -0,0 +1,195 @@
+//============================================================================
+// Name        : Tracer.cpp
+// Author      : Rian van Gijlswijk
+// Description : Iterative tracing engine
+//============================================================================
+
+#include <cmath>
+#include "Tracer.h"
+#include "Intersection.h"
+#include "../core/Application.h"
+#include "../core/TracingStatistics.h"
+#include "../scene/Ionosphere.h"
+#include "../math/Line3d.h"
+
+namespace raytracer {
+namespace tracer {
+
+	using namespace scene;
+	using namespace core;
+	using namespace math;
+
+	Tracer::Tracer(Ray &r, const SimulationContext &context, const SceneManager &scene)
+			: _ray(r), _context(context), _scene(scene) {
+
+		_state = Tracer::state_tracing;
+		_specialization = selectPhysics<SpecializationSelector>(context);
+		_statistics = &TracingStatistics::local();
+	}
+
+	Tracer::traceState Tracer::step() {
+
+		return (this->*_specialization.step)();
+	}
+
+	/**
+	 * Perform one step of the whitted-style raytracing algorithm. The ray
+	 * keeps tracing until it hits the ground, leaves the scene or exceeds
+	 * the tracing limit.
+	 */
+	template <class P>
+	Tracer::traceState Tracer::stepWith() {
+
+		if (isTerminated()) {
+			return _state;
+		}
+
+		// isnan check
+		if (_ray.o.x != _ray.o.x || _ray.o.y != _ray.o.y) {
+			_state = Tracer::state_nan;
+			return _state;
+		}
+
+		// extrapolate a line from the ray start and its direction
+		Line3d rayLine;
+		Vector3d rayEnd;
+		// the direction in the x-y plane, normalized without an atan2, cos and sin
+		// round trip. A direction along z keeps atan2(0, 0) = 0.
+		double planar = sqrt(_ray.d.x * _ray.d.x + _ray.d.y * _ray.d.y);
+		rayLine.origin = _ray.o;
+		rayEnd.x = _ray.o.x + Ray::magnitude * (planar > 0 ? _ray.d.x / planar : 1);
+		rayEnd.y = _ray.o.y + Ray::magnitude * (planar > 0 ? _ray.d.y / planar : 0);
+		rayEnd.z = _ray.o.z + Ray::magnitude * _ray.d.z;
+		rayLine.destination = rayEnd;
+
+		BOOST_LOG_TRIVIAL(debug) << "rayline: (" << rayLine.destination.x << "," << rayLine.destination.y << "," << rayLine.destination.z << ") \n";
+
+		// limit the simulation to avoid unnecessary calculations
+		if (rayLine.origin.distance(Vector3d(0,0,0)) > _context.sceneBoundary) {
+			BOOST_LOG_TRIVIAL(info) << "Ray " << _ray.rayNumber << " result: Out of scene bounds!";
+			_state = Tracer::state_out_of_bounds;
+			return _state;
+		}
+		if (_ray.tracings >= _context.tracingLimit) {
+			BOOST_LOG_TRIVIAL(info) << "Ray " << _ray.rayNumber << " result: Tracing limit exceeded!";
+			_state = Tracer::state_tracing_limit;
+			return _state;
+		}
+
+		_ray.updateAltitude(_context.radius);
+
+		// cross empty space in a single step
+		if (P::skipEmptySpace) {
+			double skipDistance = _scene.getSkipDistance(_ray);
+			if (skipDistance > 0) {
+				skip(skipDistance);
+				return _state;
+			}
+		}
+
+		// find intersection
+		Intersection hit = _scene.intersect(_ray, rayLine);
+		_ray.lastHitType = hit.o;
+		_ray.lastHitNormal = hit.normal;
+		_ray.lastHitPos = hit.pos;
+
+		// calculate time-of-flight
+		if (hit.o != GeometryType::none) {
+			_ray.calculateTimeOfFlight(hit.pos);
+		} else {
+			_ray.calculateTimeOfFlight(rayEnd);
+		}
+
+		_statistics->increment(TracingStatistics::counter_steps);
+		_ray.tracings++;
+
+		// determine ray behaviour
+		// intersection with an ionospheric or atmospheric layer
+		_ray.prev = _ray.d;
+		if (hit.o == GeometryType::ionosphere || hit.o == GeometryType::atmosphere) {
+			if (hit.o == GeometryType::ionosphere) {
+				Ionosphere io(hit.layer);
+				io.interact<P::magneticField>(&_ray, hit.pos);
+			} else {
+				hit.g->interact(&_ray, hit.pos);
+			}
+			if (_ray.behaviour == Ray::wave_reflection) {
+				_statistics->increment(TracingStatistics::counter_reflections);
+			} else if (_ray.behaviour == Ray::wave_refraction) {
+				_statistics->increment(TracingStatistics::counter_refractions);
+			} else if (_ray.behaviour == Ray::wave_no_propagation) {
+				BOOST_LOG_TRIVIAL(info) << "Ray " << _ray.rayNumber << " result: no propagation";
+				_state = Tracer::state_no_propagation;
+			}
+		} else if (hit.o == GeometryType::terrain) {
+			// terrain patches only approximate the surface, so the ray is
+			// placed at the end of the ray line. The sphere is exact.
+			if (P::sphereTerrain) {
+				_ray.o = hit.pos;
+			} else {
+				_ray.o = rayLine.destination;
+			}
+			_ray.exportData(GeometryType::terrain);
+			BOOST_LOG_TRIVIAL(info) << "Ray " << _ray.rayNumber << " result: terrain";
+			_state = Tracer::state_terrain;
+		} else if (hit.o == GeometryType::none) {
+			_ray.o = rayLine.destination;
+			_ray.exportData(GeometryType::none);
+		} else {
+			_state = Tracer::state_unknown_hit;
+		}
+
+		return _state;
+	}
+
+	/**
+	 * Move the ray in a straight line along its direction, without any
+	 * interaction. Exported as a step without collision.
+	 */
+	void Tracer::skip(double distance) {
+
+		Vector3d destination = _ray.o + _ray.d * distance;
+
+		BOOST_LOG_TRIVIAL(debug) << "Ray " << _ray.rayNumber << " skips " << distance << " m from alt " << _ray.altitude;
+
+		_ray.lastHitType = GeometryType::none;
+		_ray.lastHitNormal = Vector3d();
+		_ray.lastHitPos = destination;
+		_ray.calculateTimeOfFlight(destination);
+
+		_statistics->increment(TracingStatistics::counter_steps);
+		_ray.tracings++;
+
+		_ray.prev = _ray.d;
+		_ray.o = destination;
+		_ray.exportData(GeometryType::none);
+	}
+
+	/**
+	 * Step the ray until it terminates and return the final state
+	 */
+	Tracer::traceState Tracer::run() {
+
+		return (this->*_specialization.run)();
+	}
+
+	template <class P>
+	Tracer::traceState Tracer::runWith() {
+
+		while (stepWith<P>() == Tracer::state_tracing);
+
+		return _state;
+	}
+
+	Tracer::traceState Tracer::getState() {
+
+		return _state;
+	}
+
+	bool Tracer::isTerminated() {
+
+		return _state != Tracer::state_tracing;
+	}
+
+} /* namespace tracer */
+} /* namespace raytracer */
@@ -0,0 +1,93 @@
+//============================================================================
+// Name        : Tracer.h
+// Author      : Rian van Gijlswijk
+// Description : Iterative tracing engine. Advances a single ray through the
+//				 scene one step at a time by means of an explicit state
+//				 machine, so the stack depth does not grow with the number of
+//				 layer crossings
+//============================================================================
+
+#ifndef TRACER_TRACER_H_
+#define TRACER_TRACER_H_
+
+#include "Ray.h"
+#include "Physics.h"
+#include "../core/SimulationContext.h"
+#include "../scene/SceneManager.h"
+
+namespace raytracer {
+namespace core {
+	class TracingStatistics;
+}
+namespace tracer {
+
+	class Tracer {
+
+		public:
+			enum traceState {
+				state_tracing = 0,
+				state_nan = 1,
+				state_out_of_bounds = 2,
+				state_tracing_limit = 3,
+				state_no_propagation = 4,
+				state_terrain = 5,
+				state_unknown_hit = 6
+			};
+
+			Tracer(Ray &r, const core::SimulationContext &context, const scene::SceneManager &scene);
+
+			/**
+			 * Advance the ray by a single step: find the next intersection in
+			 * the scene and let the ray interact with it. Once the ray has
+			 * terminated, further calls have no effect.
+			 */
+			traceState step();
+
+			/**
+			 * Step the ray until it terminates and return the final state
+			 */
+			traceState run();
+
+			traceState getState();
+			bool isTerminated();
+
+		private:
+			/**
+			 * step() and run() compiled for the Physics P of the context,
+			 * selected once by the constructor
+			 */
+			template <class P> traceState stepWith();
+			template <class P> traceState runWith();
+
+			struct Specialization {
+				traceState (Tracer::*step)();
+				traceState (Tracer::*run)();
+			};
+
+			struct SpecializationSelector {
+				typedef Specialization result_type;
+				template <class P> static Specialization select() {
+					Specialization specialization = {&Tracer::stepWith<P>, &Tracer::runWith<P>};
+					return specialization;
+				}
+			};
+
+			/**
+			 * Move the ray in a straight line along its direction, without any
+			 * interaction. Exported as a step without collision.
+			 */
+			void skip(double distance);
+
+			Ray &_ray;
+			const core::SimulationContext &_context;
+			const scene::SceneManager &_scene;
+			traceState _state;
+			Specialization _specialization;
+			// counters of the thread which constructed the tracer
+			core::TracingStatistics *_statistics;
+	};
+
+} /* namespace tracer */
+} /* namespace raytracer */
+
+#endif /* TRACER_TRACER_H_ */
@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include "../../src/tracer/PacketTracer.h"
+#include "../../src/tracer/Tracer.h"
+#include "../../src/tracer/Ray.h"
+#include "../../src/core/Application.h"
+#include "../../src/core/Config.h"
+#include "../../src/scene/IonosphereTable.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace raytracer::tracer;
+	using namespace raytracer::core;
+	using namespace raytracer::scene;
+	using namespace raytracer::math;
+
+	/**
+	 * Compare the number of tracings per second of the scalar Tracer and the
+	 * PacketTracer, for a launch grid of elevations and frequencies as
+	 * created by Application::run(). Empty space skipping is off, so most
+	 * steps are layer crossings.
+	 */
+	class PacketTracerBenchmarkTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+				conf = Config("config/scenario_default.json");
+				appConf = Config("config/config.json");
+				Application::getInstance().setCelestialConfig(conf);
+				Application::getInstance().setApplicationConfig(appConf);
+
+				context = Application::getInstance().getSimulationContext();
+				context.terrain = SimulationContext::terrain_sphere;
+				context.skipEmptySpace = false;
+				context.useIonosphereTable = true;
+				table.build(context, 1e-3);
+				scm.loadStaticEnvironment(context, &table);
+			}
+
+			void TearDown() {
+
+				boost::log::core::get()->reset_filter();
+				Application::getInstance().dataSet.clear();
+			}
+
+			std::vector<Ray> createRays() {
+
+				std::vector<Ray> rays;
+				for (double frequency = 3e6; frequency <= 6e6; frequency += 0.5e6) {
+					for (double elevation = 15; elevation < 75; elevation += 2.5) {
+						Ray r;
+						r.o = Vector3d(0, 3390e3 + 2, 0);
+						r.d = Vector3d(cos(elevation * Constants::PI / 180), sin(elevation * Constants::PI / 180), 0);
+						r.frequency = frequency;
+						rays.push_back(r);
+					}
+				}
+
+				return rays;
+			}
+
+			int countTracings(std::vector<Ray> &rays) {
+
+				int tracings = 0;
+				for (Ray &r : rays) {
+					tracings += r.tracings;
+				}
+
+				return tracings;
+			}
+
+			Config conf, appConf;
+			SimulationContext context;
+			IonosphereTable table;
+			SceneManager scm;
+	};
+
+	TEST_F(PacketTracerBenchmarkTest, DISABLED_Throughput) {
+
+		std::vector<Ray> scalar = createRays();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (Ray &r : scalar) {
+			Tracer(r, context, scm).run();
+		}
+		double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::vector<Ray> packet = createRays();
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < packet.size(); i += PacketTracer::PACKET_SIZE) {
+			int numRays = std::min<int>(PacketTracer::PACKET_SIZE, packet.size() - i);
+			PacketTracer(context, scm).run(&packet[i], numRays);
+		}
+		double packetSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		ASSERT_EQ(countTracings(scalar), countTracings(packet));
+
+		std::cout << packet.size() << " rays, " << countTracings(packet) << " tracings: scalar "
+				<< countTracings(scalar) / scalarSeconds << " tracings/s, packet "
+				<< countTracings(packet) / packetSeconds << " tracings/s, speedup "
+				<< scalarSeconds / packetSeconds << "x" << std::endl;
+	}
+}
@@ -0,0 +1,66 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include "../../src/tracer/QuasiParabolicTracer.h"
+#include "../../src/core/Application.h"
+#include "../../src/core/Config.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace raytracer::tracer;
+	using namespace raytracer::core;
+	using namespace raytracer::math;
+
+	/**
+	 * Number of rays per second of the QuasiParabolicTracer, for a dense
+	 * sweep of zenith angles and frequencies through the default scenario
+	 */
+	class QuasiParabolicBenchmarkTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+				conf = Config("config/scenario_default.json");
+				appConf = Config("config/config.json");
+				Application::getInstance().setCelestialConfig(conf);
+				Application::getInstance().setApplicationConfig(appConf);
+
+				context = Application::getInstance().getSimulationContext();
+			}
+
+			void TearDown() {
+
+				boost::log::core::get()->reset_filter();
+			}
+
+			Config conf, appConf;
+			SimulationContext context;
+	};
+
+	TEST_F(QuasiParabolicBenchmarkTest, DISABLED_Throughput) {
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		QuasiParabolicTracer tracer(context, 0, 2);
+		double fitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		int rays = 0, reflected = 0;
+		start = std::chrono::steady_clock::now();
+		for (double frequency = 2e6; frequency < 6e6; frequency += 1e4) {
+			for (double zenithAngle = 0; zenithAngle < 80; zenithAngle += 0.1) {
+				reflected += tracer.trace(zenithAngle * Constants::PI / 180, frequency).reflected;
+				rays++;
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << tracer.getSegments().size() << " segments fitted in " << fitSeconds << " s, "
+				<< rays << " rays (" << reflected << " reflected): " << rays / seconds << " rays/s" << std::endl;
+	}
+}
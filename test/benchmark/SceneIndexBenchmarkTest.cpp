@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include "../../src/scene/SceneManager.h"
+#include "../../src/scene/Terrain.h"
+#include "../../src/tracer/Ray.h"
+#include "../../src/math/Constants.h"
+#include "../../src/math/Line3d.h"
+#include "../../src/math/Matrix3d.h"
+
+namespace {
+
+	using namespace raytracer::scene;
+	using namespace raytracer::math;
+
+	/**
+	 * Compare terrain lookups with and without the scene index for the
+	 * patch counts which Application::createScene() produces at several
+	 * angular step sizes. Rays are 1 km ray lines at low altitude, as
+	 * traced between the surface and the ionosphere.
+	 */
+	class SceneIndexBenchmarkTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+			}
+
+			void TearDown() {
+
+				boost::log::core::get()->reset_filter();
+			}
+
+			/**
+			 * Number of intersect calls per second
+			 */
+			double measure(const SceneManager &scm, int numRays) {
+
+				std::mt19937 generator(1);
+				std::uniform_real_distribution<double> unit(-1, 1);
+				std::uniform_real_distribution<double> altitude(0, 70e3);
+				int numHits = 0;
+
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for (int i = 0; i < numRays; i++) {
+					raytracer::tracer::Ray r = raytracer::tracer::Ray();
+					r.o = Vector3d(unit(generator), unit(generator), unit(generator)).norm() * (R + altitude(generator));
+					r.d = Vector3d(unit(generator), unit(generator), unit(generator)).norm();
+					Line3d rayLine = Line3d(r.o, r.o + r.d * 1e3);
+					if (scm.intersect(r, rayLine).o == GeometryType::terrain) {
+						numHits++;
+					}
+				}
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				EXPECT_LE(0, numHits);
+
+				return numRays / seconds;
+			}
+
+			double R = 3390e3;
+	};
+
+	TEST_F(SceneIndexBenchmarkTest, DISABLED_TerrainLookup) {
+
+		double stepSizesDeg[] = {4, 2, 1, 0.5};
+
+		for (double stepSizeDeg : stepSizesDeg) {
+
+			double angularStepSize = stepSizeDeg * Constants::PI / 180.0;
+			std::vector<Terrain> patches;
+			for (double latitude = 0; latitude <= 2 * Constants::PI; latitude += angularStepSize) {
+				for (double longitude = 0; longitude <= 2 * Constants::PI; longitude += angularStepSize) {
+					Matrix3d rotationMatrix = Matrix3d::createRotationMatrix(latitude, Matrix3d::ROTATION_X)
+							* Matrix3d::createRotationMatrix(longitude, Matrix3d::ROTATION_Z);
+					Vector3d position = rotationMatrix * Vector3d(0, R, 0);
+					Plane3d mesh = Plane3d(position.norm(), position);
+					mesh.size = angularStepSize * R;
+					patches.push_back(Terrain(mesh));
+				}
+			}
+
+			SceneManager scm = SceneManager();
+			for (Terrain &t : patches) {
+				scm.addToScene(&t);
+			}
+
+			double scanRate = measure(scm, 200);
+			scm.buildIndex();
+			double indexedRate = measure(scm, 20000);
+
+			std::cout << "angularStepSize " << stepSizeDeg << " deg, " << patches.size() << " patches: scan "
+					<< scanRate << " lookups/s, indexed " << indexedRate << " lookups/s, speedup "
+					<< indexedRate / scanRate << "x" << std::endl;
+		}
+	}
+}
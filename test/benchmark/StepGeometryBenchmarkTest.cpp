@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../../src/scene/Ionosphere.h"
+#include "../../src/math/Constants.h"
+#include "../../src/math/Vector3d.h"
+
+namespace {
+
+	using namespace raytracer::scene;
+	using namespace raytracer::math;
+
+	/**
+	 * Compare the geometry of a layer crossing when it goes through angles,
+	 * as Tracer::step() and SceneManager::intersect() used to, with the
+	 * dot products and cosines they carry through now. Each kernel
+	 * extrapolates the ray line, computes cos(theta) of the crossing and
+	 * the critical angle test.
+	 */
+	class StepGeometryBenchmarkTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				std::mt19937 generator(1);
+				std::uniform_real_distribution<double> unit(-1, 1);
+				std::uniform_real_distribution<double> ratio(0.9, 1.0);
+				for (int i = 0; i < NUM_STEPS; i++) {
+					directions.push_back(Vector3d(unit(generator), unit(generator), 0).norm());
+					normals.push_back(Vector3d(unit(generator), unit(generator), 0).norm());
+					ratios.push_back(ratio(generator));
+				}
+			}
+
+			double trigonometric(int i, double &x, double &y) {
+
+				Vector3d d = directions[i];
+				double angle = atan2(d.y, d.x);
+				x = cos(angle);
+				y = sin(angle);
+
+				double theta = Constants::PI - d.angle(normals[i]);
+				double incidentAngle = acos(std::abs(d * normals[i]) / (d.magnitude() * normals[i].magnitude()));
+				return incidentAngle >= asin(ratios[i]) ? cos(theta) : -cos(theta);
+			}
+
+			double trigonometryFree(int i, double &x, double &y) {
+
+				Vector3d d = directions[i];
+				double planar = sqrt(d.x * d.x + d.y * d.y);
+				x = d.x / planar;
+				y = d.y / planar;
+
+				double cosine = d.cosine(normals[i]);
+				double sine = sqrt(1 - cosine * cosine);
+				double cosTheta = Ionosphere::COS_PI * cosine + Ionosphere::SIN_PI * sine;
+				return sine >= ratios[i] ? cosTheta : -cosTheta;
+			}
+
+			static const int NUM_STEPS = 1000000;
+			std::vector<Vector3d> directions, normals;
+			std::vector<double> ratios;
+	};
+
+	TEST_F(StepGeometryBenchmarkTest, DISABLED_Throughput) {
+
+		double x, y, sum = 0, maxDifference = 0;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int i = 0; i < NUM_STEPS; i++) {
+			sum += trigonometric(i, x, y) + x + y;
+		}
+		double trigonometricSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < NUM_STEPS; i++) {
+			sum -= trigonometryFree(i, x, y) + x + y;
+		}
+		double trigonometryFreeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		for (int i = 0; i < NUM_STEPS; i++) {
+			double x1, y1, x2, y2;
+			double difference = std::abs(trigonometric(i, x1, y1) - trigonometryFree(i, x2, y2));
+			maxDifference = std::max(maxDifference, std::max(difference, std::abs(x1 - x2) + std::abs(y1 - y2)));
+		}
+
+		EXPECT_LT(maxDifference, 1e-9);
+
+		std::cout << "trigonometric: " << NUM_STEPS / trigonometricSeconds << " steps/s, trigonometry free: "
+				<< NUM_STEPS / trigonometryFreeSeconds << " steps/s, speedup "
+				<< trigonometricSeconds / trigonometryFreeSeconds << " (checksum " << sum
+				<< ", max difference " << maxDifference << ")" << std::endl;
+	}
+}
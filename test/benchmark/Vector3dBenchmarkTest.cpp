@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../../src/math/Vector3d.h"
+#include "../../src/math/Matrix3d.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace raytracer::math;
+
+	/**
+	 * Throughput of the Vector3d operations on the per-step hot path, over
+	 * arrays of vectors as in a packet of rays: a straight line step, the
+	 * distance between the old and new origins, a normalization and a
+	 * rotation.
+	 */
+	class Vector3dBenchmarkTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				std::mt19937 generator(1);
+				std::uniform_real_distribution<double> unit(-1, 1);
+				for (int i = 0; i < NUM_VECTORS; i++) {
+					origins.push_back(Vector3d(unit(generator), unit(generator), unit(generator)) * 3390e3);
+					directions.push_back(Vector3d(unit(generator), unit(generator), unit(generator)).norm());
+				}
+			}
+
+			static const int NUM_VECTORS = 4096;
+			static const int ITERATIONS = 2000;
+			std::vector<Vector3d> origins, directions;
+	};
+
+	TEST_F(Vector3dBenchmarkTest, DISABLED_Throughput) {
+
+		Matrix3d rotation = Matrix3d::createRotationMatrix(1e-3, Matrix3d::ROTATION_Z);
+		double distance = 0;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+			for (int i = 0; i < NUM_VECTORS; i++) {
+				Vector3d next = origins[i] + directions[i] * 500;
+				distance += next.distance(origins[i]);
+				origins[i] = next;
+				directions[i] = (rotation * directions[i]).norm();
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		EXPECT_NEAR(500.0 * NUM_VECTORS * ITERATIONS, distance, 1e-3 * distance);
+
+		std::cout << sizeof(Vector3d) << " byte vectors: " << NUM_VECTORS * (double) ITERATIONS / seconds
+				<< " steps/s" << std::endl;
+	}
+}
@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include "../../src/commands/Merge.h"
+#include "../../src/exporter/BinaryExporter.h"
+
+namespace {
+
+	using namespace ::raytracer::commands;
+	using namespace ::raytracer::exporter;
+
+	/**
+	 * Keeps the merged records in memory
+	 */
+	class MemoryExporter : public IExporter {
+
+		public:
+			void open(const char *filepath) {}
+			void write(const Data *records, size_t count) {
+				data.insert(data.end(), records, records + count);
+			}
+			void close() {}
+
+			std::vector<Data> data;
+	};
+
+	class MergeTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::fatal);
+			}
+
+			void TearDown() {
+
+				boost::log::core::get()->reset_filter();
+				for (const std::string &input : inputs) {
+					std::remove(input.c_str());
+					std::remove(Merge::getManifestPath(input).c_str());
+				}
+			}
+
+			/**
+			 * Write a shard output with the records of the given rays. The
+			 * records of the rays are interleaved, as those of parallel
+			 * workers are.
+			 */
+			void writeShard(const std::vector<int> &rayNumbers, int recordsPerRay) {
+
+				std::vector<Data> records;
+				for (int i = 0; i < recordsPerRay; i++) {
+					for (int rayNumber : rayNumbers) {
+						Data d;
+						d.rayNumber = rayNumber;
+						d.timeOfFlight = i;
+						records.push_back(d);
+					}
+				}
+
+				inputs.push_back("MergeTest" + std::to_string(inputs.size()) + ".bin");
+				BinaryExporter exporter;
+				exporter.open(inputs.back().c_str());
+				exporter.write(records.data(), records.size());
+				exporter.close();
+			}
+
+			/**
+			 * Write the manifests of the shards, as the shards do when they
+			 * finish
+			 */
+			void writeManifests(int numShards) {
+
+				for (size_t shard = 0; shard < inputs.size(); shard++) {
+					std::ofstream file(Merge::getManifestPath(inputs[shard]).c_str());
+					file << "{\"shard\": " << shard << ", \"shards\": " << numShards << "}";
+				}
+			}
+
+			std::vector<std::string> inputs;
+	};
+
+	TEST_F(MergeTest, MergesInRayOrder) {
+
+		writeShard({5, 1, 3}, 10);
+		writeShard({4, 2}, 10);
+		writeManifests(2);
+
+		// room for a few records only, so that many runs are merged
+		MemoryExporter exporter;
+		Merge merge(inputs, "MergeTest.out", &exporter, 4 * sizeof(Data));
+		merge.start();
+		merge.run();
+		merge.stop();
+
+		ASSERT_EQ(50u, exporter.data.size());
+		for (size_t i = 0; i < exporter.data.size(); i++) {
+			ASSERT_EQ(1 + (int)i / 10, exporter.data[i].rayNumber);
+			ASSERT_EQ(i % 10, exporter.data[i].timeOfFlight);
+		}
+
+		// the sorted runs are removed
+		ASSERT_FALSE(std::ifstream("MergeTest.out.run0").good());
+	}
+
+	TEST_F(MergeTest, MergesInPasses) {
+
+		writeShard({3, 1}, 100);
+		writeShard({2}, 100);
+		writeManifests(2);
+
+		// a run per record, more than are merged at once
+		MemoryExporter exporter;
+		Merge merge(inputs, "MergeTest.out", &exporter, sizeof(Data));
+		merge.start();
+		merge.run();
+		merge.stop();
+
+		ASSERT_EQ(300u, exporter.data.size());
+		for (size_t i = 0; i < exporter.data.size(); i++) {
+			ASSERT_EQ(1 + (int)i / 100, exporter.data[i].rayNumber);
+			ASSERT_EQ(i % 100, exporter.data[i].timeOfFlight);
+		}
+
+		// the runs of every pass are removed
+		ASSERT_FALSE(std::ifstream("MergeTest.out.run0").good());
+		ASSERT_FALSE(std::ifstream("MergeTest.out.run300").good());
+	}
+
+	TEST_F(MergeTest, UnfinishedShard) {
+
+		writeShard({1}, 10);
+		writeShard({2}, 10);
+		writeManifests(2);
+		std::remove(Merge::getManifestPath(inputs[1]).c_str());
+
+		MemoryExporter exporter;
+		Merge merge(inputs, "MergeTest.out", &exporter, 1 << 20);
+		ASSERT_EXIT(merge.start(), ::testing::ExitedWithCode(1), "");
+	}
+
+	TEST_F(MergeTest, MissingShard) {
+
+		writeShard({1}, 10);
+		writeManifests(2);
+
+		MemoryExporter exporter;
+		Merge merge(inputs, "MergeTest.out", &exporter, 1 << 20);
+		ASSERT_EXIT(merge.start(), ::testing::ExitedWithCode(1), "");
+	}
+}
@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include "../../src/core/Checkpoint.h"
+
+namespace {
+
+	using namespace ::raytracer::core;
+
+	class CheckpointTest : public ::testing::Test {
+
+		protected:
+			void TearDown() {
+
+				std::remove(FILEPATH);
+			}
+
+			static constexpr const char *FILEPATH = "CheckpointTest.checkpoint.json";
+	};
+
+	TEST_F(CheckpointTest, LoadsWhatIsSaved) {
+
+		Checkpoint checkpoint;
+		checkpoint.iteration = 2;
+		checkpoint.nextIndex = 5000000000ull;
+		checkpoint.outputOffset = 123456789012ull;
+		checkpoint.raysPerIteration = 6000000000ull;
+		checkpoint.shard = 3;
+		checkpoint.numShards = 4;
+		checkpoint.save(FILEPATH);
+
+		Checkpoint loaded;
+		ASSERT_TRUE(loaded.load(FILEPATH));
+		ASSERT_EQ(2, loaded.iteration);
+		ASSERT_EQ(5000000000ull, loaded.nextIndex);
+		ASSERT_EQ(123456789012ull, loaded.outputOffset);
+		ASSERT_EQ(6000000000ull, loaded.raysPerIteration);
+		ASSERT_EQ(3, loaded.shard);
+		ASSERT_EQ(4, loaded.numShards);
+
+		// the temporary file has replaced the checkpoint
+		ASSERT_FALSE(std::ifstream((std::string(FILEPATH) + ".tmp").c_str()).good());
+	}
+
+	TEST_F(CheckpointTest, MissingOrBrokenCheckpoint) {
+
+		Checkpoint checkpoint;
+		ASSERT_FALSE(checkpoint.load("CheckpointTest.missing"));
+
+		std::ofstream file(FILEPATH);
+		file << "{ \"iteration\": ";
+		file.close();
+		ASSERT_FALSE(checkpoint.load(FILEPATH));
+	}
+
+	TEST_F(CheckpointTest, Path) {
+
+		ASSERT_EQ("Debug/data.dat.checkpoint.json", Checkpoint::getPath("Debug/data.dat"));
+	}
+}
@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+#include "../../src/core/LaunchGrid.h"
+#include "../../src/core/Config.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace ::raytracer::core;
+	using namespace ::raytracer::tracer;
+	using namespace ::raytracer::math;
+
+	class LaunchGridTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				appConf = Config("config/config.json");
+			}
+
+			Config appConf;
+	};
+
+	TEST_F(LaunchGridTest, Sweep) {
+
+		LaunchGrid::Sweep sweep(0, 0.1, 1.0);
+		ASSERT_EQ(11u, sweep.size);
+		ASSERT_DOUBLE_EQ(0.7, sweep.at(7));
+
+		ASSERT_EQ(13u, LaunchGrid::Sweep(15, 5, 75).size);
+		ASSERT_EQ(1u, LaunchGrid::Sweep(0, 20, 0).size);
+		ASSERT_EQ(0u, LaunchGrid::Sweep(10, 1, 5).size);
+	}
+
+	TEST_F(LaunchGridTest, Size) {
+
+		LaunchGrid grid(appConf, 3390e3, 4e6, 5e5, 5e6);
+
+		ASSERT_EQ(1u, grid.getNumBeacons());
+		ASSERT_EQ(1u, grid.getAzimuths().size);
+		ASSERT_EQ(3u, grid.getFrequencies().size);
+		ASSERT_EQ(13u, grid.getElevations().size);
+		ASSERT_EQ(39u, grid.size());
+	}
+
+	TEST_F(LaunchGridTest, RayAt) {
+
+		LaunchGrid grid(appConf, 3390e3, 4e6, 5e5, 5e6);
+
+		// elevation varies fastest, then frequency
+		Ray r = grid.rayAt(15);
+		ASSERT_EQ(16, r.rayNumber);
+		ASSERT_EQ(4.5e6, r.frequency);
+		ASSERT_EQ(25 * Constants::PI / 180.0, r.originalAngle);
+		ASSERT_EQ(1, r.originBeaconId);
+		ASSERT_EQ(0, r.originalAzimuth);
+		ASSERT_EQ(3390e3 + 2, r.o.y);
+		ASSERT_NEAR(cos(Constants::PI / 2.0 - r.originalAngle), r.d.x, 1e-12);
+		ASSERT_NEAR(sin(Constants::PI / 2.0 - r.originalAngle), r.d.y, 1e-12);
+	}
+}
@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <vector>
+#include <boost/thread.hpp>
+#include "../../src/core/RayCache.h"
+
+namespace {
+
+	using namespace ::raytracer::core;
+	using namespace ::raytracer::exporter;
+	using namespace ::raytracer::tracer;
+
+	class RayCacheTest : public ::testing::Test {
+
+		protected:
+			void TearDown() {
+
+				std::system("rm -rf RayCacheTest.cache");
+			}
+
+			static Ray createRay(int rayNumber, double frequency) {
+
+				Ray r;
+				r.rayNumber = rayNumber;
+				r.originBeaconId = 1;
+				r.frequency = frequency;
+				r.o = ::raytracer::math::Vector3d(0, 3390002, 0);
+				r.d = ::raytracer::math::Vector3d(0.5, 0.5, 0).norm();
+				r.originalAngle = 0.25;
+				r.signalPower = 1;
+				return r;
+			}
+
+			static std::vector<Data> createRecords(const Ray &ray, int numRecords) {
+
+				std::vector<Data> records(numRecords);
+				for (int i = 0; i < numRecords; i++) {
+					records[i].rayNumber = ray.rayNumber;
+					records[i].beaconId = ray.originBeaconId;
+					records[i].x = i;
+					records[i].frequency = ray.frequency;
+				}
+				return records;
+			}
+
+			static void wait() {
+
+				boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+			}
+
+			static constexpr const char *DIRECTORY = "RayCacheTest.cache";
+	};
+
+	TEST_F(RayCacheTest, LoadsStoredRays) {
+
+		RayCache cache(DIRECTORY, 1, 1 << 20, SimulationContext::eviction_lru);
+		Ray ray = createRay(5, 4e6);
+		std::vector<Data> records;
+		Tracer::traceState state = Tracer::state_tracing;
+		ASSERT_FALSE(cache.load(ray, records, state));
+		cache.store(ray, createRecords(ray, 3), Tracer::state_terrain);
+
+		// the same launch, in a run where it has another number and beacon
+		Ray other = createRay(9, 4e6);
+		other.originBeaconId = 2;
+		ASSERT_TRUE(cache.load(other, records, state));
+		ASSERT_EQ(Tracer::state_terrain, state);
+		ASSERT_EQ(3u, records.size());
+		for (int i = 0; i < 3; i++) {
+			ASSERT_EQ(9, records[i].rayNumber);
+			ASSERT_EQ(2, records[i].beaconId);
+			ASSERT_EQ(i, records[i].x);
+		}
+
+		ASSERT_FALSE(cache.load(createRay(5, 4.5e6), records, state));
+		ASSERT_TRUE(records.empty());
+		ASSERT_EQ(1u, cache.getNumHits());
+		ASSERT_EQ(2u, cache.getNumMisses());
+	}
+
+	TEST_F(RayCacheTest, SeparatesConfigurations) {
+
+		Ray ray = createRay(1, 4e6);
+		RayCache(DIRECTORY, 1, 1 << 20, SimulationContext::eviction_lru).store(ray, createRecords(ray, 2), Tracer::state_terrain);
+
+		std::vector<Data> records;
+		Tracer::traceState state;
+		ASSERT_FALSE(RayCache(DIRECTORY, 2, 1 << 20, SimulationContext::eviction_lru).load(ray, records, state));
+		ASSERT_TRUE(RayCache(DIRECTORY, 1, 1 << 20, SimulationContext::eviction_lru).load(ray, records, state));
+	}
+
+	TEST_F(RayCacheTest, EvictsLeastRecentlyUsed) {
+
+		Ray rays[3] = {createRay(1, 4e6), createRay(2, 5e6), createRay(3, 6e6)};
+		RayCache cache(DIRECTORY, 1, 0, SimulationContext::eviction_lru);
+		for (const Ray &ray : rays) {
+			cache.store(ray, createRecords(ray, 100), Tracer::state_terrain);
+			wait();
+		}
+		std::vector<Data> records;
+		Tracer::traceState state;
+		ASSERT_TRUE(cache.load(rays[0], records, state));
+		wait();
+
+		// room for two of the three rays
+		RayCache limited(DIRECTORY, 1, 2 * 100 * sizeof(Data) + 1000, SimulationContext::eviction_lru);
+		ASSERT_EQ(1u, limited.evict());
+		ASSERT_TRUE(limited.load(rays[0], records, state));
+		ASSERT_FALSE(limited.load(rays[1], records, state));
+		ASSERT_TRUE(limited.load(rays[2], records, state));
+	}
+
+	TEST_F(RayCacheTest, EvictsOldest) {
+
+		Ray rays[3] = {createRay(1, 4e6), createRay(2, 5e6), createRay(3, 6e6)};
+		RayCache cache(DIRECTORY, 1, 0, SimulationContext::eviction_oldest);
+		for (const Ray &ray : rays) {
+			cache.store(ray, createRecords(ray, 100), Tracer::state_terrain);
+			wait();
+		}
+		std::vector<Data> records;
+		Tracer::traceState state;
+		ASSERT_TRUE(cache.load(rays[0], records, state));
+		wait();
+
+		RayCache limited(DIRECTORY, 1, 2 * 100 * sizeof(Data) + 1000, SimulationContext::eviction_oldest);
+		ASSERT_EQ(1u, limited.evict());
+		ASSERT_FALSE(limited.load(rays[0], records, state));
+		ASSERT_TRUE(limited.load(rays[1], records, state));
+		ASSERT_TRUE(limited.load(rays[2], records, state));
+	}
+
+	TEST_F(RayCacheTest, StableHash) {
+
+		ASSERT_EQ(RayCache::FNV_OFFSET_BASIS, RayCache::hash("", 0));
+		ASSERT_EQ(0xaf63dc4c8601ec8cull, RayCache::hash("a", 1));
+	}
+}
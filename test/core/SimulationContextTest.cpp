@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+#include "../../src/core/SimulationContext.h"
+#include "../../src/core/Config.h"
+
+namespace {
+
+	using namespace raytracer::core;
+	using namespace raytracer::math;
+
+	class SimulationContextTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				conf = Config("config/scenario_default.json");
+				appConf = Config("config/config_simplemagneticfield.json");
+			}
+
+			Config conf, appConf;
+	};
+
+	TEST_F(SimulationContextTest, CelestialValues) {
+
+		SimulationContext context = SimulationContext(appConf, conf, false);
+
+		ASSERT_EQ(3390e3, context.radius);
+		ASSERT_EQ(3390e3 + 250e3, context.sceneBoundary);
+		ASSERT_NEAR(2.8e17, context.surfaceNCO2, 1e12);
+		ASSERT_EQ(70e3, context.ionosphereStart);
+		ASSERT_EQ(500, context.ionosphereStep);
+		ASSERT_EQ(250e3, context.ionosphereEnd);
+	}
+
+	TEST_F(SimulationContextTest, IonosphereLayers) {
+
+		SimulationContext context = SimulationContext(appConf, conf, false);
+
+		ASSERT_EQ(1, context.ionosphereLayers.size());
+		ASSERT_NEAR(2.5e11, context.ionosphereLayers[0].electronPeakDensity, 1e6);
+		ASSERT_EQ(125e3, context.ionosphereLayers[0].peakProductionAltitude);
+		ASSERT_EQ(11.1e3, context.ionosphereLayers[0].neutralScaleHeight);
+	}
+
+	TEST_F(SimulationContextTest, ApplicationValues) {
+
+		SimulationContext context = SimulationContext(appConf, conf, true);
+
+		ASSERT_EQ(5000, context.tracingLimit);
+		ASSERT_NEAR(0.03491, context.angularStepSize, 1e-9);
+		ASSERT_TRUE(context.includeMagneticField);
+
+		// configurations without the blocks keep the exact ionosphere
+		ASSERT_FALSE(context.useIonosphereTable);
+		ASSERT_FALSE(context.skipEmptySpace);
+	}
+
+	TEST_F(SimulationContextTest, MagneticFields) {
+
+		SimulationContext context = SimulationContext(appConf, conf, false);
+
+		ASSERT_EQ(1, context.magneticFields.size());
+		ASSERT_NEAR(0.00005, context.getMagneticFieldStrength(), 1e-9);
+		ASSERT_EQ(1, context.magneticFields[0].direction.z);
+
+		Config noFieldConf = Config("config/config_nomagneticfield.json");
+		SimulationContext context2 = SimulationContext(noFieldConf, conf, false);
+
+		ASSERT_EQ(0, context2.magneticFields.size());
+		ASSERT_EQ(0, context2.getMagneticFieldStrength());
+	}
+
+	TEST_F(SimulationContextTest, LegacyIonosphereFormat) {
+
+		Config legacyConf = Config("config/scenario_test.json");
+		SimulationContext context = SimulationContext(appConf, legacyConf, false);
+
+		ASSERT_EQ(3390e3, context.radius);
+		ASSERT_EQ(0, context.ionosphereLayers.size());
+	}
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include <boost/thread.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include "../../src/core/TracingStatistics.h"
+#include "../../src/core/Application.h"
+#include "../../src/core/Config.h"
+#include "../../src/tracer/Tracer.h"
+#include "../../src/tracer/Ray.h"
+
+namespace {
+
+	using namespace ::raytracer::core;
+	using namespace ::raytracer::tracer;
+	using namespace ::raytracer::scene;
+	using namespace ::raytracer::math;
+
+	class TracingStatisticsTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+				TracingStatistics::reset();
+			}
+
+			void TearDown() {
+
+				boost::log::core::get()->reset_filter();
+				Application::getInstance().dataSet.clear();
+			}
+
+			static void count(int steps) {
+
+				for (int i = 0; i < steps; i++) {
+					TracingStatistics::local().increment(TracingStatistics::counter_steps);
+				}
+				TracingStatistics::local().recordTermination(Tracer::state_terrain);
+			}
+	};
+
+	TEST_F(TracingStatisticsTest, AggregatesThreads) {
+
+		size_t numThreads = TracingStatistics::perThread().size();
+
+		boost::thread_group threads;
+		for (int i = 0; i < 4; i++) {
+			threads.create_thread(boost::bind(&TracingStatisticsTest::count, 100000));
+		}
+		threads.join_all();
+
+		// the counters of ended threads are kept
+		TracingStatistics statistics = TracingStatistics::aggregate();
+		ASSERT_EQ(400000u, statistics.get(TracingStatistics::counter_steps));
+		ASSERT_EQ(4u, statistics.get(TracingStatistics::counter_terrain));
+		ASSERT_EQ(numThreads + 4, TracingStatistics::perThread().size());
+
+		TracingStatistics::reset();
+		ASSERT_EQ(0u, TracingStatistics::aggregate().get(TracingStatistics::counter_steps));
+	}
+
+	TEST_F(TracingStatisticsTest, CountsTracerSteps) {
+
+		Config conf = Config("config/scenario_default.json");
+		Config appConf = Config("config/config.json");
+		Application::getInstance().setCelestialConfig(conf);
+		Application::getInstance().setApplicationConfig(appConf);
+		SimulationContext context = Application::getInstance().getSimulationContext();
+		context.terrain = SimulationContext::terrain_sphere;
+		SceneManager scm;
+		scm.loadStaticEnvironment(context);
+
+		Ray r;
+		r.o = Vector3d(0, 3390e3 + 2, 0);
+		r.d = Vector3d(sin(30 * Constants::PI / 180), cos(30 * Constants::PI / 180), 0);
+		r.frequency = 4.5e6;
+		Tracer tracer(r, context, scm);
+		TracingStatistics::local().recordTermination(tracer.run());
+
+		TracingStatistics statistics = TracingStatistics::aggregate();
+		ASSERT_EQ(Tracer::state_terrain, tracer.getState());
+		ASSERT_EQ((uint64_t)r.tracings, statistics.get(TracingStatistics::counter_steps));
+		ASSERT_EQ(1u, statistics.get(TracingStatistics::counter_terrain));
+		ASSERT_GT(statistics.get(TracingStatistics::counter_reflections), 0u);
+		ASSERT_GT(statistics.get(TracingStatistics::counter_refractions), 0u);
+	}
+}
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include "../../src/exporter/BinaryExporter.h"
+
+namespace {
+
+	using namespace ::raytracer::exporter;
+
+	class BinaryExporterTest : public ::testing::Test {
+
+		protected:
+			void TearDown() {
+
+				std::remove(FILEPATH);
+			}
+
+			static constexpr const char *FILEPATH = "BinaryExporterTest.bin";
+	};
+
+	TEST_F(BinaryExporterTest, ReadsWhatIsWritten) {
+
+		Data records[3];
+		for (int i = 0; i < 3; i++) {
+			records[i].rayNumber = i + 1;
+			records[i].x = 1.0 / 3 + i;
+			records[i].collisionType = ::raytracer::scene::GeometryType::terrain;
+		}
+
+		BinaryExporter exporter;
+		exporter.open(FILEPATH);
+		exporter.write(records, 2);
+		exporter.write(records + 2, 1);
+		exporter.close();
+
+		BinaryReader reader(FILEPATH);
+		ASSERT_TRUE(reader.isOpen());
+
+		Data read[4];
+		ASSERT_EQ(3u, reader.read(read, 4));
+		for (int i = 0; i < 3; i++) {
+			ASSERT_EQ(i + 1, read[i].rayNumber);
+			ASSERT_EQ(1.0 / 3 + i, read[i].x);
+			ASSERT_EQ(::raytracer::scene::GeometryType::terrain, read[i].collisionType);
+		}
+		ASSERT_EQ(0u, reader.read(read, 4));
+	}
+
+	TEST_F(BinaryExporterTest, RejectsOtherFiles) {
+
+		std::ofstream file(FILEPATH);
+		file << "1.0,2.0,3.0\n";
+		file.close();
+
+		ASSERT_FALSE(BinaryReader(FILEPATH).isOpen());
+		ASSERT_FALSE(BinaryReader("BinaryExporterTest.missing").isOpen());
+	}
+
+	TEST_F(BinaryExporterTest, ResumesAfterRecords) {
+
+		Data records[2];
+		records[0].rayNumber = 1;
+		records[1].rayNumber = 2;
+
+		BinaryExporter exporter;
+		exporter.open(FILEPATH);
+		exporter.write(records, 1);
+		exporter.close();
+
+		BinaryExporter resumed;
+		ASSERT_TRUE(resumed.canResume());
+		ASSERT_TRUE(resumed.resume(FILEPATH));
+		resumed.write(records + 1, 1);
+		resumed.close();
+
+		BinaryReader reader(FILEPATH);
+		Data read[3];
+		ASSERT_EQ(2u, reader.read(read, 3));
+		ASSERT_EQ(1, read[0].rayNumber);
+		ASSERT_EQ(2, read[1].rayNumber);
+
+		std::ofstream file(FILEPATH);
+		file << "1.0,2.0,3.0\n";
+		file.close();
+		ASSERT_FALSE(BinaryExporter().resume(FILEPATH));
+	}
+}
@@ -0,0 +1,170 @@
+#include "gtest/gtest.h"
+#include <vector>
+#include <boost/thread.hpp>
+#include "../../src/exporter/DataWriter.h"
+
+namespace {
+
+	using namespace ::raytracer::exporter;
+
+	/**
+	 * Keeps the dumped records in memory. Only the writer thread dumps.
+	 */
+	class MemoryExporter : public IExporter {
+
+		public:
+			void open(const char *filepath) {
+				numOpened++;
+			}
+
+			void write(const Data *records, size_t count) {
+				if (delay > 0) {
+					boost::this_thread::sleep(boost::posix_time::milliseconds(delay));
+				}
+				batches.push_back(std::vector<Data>(records, records + count));
+			}
+
+			void close() {
+				numClosed++;
+			}
+
+			bool resume(const char *filepath) {
+				numResumed++;
+				return true;
+			}
+
+			void flush() {
+				numFlushed++;
+			}
+
+			std::vector<std::vector<Data> > batches;
+			int delay = 0;
+			int numOpened = 0;
+			int numClosed = 0;
+			int numResumed = 0;
+			int numFlushed = 0;
+	};
+
+	class DataWriterTest : public ::testing::Test {
+
+		protected:
+			/**
+			 * Add the records of a beacon, numbered from 1
+			 */
+			static void add(DataWriter *writer, int beaconId, int numRecords) {
+
+				for (int i = 1; i <= numRecords; i++) {
+					Data d;
+					d.rayNumber = i;
+					d.beaconId = beaconId;
+					writer->add(d);
+				}
+			}
+
+			MemoryExporter exporter;
+	};
+
+	TEST_F(DataWriterTest, WritesRecordsOfAllThreads) {
+
+		DataWriter writer(&exporter, "", 1 << 20);
+
+		boost::thread_group threads;
+		for (int b = 0; b < 4; b++) {
+			threads.create_thread(boost::bind(&DataWriterTest::add, &writer, b, 20000));
+		}
+		threads.join_all();
+		writer.close();
+
+		// the records of a thread are written in the order they were added
+		std::vector<int> lastRecord(4, 0);
+		int numRecords = 0;
+		for (const std::vector<Data> &batch : exporter.batches) {
+			ASSERT_LE(batch.size(), writer.getBufferSize());
+			for (const Data &d : batch) {
+				ASSERT_EQ(lastRecord[d.beaconId] + 1, d.rayNumber);
+				lastRecord[d.beaconId] = d.rayNumber;
+				numRecords++;
+			}
+		}
+		ASSERT_EQ(80000, numRecords);
+	}
+
+	TEST_F(DataWriterTest, MemoryBudget) {
+
+		exporter.delay = 1;
+		size_t bufferSize = 100;
+		DataWriter writer(&exporter, "", 4 * bufferSize * sizeof(Data));
+		ASSERT_EQ(bufferSize, writer.getBufferSize());
+
+		boost::thread_group threads;
+		for (int b = 0; b < 2; b++) {
+			threads.create_thread(boost::bind(&DataWriterTest::add, &writer, b, 10000));
+		}
+		threads.join_all();
+		writer.close();
+
+		// the writer is slower than the threads, which had to wait for it
+		ASSERT_GT(writer.getNumWaits(), 0u);
+		int numRecords = 0;
+		for (const std::vector<Data> &batch : exporter.batches) {
+			numRecords += batch.size();
+		}
+		ASSERT_EQ(20000, numRecords);
+	}
+
+	TEST_F(DataWriterTest, KeepsRecordsOfRayTogether) {
+
+		size_t bufferSize = 2;
+		DataWriter writer(&exporter, "", 4 * bufferSize * sizeof(Data));
+		ASSERT_EQ(bufferSize, writer.getBufferSize());
+
+		for (int rayNumber = 1; rayNumber <= 3; rayNumber++) {
+			for (int i = 0; i < 5; i++) {
+				Data d;
+				d.rayNumber = rayNumber;
+				writer.add(d);
+			}
+		}
+		writer.close();
+
+		// a full buffer is only handed off when the next ray starts
+		ASSERT_EQ(3u, exporter.batches.size());
+		for (size_t b = 0; b < exporter.batches.size(); b++) {
+			ASSERT_EQ(5u, exporter.batches[b].size());
+			for (const Data &d : exporter.batches[b]) {
+				ASSERT_EQ((int)b + 1, d.rayNumber);
+			}
+		}
+	}
+
+	TEST_F(DataWriterTest, WritesPartialBuffersOnClose) {
+
+		DataWriter writer(&exporter, "", 1 << 20);
+		add(&writer, 0, 10);
+		ASSERT_EQ(1, exporter.numOpened);
+		ASSERT_TRUE(exporter.batches.empty());
+
+		writer.close();
+		ASSERT_EQ(1u, exporter.batches.size());
+		ASSERT_EQ(10u, exporter.batches[0].size());
+		ASSERT_EQ(1, exporter.numClosed);
+	}
+
+	TEST_F(DataWriterTest, FlushWritesPartialBuffers) {
+
+		DataWriter writer(&exporter, "", 1 << 20, true);
+		ASSERT_EQ(0, exporter.numOpened);
+		ASSERT_EQ(1, exporter.numResumed);
+
+		add(&writer, 0, 10);
+		writer.flush();
+		ASSERT_EQ(1u, exporter.batches.size());
+		ASSERT_EQ(10u, exporter.batches[0].size());
+		ASSERT_EQ(1, exporter.numFlushed);
+
+		add(&writer, 0, 5);
+		writer.close();
+		ASSERT_EQ(2u, exporter.batches.size());
+		ASSERT_EQ(5u, exporter.batches[1].size());
+	}
+}
@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include "../../src/exporter/JsonExporter.h"
+#include "../../contrib/jsoncpp/reader.h"
+
+namespace {
+
+	using namespace ::raytracer::exporter;
+
+	class JsonExporterTest : public ::testing::Test {
+
+		protected:
+			void TearDown() {
+
+				std::remove(FILEPATH);
+			}
+
+			Json::Value read() {
+
+				std::ifstream file(FILEPATH);
+				Json::Value root;
+				Json::Reader reader;
+				EXPECT_TRUE(reader.parse(file, root, false));
+				return root;
+			}
+
+			static constexpr const char *FILEPATH = "JsonExporterTest.json";
+	};
+
+	TEST_F(JsonExporterTest, StreamsBatches) {
+
+		Data records[3];
+		records[0].rayNumber = 1;
+		records[1].rayNumber = 1;
+		records[2].rayNumber = 2;
+
+		JsonExporter exporter;
+		exporter.open(FILEPATH);
+		exporter.write(records, 2);
+		exporter.write(records + 2, 1);
+		exporter.close();
+
+		Json::Value root = read();
+		ASSERT_EQ(2u, root["rays"].size());
+		ASSERT_EQ(2u, root["rays"][0]["data"].size());
+		ASSERT_EQ(1u, root["rays"][1]["data"].size());
+	}
+
+	TEST_F(JsonExporterTest, InterleavedRays) {
+
+		Data records[3];
+		records[0].rayNumber = 1;
+		records[1].rayNumber = 2;
+		records[2].rayNumber = 1;
+
+		JsonExporter exporter;
+		exporter.open(FILEPATH);
+		exporter.write(records, 3);
+		exporter.close();
+
+		ASSERT_EQ(3u, read()["rays"].size());
+	}
+
+	TEST_F(JsonExporterTest, EmptyDataset) {
+
+		JsonExporter exporter;
+		exporter.open(FILEPATH);
+		exporter.close();
+
+		ASSERT_EQ(0u, read()["rays"].size());
+	}
+
+	TEST_F(JsonExporterTest, CanNotBeResumed) {
+
+		JsonExporter exporter;
+		ASSERT_FALSE(exporter.canResume());
+		ASSERT_FALSE(exporter.resume(FILEPATH));
+	}
+}
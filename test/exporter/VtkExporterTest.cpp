@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "../../src/exporter/VtkExporter.h"
+
+namespace {
+
+	using namespace ::raytracer::exporter;
+
+	class VtkExporterTest : public ::testing::Test {
+
+		protected:
+			void TearDown() {
+
+				std::remove(FILEPATH);
+			}
+
+			static constexpr const char *FILEPATH = "VtkExporterTest.vtk";
+	};
+
+	TEST_F(VtkExporterTest, ConnectsPointsOfEachRay) {
+
+		Data records[5];
+		int rayNumbers[5] = {1, 1, 2, 2, 2};
+		for (int i = 0; i < 5; i++) {
+			records[i].rayNumber = rayNumbers[i];
+			records[i].x = i;
+		}
+
+		VtkExporter exporter;
+		exporter.open(FILEPATH);
+		exporter.write(records, 3);
+		exporter.write(records + 3, 2);
+		exporter.close();
+
+		std::ifstream file(FILEPATH);
+		std::string line;
+		std::vector<std::string> lines;
+		while (std::getline(file, line)) {
+			lines.push_back(line);
+		}
+
+		ASSERT_EQ(15u, lines.size());
+		ASSERT_EQ("2 Rays in vtk format", lines[1]);
+		ASSERT_EQ("POINTS 5 float", lines[4]);
+		ASSERT_EQ("2 0 0", lines[7]);
+		ASSERT_EQ("LINES 3 9", lines[11]);
+		ASSERT_EQ("2 0 1", lines[12]);
+		ASSERT_EQ("2 2 3", lines[13]);
+		ASSERT_EQ("2 3 4", lines[14]);
+
+		// the temporary files are removed
+		ASSERT_FALSE(std::ifstream("VtkExporterTest.vtk.points").good());
+	}
+}
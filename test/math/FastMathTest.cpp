@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "../../src/math/FastMath.h"
+
+namespace {
+
+	using namespace ::raytracer::math;
+
+	class FastMathTest : public ::testing::Test {
+
+		protected:
+			const double inf = std::numeric_limits<double>::infinity();
+	};
+
+	TEST_F(FastMathTest, Exp) {
+
+		std::vector<double> x, result;
+		for (double v = FastMath::EXP_MIN_ARGUMENT; v <= FastMath::EXP_MAX_ARGUMENT; v += 0.0137) {
+			x.push_back(v);
+		}
+		result.resize(x.size());
+
+		FastMath::exp(x.data(), result.data(), x.size());
+
+		for (size_t i = 0; i < x.size(); i++) {
+			double exact = std::exp(x[i]);
+			ASSERT_NEAR(exact, result[i], FastMath::EXP_MAX_ERROR * exact) << "x=" << x[i];
+		}
+	}
+
+	TEST_F(FastMathTest, ExpLimits) {
+
+		double x[] = {0, 1, -1000, 1000, -inf, inf, std::numeric_limits<double>::quiet_NaN()};
+		double result[7];
+
+		FastMath::exp(x, result, 7);
+
+		ASSERT_EQ(1.0, result[0]);
+		ASSERT_NEAR(M_E, result[1], 1e-15);
+		ASSERT_EQ(0.0, result[2]);
+		ASSERT_EQ(inf, result[3]);
+		ASSERT_EQ(0.0, result[4]);
+		ASSERT_EQ(inf, result[5]);
+		ASSERT_TRUE(std::isnan(result[6]));
+	}
+
+	TEST_F(FastMathTest, Log) {
+
+		std::vector<double> x, result;
+		for (double v = 1e-300; v < 1e300; v *= 1.0731) {
+			x.push_back(v);
+		}
+		for (double v = 0.5; v < 2; v += 1e-4) {
+			x.push_back(v);
+		}
+		result.resize(x.size());
+
+		FastMath::log(x.data(), result.data(), x.size());
+
+		for (size_t i = 0; i < x.size(); i++) {
+			double exact = std::log(x[i]);
+			ASSERT_NEAR(exact, result[i], FastMath::LOG_MAX_ERROR * std::max(1.0, std::abs(exact))) << "x=" << x[i];
+		}
+	}
+
+	TEST_F(FastMathTest, LogLimits) {
+
+		double x[] = {1, 2, 0, -1, inf, std::numeric_limits<double>::quiet_NaN()};
+
+		FastMath::log(x, x, 6);
+
+		ASSERT_EQ(0.0, x[0]);
+		ASSERT_NEAR(M_LN2, x[1], 1e-16);
+		ASSERT_EQ(-inf, x[2]);
+		ASSERT_TRUE(std::isnan(x[3]));
+		ASSERT_EQ(inf, x[4]);
+		ASSERT_TRUE(std::isnan(x[5]));
+	}
+}
@@ -98,4 +98,28 @@ namespace {
 
 		ASSERT_NEAR(0.5939, v5.angle(v3), 1e-4);
 	}
+
+	TEST_F(Vector3dTest, Cosine) {
+
+		Vector3d v1 = Vector3d(1, 0, 0);
+		Vector3d v2 = Vector3d(0, 1, 0);
+
+		ASSERT_NEAR(0, v1.cosine(v2), 1e-12);
+
+		Vector3d v3 = Vector3d(0.174, 0.985, 0);
+		Vector3d v4 = Vector3d(-0.643, -0.767, 2);
+
+		ASSERT_NEAR(cos(v3.angle(v4)), v3.cosine(v4), 1e-12);
+		ASSERT_NEAR(-1, v3.cosine(v3 * -2), 1e-12);
+	}
+
+	TEST_F(Vector3dTest, ConstantExpressions) {
+
+		constexpr Vector3d v1 = Vector3d(1, 2, 3);
+		constexpr Vector3d v2 = (v1 + v1 * 2 - Vector3d(0, 0, 1)) / 2;
+		static_assert(v2.dot(v1) == 19.5, "dot product of constant vectors");
+		static_assert(v1.cross(v2) * v1 == 0, "cross product is perpendicular");
+
+		ASSERT_EQ(19.5, v1 * v2);
+	}
 }
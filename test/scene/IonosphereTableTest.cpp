@@ -0,0 +1,104 @@
+#include "gtest/gtest.h"
+#include <vector>
+#include <cmath>
+#include "../../src/scene/IonosphereTable.h"
+#include "../../src/scene/Ionosphere.h"
+#include "../../src/core/SimulationContext.h"
+#include "../../src/core/Config.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace raytracer::scene;
+	using namespace raytracer::core;
+	using namespace raytracer::math;
+
+	class IonosphereTableTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				conf = Config("config/scenario_default.json");
+				appConf = Config("config/config.json");
+				context = SimulationContext(appConf, conf, false);
+				table.build(context, 1e-3);
+			}
+
+			Config conf, appConf;
+			SimulationContext context;
+			IonosphereTable table;
+	};
+
+	TEST_F(IonosphereTableTest, Build) {
+
+		ASSERT_TRUE(table.isBuilt());
+		ASSERT_LE(table.getMaxError(), 1e-3);
+		ASSERT_NEAR(2.5e11, table.getPeakElectronDensity(), 1e6);
+	}
+
+	TEST_F(IonosphereTableTest, ElectronNumberDensityWithinErrorBound) {
+
+		double peak = table.getPeakElectronDensity();
+		for (double h = 70e3; h < 250e3; h += 777) {
+			for (double SZA = 0; SZA < 85 * Constants::PI / 180; SZA += 0.0123) {
+				double exact = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, h, SZA);
+				ASSERT_NEAR(exact, table.getElectronNumberDensity(h, SZA), 1e-3 * peak);
+			}
+		}
+	}
+
+	TEST_F(IonosphereTableTest, BatchEvaluation) {
+
+		std::vector<double> altitudes, SZAs;
+		for (double h = 50e3; h < 300e3; h += 1234) {
+			for (double SZA = 0; SZA < IonosphereTable::MAX_SZA; SZA += 0.0321) {
+				altitudes.push_back(h);
+				SZAs.push_back(SZA);
+			}
+		}
+		std::vector<double> n_e(altitudes.size());
+
+		table.evaluateElectronNumberDensity(altitudes.data(), SZAs.data(), n_e.data(), n_e.size());
+
+		for (size_t i = 0; i < n_e.size(); i++) {
+			double exact = table.evaluateElectronNumberDensity(altitudes[i], SZAs[i]);
+			ASSERT_NEAR(exact, n_e[i], 1e-13 * table.getPeakElectronDensity());
+		}
+	}
+
+	TEST_F(IonosphereTableTest, PlasmaFrequency) {
+
+		Ionosphere io;
+		io.setElectronNumberDensity(table.getElectronNumberDensity(125e3, 0.3));
+
+		ASSERT_NEAR(io.getPlasmaFrequency(), table.getPlasmaFrequency(125e3, 0.3), 1e-6);
+	}
+
+	TEST_F(IonosphereTableTest, CollisionFrequency) {
+
+		for (double h = 70e3; h < 250e3; h += 333) {
+			double exact = Ionosphere::getCollisionFrequency(2.8e17, h);
+			ASSERT_NEAR(exact, table.getCollisionFrequency(h), 1e-3 * exact);
+		}
+	}
+
+	TEST_F(IonosphereTableTest, OutsideTableIsExact) {
+
+		double SZA = 1.56;
+		double exact = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, 130e3, SZA);
+		ASSERT_EQ(exact, table.getElectronNumberDensity(130e3, SZA));
+
+		exact = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, 300e3, 0.2);
+		ASSERT_EQ(exact, table.getElectronNumberDensity(300e3, 0.2));
+		ASSERT_EQ(Ionosphere::getCollisionFrequency(2.8e17, 10e3), table.getCollisionFrequency(10e3));
+	}
+
+	TEST_F(IonosphereTableTest, TighterBoundRefinesGrid) {
+
+		IonosphereTable fineTable;
+		fineTable.build(context, 2e-4);
+
+		ASSERT_LE(fineTable.getMaxError(), 2e-4);
+		ASSERT_LT(fineTable.getAltitudeStep(), table.getAltitudeStep());
+	}
+}
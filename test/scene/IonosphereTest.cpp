@@ -79,6 +79,26 @@ namespace {
 		ASSERT_NEAR(0, io3.getElectronNumberDensity(), 2.5e8);			// SZA = 90 deg
 	}
 
+	TEST_F(IonosphereTest, ChapmanDerivatives) {
+
+		for (double h = 80e3; h < 240e3; h += 10e3) {
+			for (double SZA = 0.1; SZA < 1.4; SZA += 0.25) {
+				double dh, dcos;
+				double n_e = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, h, SZA, dh, dcos);
+				ASSERT_EQ(Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, h, SZA), n_e);
+
+				double above = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, h + 1, SZA);
+				double below = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, h - 1, SZA);
+				ASSERT_NEAR((above - below) / 2, dh, 1e-6 * 2.5e11 / 11.1e3);
+
+				double c = cos(SZA);
+				above = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, h, acos(c + 1e-6));
+				below = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, h, acos(c - 1e-6));
+				ASSERT_NEAR((above - below) / 2e-6, dcos, 1e-5 * std::abs(dcos) + 1e2);
+			}
+		}
+	}
+
 	TEST_F(IonosphereTest, PlasmaFrequency) {
 
 		ASSERT_NEAR(5.9e6, io.getPlasmaFrequency(), 1e4);
@@ -385,6 +405,64 @@ namespace {
 		ASSERT_NEAR(0.00005, BTot, 1e-7);
 	}
 
+	TEST_F(IonosphereTest, FusedInteractionMatchesSequence) {
+
+		Config appConf = Config("config/config.json");
+		Application::getInstance().setApplicationConfig(appConf);
+		Application::getInstance().dataSet.clear();
+
+		for (Ionosphere *layer : {&io, &io2, &io3}) {
+			for (double angle : {5.0, 30.0, 60.0, 85.0, 95.0, 150.0, 200.0, 300.0}) {
+				for (double frequency : {3e6, 4e6, 5e6, 8e6}) {
+					for (double previousRefractiveIndex : {1.0, 0.9, 0.6}) {
+						Ray legacy;
+						legacy.o = Vector3d(0, 3490e3, 0);
+						legacy.d = Vector3d(sin(angle * Constants::PI / 180), cos(angle * Constants::PI / 180), 0);
+						legacy.frequency = frequency;
+						legacy.previousRefractiveIndex = previousRefractiveIndex;
+						legacy.signalPower = 1;
+						legacy.altitude = 100e3;
+						Ray fused = legacy;
+						Vector3d hitpos = Vector3d(10, 3490e3 + 10, 0);
+
+						Ionosphere sequence = *layer;
+						sequence.altitude = legacy.altitude;
+						sequence.setup();
+						int behaviour = sequence.determineWaveBehaviour(&legacy);
+						if (behaviour == Ray::wave_reflection) {
+							sequence.reflect(&legacy);
+						} else {
+							sequence.refract(&legacy);
+						}
+						legacy.o = hitpos;
+						sequence.attenuate(&legacy);
+						sequence.rangeDelay(&legacy);
+						sequence.phaseAdvance(&legacy);
+						sequence.timeDelay(&legacy);
+						sequence.exportData(&legacy);
+
+						Ionosphere(*layer).interact(&fused, hitpos);
+
+						ASSERT_EQ(legacy.behaviour, fused.behaviour);
+						ASSERT_NEAR(legacy.d.x, fused.d.x, 1e-12);
+						ASSERT_NEAR(legacy.d.y, fused.d.y, 1e-12);
+						ASSERT_NEAR(legacy.d.z, fused.d.z, 1e-12);
+						ASSERT_NEAR(legacy.previousRefractiveIndex, fused.previousRefractiveIndex, 1e-12);
+						ASSERT_NEAR(legacy.signalPower, fused.signalPower, 1e-12);
+						ASSERT_DOUBLE_EQ(legacy.rangeDelay, fused.rangeDelay);
+						ASSERT_DOUBLE_EQ(legacy.phaseAdvance, fused.phaseAdvance);
+						ASSERT_DOUBLE_EQ(legacy.timeDelay, fused.timeDelay);
+						ASSERT_EQ(hitpos.y, fused.o.y);
+
+						ASSERT_DOUBLE_EQ(Application::getInstance().dataSet.front().omega_p,
+								Application::getInstance().dataSet.back().omega_p);
+						Application::getInstance().dataSet.clear();
+					}
+				}
+			}
+		}
+	}
+
 	TEST_F(IonosphereTest, ExportDataTest) {
 
 		list<Data> dataSet;
@@ -1,11 +1,45 @@
 #include "gtest/gtest.h"
+#include <atomic>
+#include <random>
+#include <cstdlib>
+#include <new>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
 #include "../../src/scene/SceneManager.h"
 #include "../../src/scene/Ionosphere.h"
 #include "../../src/tracer/Ray.h"
 #include "../../src/math/Vector3d.h"
 #include "../../src/math/Line3d.h"
+#include "../../src/math/Matrix3d.h"
 #include "../../src/core/Config.h"
 #include "../../src/core/Application.h"
+#include "../../src/scene/Terrain.h"
+#include "../../src/core/SimulationContext.h"
+
+namespace {
+
+	/**
+	 * Number of heap allocations made through operator new since the start
+	 * of the test program
+	 */
+	std::atomic<long> allocationCount(0);
+}
+
+void* operator new(std::size_t size) {
+
+	allocationCount++;
+	void *p = malloc(size);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+
+	free(p);
+}
 
 namespace {
 
@@ -181,4 +215,148 @@ namespace {
 		ASSERT_NEAR(0, mesh2.centerpoint.z, 10);
 
 	}
+
+	TEST_F(SceneManagerTest, IntersectDoesNotAllocate) {
+
+		// a ring of terrain patches, similar to Application::createScene()
+		SceneManager scm2 = SceneManager();
+		std::vector<Terrain> patches;
+		patches.reserve(360);
+		for (int i = 0; i < 360; i++) {
+			double angle = i * Constants::PI / 180.0;
+			Vector3d normal = Vector3d(sin(angle), cos(angle), 0);
+			Plane3d mesh = Plane3d(normal, normal * 3390e3);
+			mesh.size = 3390e3 * Constants::PI / 180.0;
+			patches.push_back(Terrain(mesh));
+		}
+		for (Terrain &t : patches) {
+			scm2.addToScene(&t);
+		}
+
+		raytracer::tracer::Ray r = raytracer::tracer::Ray();
+		r.o = Vector3d(0, 3390e3 + 10e3, 0);
+		r.d = Vector3d(0, 1, 0);
+		Line3d rayLine = Line3d(r.o, Vector3d(0, 3390e3 + 11e3, 0));
+
+		// logging is allowed to allocate, tracing is not. The first call
+		// constructs the global logger, so measure the steady state.
+		boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+		scm2.intersect(r, rayLine);
+
+		long allocationsBefore = allocationCount;
+		Intersection is = scm2.intersect(r, rayLine);
+		long allocationsAfter = allocationCount;
+
+		boost::log::core::get()->reset_filter();
+
+		ASSERT_EQ(GeometryType::none, is.o);
+		ASSERT_EQ(allocationsBefore, allocationsAfter);
+	}
+
+	TEST_F(SceneManagerTest, LayerCrossingAndTerrainHitDoNotAllocate) {
+
+		Config celestialConf = Config("config/scenario_default.json");
+		SimulationContext context = SimulationContext(appConf, celestialConf, false);
+
+		SceneManager scm2 = SceneManager();
+		scm2.loadStaticEnvironment(context);
+		Terrain terrain = Terrain(Plane3d(Vector3d(0, 1, 0), Vector3d(0, 3390e3, 0)));
+		scm2.addToScene(&terrain);
+
+		raytracer::tracer::Ray layerRay = raytracer::tracer::Ray();
+		layerRay.o = Vector3d(0, 3390e3 + 100e3, 0);
+		layerRay.d = Vector3d(0.1, 1, 0).norm();
+		layerRay.updateAltitude(context.radius);
+		Line3d layerLine = Line3d(layerRay.o, layerRay.o + layerRay.d * 1e3);
+
+		raytracer::tracer::Ray terrainRay = raytracer::tracer::Ray();
+		terrainRay.o = Vector3d(0, 3390e3 + 10, 0);
+		terrainRay.d = Vector3d(0, -1, 0);
+		terrainRay.updateAltitude(context.radius);
+		Line3d terrainLine = Line3d(terrainRay.o, Vector3d(0, 3390e3 - 10, 0));
+
+		boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+		scm2.intersect(layerRay, layerLine);
+		scm2.intersect(terrainRay, terrainLine);
+
+		long allocationsBefore = allocationCount;
+		Intersection layerHit = scm2.intersect(layerRay, layerLine);
+		Intersection terrainHit = scm2.intersect(terrainRay, terrainLine);
+		long allocationsAfter = allocationCount;
+
+		boost::log::core::get()->reset_filter();
+
+		ASSERT_EQ(GeometryType::ionosphere, layerHit.o);
+		ASSERT_NEAR(100.5e3, layerHit.layer.centerpoint.magnitude() - 3390e3, 1);
+		ASSERT_EQ(layerHit.layer.normal.x, layerHit.normal.x);
+		ASSERT_EQ(layerHit.layer.normal.y, layerHit.normal.y);
+		ASSERT_GT(layerHit.layer.electronNumberDensity, 0);
+		ASSERT_EQ(2.5e11, layerHit.layer.peakElectronDensity);
+		ASSERT_EQ(GeometryType::terrain, terrainHit.o);
+		ASSERT_EQ(&terrain, terrainHit.g);
+		ASSERT_EQ(allocationsBefore, allocationsAfter);
+	}
+
+	TEST_F(SceneManagerTest, IndexedIntersectionMatchesScan) {
+
+		// terrain patches as created by Application::createScene()
+		double R = 3390e3;
+		double angularStepSize = 2 * Constants::PI / 180.0;
+		std::vector<Terrain> patches;
+		for (double latitude = 0; latitude <= 2 * Constants::PI; latitude += angularStepSize) {
+			for (double longitude = 0; longitude <= 2 * Constants::PI; longitude += angularStepSize) {
+				Matrix3d rotationMatrix = Matrix3d::createRotationMatrix(latitude, Matrix3d::ROTATION_X)
+						* Matrix3d::createRotationMatrix(longitude, Matrix3d::ROTATION_Z);
+				Vector3d position = rotationMatrix * Vector3d(0, R, 0);
+				Plane3d mesh = Plane3d(position.norm(), position);
+				mesh.size = angularStepSize * R;
+				patches.push_back(Terrain(mesh));
+			}
+		}
+
+		SceneManager scan = SceneManager();
+		SceneManager indexed = SceneManager();
+		for (Terrain &t : patches) {
+			scan.addToScene(&t);
+			indexed.addToScene(&t);
+		}
+		indexed.buildIndex();
+		ASSERT_TRUE(indexed.isIndexed());
+
+		boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<double> unit(-1, 1);
+		std::uniform_real_distribution<double> altitude(-2e3, 20e3);
+		int numHits = 0;
+		long allocations = 0;
+		for (int i = 0; i < 2000; i++) {
+			raytracer::tracer::Ray r = raytracer::tracer::Ray();
+			r.o = Vector3d(unit(generator), unit(generator), unit(generator)).norm() * (R + altitude(generator));
+			r.d = Vector3d(unit(generator), unit(generator), unit(generator)).norm();
+			Line3d rayLine = Line3d(r.o, r.o + r.d * 1e3);
+
+			Intersection expected = scan.intersect(r, rayLine);
+			long allocationsBefore = allocationCount;
+			Intersection actual = indexed.intersect(r, rayLine);
+			allocations += allocationCount - allocationsBefore;
+
+			ASSERT_EQ(expected.o, actual.o);
+			ASSERT_EQ(expected.g, actual.g);
+			ASSERT_EQ(expected.pos.x, actual.pos.x);
+			ASSERT_EQ(expected.pos.y, actual.pos.y);
+			ASSERT_EQ(expected.pos.z, actual.pos.z);
+			if (actual.o == GeometryType::terrain) {
+				numHits++;
+			}
+		}
+
+		boost::log::core::get()->reset_filter();
+
+		ASSERT_GT(numHits, 20);
+		ASSERT_EQ(0, allocations);
+
+		indexed.addToScene(&patches[0]);
+		ASSERT_FALSE(indexed.isIndexed());
+	}
 }
@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <vector>
+#include <boost/thread.hpp>
+#include "../../src/threading/Scheduler.h"
+
+namespace {
+
+	using namespace ::raytracer::threading;
+
+	class SchedulerTest : public ::testing::Test {};
+
+	TEST_F(SchedulerTest, RunsEveryIndexOnce) {
+
+		Scheduler scheduler(4);
+		std::vector<std::atomic<int> > counts(10007);
+		for (std::atomic<int> &count : counts) {
+			count.store(0);
+		}
+
+		scheduler.run(counts.size(), [&counts](size_t i) {
+			counts[i]++;
+		});
+
+		for (size_t i = 0; i < counts.size(); i++) {
+			ASSERT_EQ(1, counts[i].load()) << "index " << i;
+		}
+	}
+
+	TEST_F(SchedulerTest, ConsecutiveRuns) {
+
+		Scheduler scheduler(3);
+		for (size_t numItems = 0; numItems < 200; numItems++) {
+			std::atomic<size_t> sum(0);
+			scheduler.run(numItems, [&sum](size_t i) {
+				sum += i + 1;
+			});
+			ASSERT_EQ(numItems * (numItems + 1) / 2, sum.load());
+		}
+	}
+
+	TEST_F(SchedulerTest, StealsFromSlowThread) {
+
+		Scheduler scheduler(4);
+		std::atomic<int> numDone(0);
+
+		// the first quarter of the range is given to one thread, and is
+		// much slower than the rest
+		scheduler.run(400, [&numDone](size_t i) {
+			if (i < 100) {
+				boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+			}
+			numDone++;
+		});
+
+		ASSERT_EQ(400, numDone.load());
+		ASSERT_GT(scheduler.getNumSteals(), 0u);
+	}
+
+	TEST_F(SchedulerTest, CancelSkipsRemainingIndices) {
+
+		Scheduler scheduler(4);
+		std::atomic<int> numDone(0);
+
+		scheduler.run(100000, [&scheduler, &numDone](size_t i) {
+			if (++numDone == 10) {
+				scheduler.cancel();
+			}
+		});
+		ASSERT_TRUE(scheduler.isCancelled());
+		ASSERT_LT(numDone.load(), 100000);
+
+		// later runs return right away
+		int numDoneBefore = numDone.load();
+		scheduler.run(1000, [&numDone](size_t i) {
+			numDone++;
+		});
+		ASSERT_EQ(numDoneBefore, numDone.load());
+	}
+
+	TEST_F(SchedulerTest, ChunkSize) {
+
+		Scheduler scheduler(4);
+		ASSERT_EQ(4, scheduler.getNumThreads());
+		ASSERT_EQ(1u, scheduler.getChunkSize(10));
+		ASSERT_EQ(2u, scheduler.getChunkSize(128));
+		ASSERT_EQ(Scheduler::MAX_CHUNK_SIZE, scheduler.getChunkSize(1000000));
+	}
+}
@@ -0,0 +1,188 @@
+#include "gtest/gtest.h"
+#include <cmath>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include "../../src/tracer/HaselgroveTracer.h"
+#include "../../src/tracer/Tracer.h"
+#include "../../src/tracer/Ray.h"
+#include "../../src/core/Application.h"
+#include "../../src/core/Config.h"
+#include "../../src/scene/Ionosphere.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace ::raytracer::tracer;
+	using namespace ::raytracer::math;
+	using namespace ::raytracer::core;
+	using namespace ::raytracer::scene;
+
+	class HaselgroveTracerTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+				conf = Config("config/scenario_default.json");
+				appConf = Config("config/config.json");
+				Application::getInstance().setCelestialConfig(conf);
+				Application::getInstance().setApplicationConfig(appConf);
+
+				context = Application::getInstance().getSimulationContext();
+				context.terrain = SimulationContext::terrain_sphere;
+
+				// the layered tracer is compared with skipping enabled, whatever
+				// the shipped config says
+				context.skipEmptySpace = true;
+			}
+
+			void TearDown() {
+
+				boost::log::core::get()->reset_filter();
+				Application::getInstance().dataSet.clear();
+			}
+
+			Ray createRay(double elevation, double frequency) {
+
+				Ray r;
+				r.o = Vector3d(0, 3390e3 + 2, 0);
+				r.d = Vector3d(cos(elevation * Constants::PI / 180), sin(elevation * Constants::PI / 180), 0);
+				r.frequency = frequency;
+				return r;
+			}
+
+			Config conf, appConf;
+			SimulationContext context;
+	};
+
+	TEST_F(HaselgroveTracerTest, VerticalReflectionHeight) {
+
+		// a vertical ray at the subsolar point reflects where w_p = w
+		double frequency = 3e6;
+		double criticalDensity = pow(2 * Constants::PI * frequency, 2) * Constants::ELECTRON_MASS
+				* Constants::PERMITTIVITY_VACUUM / pow(Constants::ELEMENTARY_CHARGE, 2);
+		double low = context.ionosphereStart, high = 125e3;
+		while (high - low > 1e-3) {
+			double altitude = 0.5 * (low + high);
+			if (Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, altitude, 0) < criticalDensity) {
+				low = altitude;
+			} else {
+				high = altitude;
+			}
+		}
+
+		Ray r = createRay(90, frequency);
+		r.d = Vector3d(0, 1, 0);
+		HaselgroveTracer tracer(r, context);
+		double maxAltitude = 0;
+		while (tracer.step() == Tracer::state_tracing) {
+			maxAltitude = std::max(maxAltitude, r.o.y - context.radius);
+		}
+
+		ASSERT_EQ(Tracer::state_terrain, tracer.getState());
+		// the highest step ends just below the reflection height
+		ASSERT_LT(maxAltitude, low + 0.1);
+		ASSERT_GT(maxAltitude, low - 5.0);
+		ASSERT_NEAR(0, r.o.x, 1e-3);
+		ASSERT_NEAR(context.radius, r.o.y, 1e-3);
+	}
+
+	TEST_F(HaselgroveTracerTest, ConvergesToLayeredTracer) {
+
+		// the layered tracer converges to the same landing point for small steps
+		SimulationContext layeredContext = context;
+		layeredContext.ionosphereStep = 20;
+		SceneManager scm;
+		scm.loadStaticEnvironment(layeredContext);
+		Ray layered = createRay(45, 4.5e6);
+		ASSERT_EQ(Tracer::state_terrain, Tracer(layered, layeredContext, scm).run());
+
+		Ray r = createRay(45, 4.5e6);
+		ASSERT_EQ(Tracer::state_terrain, HaselgroveTracer(r, context).run());
+
+		ASSERT_NEAR(layered.o.x, r.o.x, 100);
+		ASSERT_NEAR(context.radius, r.o.magnitude(), 1e-3);
+		ASSERT_LT(10 * r.tracings, layered.tracings);
+	}
+
+	TEST_F(HaselgroveTracerTest, ToleranceControlsAccuracy) {
+
+		context.haselgroveTolerance = 1e-11;
+		Ray reference = createRay(30, 4e6);
+		HaselgroveTracer(reference, context).run();
+
+		int previousTracings = reference.tracings;
+		for (double tolerance : {1e-10, 1e-8, 1e-6}) {
+			context.haselgroveTolerance = tolerance;
+			Ray r = createRay(30, 4e6);
+			ASSERT_EQ(Tracer::state_terrain, HaselgroveTracer(r, context).run());
+
+			double error = r.o.distance(reference.o);
+			ASSERT_LT(error, 1.0);
+			ASSERT_LE(r.tracings, previousTracings);
+			previousTracings = r.tracings;
+		}
+	}
+
+	TEST_F(HaselgroveTracerTest, HighFrequencyLeavesScene) {
+
+		Ray r = createRay(60, 50e6);
+		HaselgroveTracer tracer(r, context);
+
+		ASSERT_EQ(Tracer::state_out_of_bounds, tracer.run());
+		ASSERT_NEAR(r.d.x, cos(60 * Constants::PI / 180), 1e-3);
+		ASSERT_LT(r.signalPower, 0);
+	}
+
+	TEST_F(HaselgroveTracerTest, LinearLayersConverge) {
+
+		context.haselgroveTolerance = 1e-11;
+		Ray reference = createRay(45, 4.5e6);
+		HaselgroveTracer(reference, context).run();
+
+		context.engine = SimulationContext::engine_linear_layers;
+		Ray r = createRay(45, 4.5e6);
+		ASSERT_EQ(Tracer::state_terrain, HaselgroveTracer(r, context).run());
+
+		ASSERT_NEAR(reference.o.x, r.o.x, 20);
+		ASSERT_NEAR(reference.timeOfFlight, r.timeOfFlight, 1e-7);
+	}
+
+	TEST_F(HaselgroveTracerTest, LinearLayersAreThicker) {
+
+		// linear layers of five times the thickness are more accurate than
+		// homogeneous layers, in fewer steps
+		SceneManager scm;
+		scm.loadStaticEnvironment(context);
+		SimulationContext linearContext = context;
+		linearContext.engine = SimulationContext::engine_linear_layers;
+		linearContext.ionosphereStep = 5 * context.ionosphereStep;
+		context.haselgroveTolerance = 1e-11;
+
+		for (double elevation : {30, 45, 70}) {
+			Ray reference = createRay(elevation, 4.5e6);
+			HaselgroveTracer(reference, context).run();
+			Ray layered = createRay(elevation, 4.5e6);
+			Tracer(layered, context, scm).run();
+			Ray linear = createRay(elevation, 4.5e6);
+			ASSERT_EQ(Tracer::state_terrain, HaselgroveTracer(linear, linearContext).run());
+
+			ASSERT_LT(std::abs(linear.o.x - reference.o.x), std::abs(layered.o.x - reference.o.x));
+			ASSERT_LT(linear.tracings, layered.tracings);
+		}
+	}
+
+	TEST_F(HaselgroveTracerTest, LinearLayersVerticalReflection) {
+
+		context.engine = SimulationContext::engine_linear_layers;
+		context.ionosphereStep = 5000;
+		Ray r = createRay(90, 3e6);
+		r.d = Vector3d(0, 1, 0);
+
+		ASSERT_EQ(Tracer::state_terrain, HaselgroveTracer(r, context).run());
+		ASSERT_NEAR(0, r.o.x, 1e-3);
+		ASSERT_NEAR(context.radius, r.o.y, 1e-3);
+	}
+}
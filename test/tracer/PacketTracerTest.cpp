@@ -0,0 +1,120 @@
+#include "gtest/gtest.h"
+#include <cmath>
+#include <vector>
+#include "../../src/tracer/PacketTracer.h"
+#include "../../src/tracer/Tracer.h"
+#include "../../src/tracer/Ray.h"
+#include "../../src/core/Application.h"
+#include "../../src/core/Config.h"
+#include "../../src/scene/IonosphereTable.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace ::raytracer::tracer;
+	using namespace ::raytracer::math;
+	using namespace ::raytracer::core;
+	using namespace ::raytracer::scene;
+
+	class PacketTracerTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				conf = Config("config/scenario_default.json");
+				appConf = Config("config/config.json");
+				Application::getInstance().setCelestialConfig(conf);
+				Application::getInstance().setApplicationConfig(appConf);
+
+				context = Application::getInstance().getSimulationContext();
+				context.terrain = SimulationContext::terrain_sphere;
+				context.useIonosphereTable = true;
+				table.build(context, 1e-3);
+			}
+
+			/**
+			 * A fan of rays from the surface, as launched by Application::run()
+			 */
+			std::vector<Ray> createRays(int numRays) {
+
+				std::vector<Ray> rays;
+				for (int i = 0; i < numRays; i++) {
+					double elevation = (15 + 60.0 * i / numRays) * Constants::PI / 180;
+					Ray r;
+					r.rayNumber = i + 1;
+					r.o = Vector3d(0, 3390e3 + 2, 0);
+					r.d = Vector3d(cos(elevation), sin(elevation), 0);
+					r.frequency = 4.5e6 + 1e5 * i;
+					rays.push_back(r);
+				}
+
+				return rays;
+			}
+
+			/**
+			 * Trace the rays with a PacketTracer and with a Tracer per ray
+			 */
+			void compareWithScalar(int numRays) {
+
+				std::vector<Ray> packet = createRays(numRays);
+				std::vector<Ray> scalar = createRays(numRays);
+
+				PacketTracer packetTracer(context, scm);
+				packetTracer.run(packet.data(), numRays);
+
+				for (int i = 0; i < numRays; i++) {
+					Tracer::traceState state = Tracer(scalar[i], context, scm).run();
+
+					ASSERT_EQ(state, packetTracer.getState(i));
+					ASSERT_EQ(scalar[i].tracings, packet[i].tracings);
+					ASSERT_EQ(scalar[i].o.x, packet[i].o.x);
+					ASSERT_EQ(scalar[i].o.y, packet[i].o.y);
+					ASSERT_EQ(scalar[i].d.x, packet[i].d.x);
+					ASSERT_EQ(scalar[i].d.y, packet[i].d.y);
+					ASSERT_EQ(scalar[i].signalPower, packet[i].signalPower);
+					ASSERT_EQ(scalar[i].timeOfFlight, packet[i].timeOfFlight);
+					ASSERT_EQ(scalar[i].rangeDelay, packet[i].rangeDelay);
+					ASSERT_EQ(scalar[i].previousRefractiveIndex, packet[i].previousRefractiveIndex);
+				}
+			}
+
+			SceneManager scm;
+			Config conf, appConf;
+			SimulationContext context;
+			IonosphereTable table;
+	};
+
+	TEST_F(PacketTracerTest, Vectorized) {
+
+		scm.loadStaticEnvironment(context, &table);
+		ASSERT_TRUE(PacketTracer(context, scm).isVectorized());
+
+		scm.loadStaticEnvironment(context);
+		ASSERT_FALSE(PacketTracer(context, scm).isVectorized());
+	}
+
+	TEST_F(PacketTracerTest, FullPacketMatchesScalarTracer) {
+
+		context.skipEmptySpace = false;
+		scm.loadStaticEnvironment(context, &table);
+
+		compareWithScalar(PacketTracer::PACKET_SIZE);
+	}
+
+	TEST_F(PacketTracerTest, PartialPacketMatchesScalarTracer) {
+
+		context.skipEmptySpace = false;
+		scm.loadStaticEnvironment(context, &table);
+
+		compareWithScalar(3);
+	}
+
+	TEST_F(PacketTracerTest, SkippingMatchesScalarTracer) {
+
+		context.skipEmptySpace = true;
+		context.skipPlasmaFrequencyRatio = 0.01;
+		scm.loadStaticEnvironment(context, &table);
+
+		compareWithScalar(PacketTracer::PACKET_SIZE);
+	}
+}
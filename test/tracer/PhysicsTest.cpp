@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+#include "../../src/tracer/Physics.h"
+#include "../../src/core/SimulationContext.h"
+
+namespace {
+
+	using namespace ::raytracer::tracer;
+	using namespace ::raytracer::core;
+
+	/**
+	 * Selects the options of the Physics, as a bit mask
+	 */
+	struct OptionSelector {
+		typedef int result_type;
+		template <class P> static int select() {
+			return (P::magneticField ? 4 : 0) + (P::skipEmptySpace ? 2 : 0) + (P::sphereTerrain ? 1 : 0);
+		}
+	};
+
+	class PhysicsTest : public ::testing::Test {};
+
+	TEST_F(PhysicsTest, SelectsOptionsOfContext) {
+
+		SimulationContext context;
+		ASSERT_EQ(0, selectPhysics<OptionSelector>(context));
+
+		context.terrain = SimulationContext::terrain_sphere;
+		ASSERT_EQ(1, selectPhysics<OptionSelector>(context));
+
+		context.skipEmptySpace = true;
+		ASSERT_EQ(3, selectPhysics<OptionSelector>(context));
+
+		MagneticFieldParameters field;
+		field.strength = 0;
+		context.magneticFields.push_back(field);
+		ASSERT_EQ(3, selectPhysics<OptionSelector>(context));
+
+		context.magneticFields[0].strength = 5e-8;
+		context.terrain = SimulationContext::terrain_patches;
+		ASSERT_EQ(6, selectPhysics<OptionSelector>(context));
+	}
+}
@@ -0,0 +1,164 @@
+#include "gtest/gtest.h"
+#include <cmath>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include "../../src/tracer/QuasiParabolicTracer.h"
+#include "../../src/tracer/HaselgroveTracer.h"
+#include "../../src/tracer/Tracer.h"
+#include "../../src/tracer/Ray.h"
+#include "../../src/core/Application.h"
+#include "../../src/core/Config.h"
+#include "../../src/scene/Ionosphere.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace ::raytracer::tracer;
+	using namespace ::raytracer::math;
+	using namespace ::raytracer::core;
+	using namespace ::raytracer::scene;
+
+	class QuasiParabolicTracerTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+				conf = Config("config/scenario_default.json");
+				appConf = Config("config/config.json");
+				Application::getInstance().setCelestialConfig(conf);
+				Application::getInstance().setApplicationConfig(appConf);
+
+				context = Application::getInstance().getSimulationContext();
+				context.terrain = SimulationContext::terrain_sphere;
+			}
+
+			void TearDown() {
+
+				boost::log::core::get()->reset_filter();
+				Application::getInstance().dataSet.clear();
+			}
+
+			/**
+			 * Midpoint rule for the ground angle and group path between the
+			 * distance bottom and the apogee of the fitted profile, with
+			 * r = apogee - s^2 to remove the singularity at the apogee
+			 */
+			void integrate(const QuasiParabolicTracer &tracer, double K, double frequency,
+					double bottom, double apogee, double &angle, double &groupPath) {
+
+				double plasmaFrequencyFactor = pow(Constants::ELEMENTARY_CHARGE, 2) / (Constants::ELECTRON_MASS
+						* Constants::PERMITTIVITY_VACUUM * pow(2 * Constants::PI * frequency, 2));
+				int steps = 200000;
+				double ds = sqrt(apogee - bottom) / steps;
+				for (int i = 0; i < steps; i++) {
+					double s = (i + 0.5) * ds;
+					double r = apogee - s * s;
+					double n2 = 1 - plasmaFrequencyFactor * tracer.getElectronNumberDensity(r - context.radius);
+					double root = sqrt(n2 * r * r - K * K);
+					angle += 2 * s * K / (r * root) * ds;
+					groupPath += 2 * s * r / root * ds;
+				}
+			}
+
+			Config conf, appConf;
+			SimulationContext context;
+	};
+
+	TEST_F(QuasiParabolicTracerTest, FitWithinMaxError) {
+
+		QuasiParabolicTracer tracer(context, 0.3, 2);
+
+		ASSERT_LE(tracer.getMaxError(), context.quasiParabolicMaxError);
+		ASSERT_NEAR(context.radius + context.ionosphereStart, tracer.getSegments().front().bottom, 1e-6);
+		ASSERT_NEAR(context.radius + context.ionosphereEnd, tracer.getSegments().back().top, 1e-6);
+
+		for (double altitude = context.ionosphereStart; altitude <= context.ionosphereEnd; altitude += 1234) {
+			double exact = Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, altitude, 0.3);
+			ASSERT_NEAR(exact, tracer.getElectronNumberDensity(altitude), 2 * context.quasiParabolicMaxError * 2.5e11);
+		}
+	}
+
+	TEST_F(QuasiParabolicTracerTest, MatchesNumericalIntegration) {
+
+		QuasiParabolicTracer tracer(context, 0, 2);
+
+		for (double zenithAngle : {10, 40, 70}) {
+			for (double frequency : {3e6, 4.2e6}) {
+				QuasiParabolicTracer::Path path = tracer.trace(zenithAngle * Constants::PI / 180, frequency);
+				ASSERT_TRUE(path.reflected);
+
+				double apogee = context.radius + path.apogee;
+				double K = (context.radius + 2) * sin(zenithAngle * Constants::PI / 180);
+				double angle = 0, groupPath = 0;
+				integrate(tracer, K, frequency, context.radius + 2, apogee, angle, groupPath);
+				ASSERT_NEAR(context.radius * angle, path.apogeeRange, 1.0);
+				ASSERT_NEAR(groupPath, path.apogeeGroupPath, 1.0);
+
+				integrate(tracer, K, frequency, context.radius, apogee, angle, groupPath);
+				ASSERT_NEAR(context.radius * angle, path.groundRange, 1.0);
+				ASSERT_NEAR(groupPath / Constants::C, path.timeOfFlight, 1e-8);
+			}
+		}
+	}
+
+	TEST_F(QuasiParabolicTracerTest, VerticalReflectionHeight) {
+
+		double frequency = 3e6;
+		double criticalDensity = pow(2 * Constants::PI * frequency, 2) * Constants::ELECTRON_MASS
+				* Constants::PERMITTIVITY_VACUUM / pow(Constants::ELEMENTARY_CHARGE, 2);
+		double low = context.ionosphereStart, high = 125e3;
+		while (high - low > 1e-3) {
+			double altitude = 0.5 * (low + high);
+			if (Ionosphere::getChapmanElectronNumberDensity(2.5e11, 125e3, 11.1e3, altitude, 0) < criticalDensity) {
+				low = altitude;
+			} else {
+				high = altitude;
+			}
+		}
+
+		QuasiParabolicTracer::Path path = QuasiParabolicTracer(context, 0, 2).trace(0, frequency);
+
+		ASSERT_TRUE(path.reflected);
+		ASSERT_NEAR(low, path.apogee, 10);
+		ASSERT_EQ(0, path.groundRange);
+		ASSERT_GT(path.groupPath, 2 * path.apogee);
+	}
+
+	TEST_F(QuasiParabolicTracerTest, AgreesWithHaselgroveTracer) {
+
+		// the SZA only changes slightly along steep paths from the subsolar point
+		QuasiParabolicTracer tracer(context, 0, 2);
+		context.haselgroveTolerance = 1e-11;
+
+		for (double zenithAngle : {15, 30, 45}) {
+			Ray r;
+			r.o = Vector3d(0, 3390e3 + 2, 0);
+			r.d = Vector3d(sin(zenithAngle * Constants::PI / 180), cos(zenithAngle * Constants::PI / 180), 0);
+			r.frequency = 4.5e6;
+			ASSERT_EQ(Tracer::state_terrain, HaselgroveTracer(r, context).run());
+
+			QuasiParabolicTracer::Path path = tracer.trace(zenithAngle * Constants::PI / 180, 4.5e6);
+			ASSERT_TRUE(path.reflected);
+			double range = context.radius * atan2(r.o.x, r.o.y);
+			ASSERT_NEAR(range, path.groundRange, 1e-3 * range);
+			ASSERT_NEAR(r.timeOfFlight, path.timeOfFlight, 1e-3 * r.timeOfFlight);
+		}
+	}
+
+	TEST_F(QuasiParabolicTracerTest, HighFrequencyTravelsStraight) {
+
+		double zenithAngle = 30 * Constants::PI / 180;
+		QuasiParabolicTracer::Path path = QuasiParabolicTracer(context, 0, 2).trace(zenithAngle, 1e10);
+
+		double launchRadius = context.radius + 2;
+		double K = launchRadius * sin(zenithAngle);
+		double length = sqrt(pow(context.sceneBoundary, 2) - K * K) - launchRadius * cos(zenithAngle);
+		ASSERT_FALSE(path.reflected);
+		ASSERT_NEAR(length, path.groupPath, 1e-2);
+		ASSERT_NEAR(context.radius * (zenithAngle - asin(K / context.sceneBoundary)), path.groundRange, 1e-2);
+		ASSERT_NEAR(asin(K / context.sceneBoundary), path.arrivalAngle, 1e-12);
+	}
+}
@@ -0,0 +1,173 @@
+#include "gtest/gtest.h"
+#include <cmath>
+#include "../../src/tracer/Tracer.h"
+#include "../../src/tracer/Ray.h"
+#include "../../src/core/Application.h"
+#include "../../src/core/Config.h"
+#include "../../src/scene/IonosphereTable.h"
+#include "../../src/math/Constants.h"
+
+namespace {
+
+	using namespace ::raytracer::tracer;
+	using namespace ::raytracer::math;
+	using namespace ::raytracer::core;
+	using namespace ::raytracer::scene;
+
+	class TracerTest : public ::testing::Test {
+
+		protected:
+			void SetUp() {
+
+				conf = Config("config/scenario_default.json");
+				appConf = Config("config/config.json");
+				Application::getInstance().setCelestialConfig(conf);
+				Application::getInstance().setApplicationConfig(appConf);
+
+				r.o = Vector3d(0, 3390e3 + 10e3, 0);
+				r.d = Vector3d(0, 1, 0);
+				r.frequency = 4.5e6;
+			}
+
+			Ray r;
+			SceneManager scm;
+			Config conf, appConf;
+	};
+
+	TEST_F(TracerTest, InitialState) {
+
+		Tracer tracer(r, Application::getInstance().getSimulationContext(), scm);
+
+		ASSERT_EQ(Tracer::state_tracing, tracer.getState());
+		ASSERT_FALSE(tracer.isTerminated());
+	}
+
+	TEST_F(TracerTest, NaN) {
+
+		r.o.x = NAN;
+		Tracer tracer(r, Application::getInstance().getSimulationContext(), scm);
+
+		ASSERT_EQ(Tracer::state_nan, tracer.step());
+		ASSERT_TRUE(tracer.isTerminated());
+		ASSERT_EQ(0, r.tracings);
+	}
+
+	TEST_F(TracerTest, OutOfBounds) {
+
+		r.o = Vector3d(0, 3390e3 + 300e3, 0);
+		Tracer tracer(r, Application::getInstance().getSimulationContext(), scm);
+
+		ASSERT_EQ(Tracer::state_out_of_bounds, tracer.run());
+		ASSERT_EQ(0, r.tracings);
+	}
+
+	TEST_F(TracerTest, TracingLimit) {
+
+		r.tracings = appConf.getInt("tracingLimit");
+		Tracer tracer(r, Application::getInstance().getSimulationContext(), scm);
+
+		ASSERT_EQ(Tracer::state_tracing_limit, tracer.run());
+	}
+
+	TEST_F(TracerTest, TerminatedTracerDoesNotStep) {
+
+		r.o.x = NAN;
+		Tracer tracer(r, Application::getInstance().getSimulationContext(), scm);
+		tracer.run();
+		r.o = Vector3d(0, 3390e3 + 300e3, 0);
+
+		ASSERT_EQ(Tracer::state_nan, tracer.step());
+	}
+
+	TEST_F(TracerTest, SphericalTerrain) {
+
+		SimulationContext context = Application::getInstance().getSimulationContext();
+		context.terrain = SimulationContext::terrain_sphere;
+		context.skipEmptySpace = false;
+		scm.loadStaticEnvironment(context);
+
+		r.o = Vector3d(0, 3390e3 + 2.5e3, 0);
+		r.d = Vector3d(0.5, -1, 0).norm();
+		Tracer tracer(r, context, scm);
+
+		ASSERT_EQ(Tracer::state_terrain, tracer.run());
+		ASSERT_EQ(3, r.tracings);
+		ASSERT_NEAR(3390e3, r.o.magnitude(), 1e-6);
+		ASSERT_EQ(GeometryType::terrain, r.lastHitType);
+	}
+
+	TEST_F(TracerTest, SkipToIonosphere) {
+
+		SimulationContext context = Application::getInstance().getSimulationContext();
+		context.skipEmptySpace = true;
+		scm.loadStaticEnvironment(context);
+
+		r.d = Vector3d(0.2, 1, 0).norm();
+		Tracer tracer(r, context, scm);
+
+		ASSERT_EQ(Tracer::state_tracing, tracer.step());
+		ASSERT_EQ(1, r.tracings);
+		ASSERT_NEAR(context.ionosphereStart - context.ionosphereStep, r.o.magnitude() - context.radius, 1e-2);
+
+		// the next step crosses the first layer
+		tracer.step();
+		ASSERT_EQ(GeometryType::ionosphere, r.lastHitType);
+		ASSERT_NEAR(context.ionosphereStart, r.o.magnitude() - context.radius, 0.1);
+	}
+
+	TEST_F(TracerTest, SkipNegligibleLayers) {
+
+		SimulationContext context = Application::getInstance().getSimulationContext();
+		context.skipEmptySpace = true;
+		context.skipPlasmaFrequencyRatio = 0.01;
+		IonosphereTable table;
+		table.build(context, 1e-3);
+		scm.loadStaticEnvironment(context, &table);
+
+		r.o = Vector3d(0, 3390e3 + 70e3, 0);
+		r.d = Vector3d(0.2, 1, 0).norm();
+		Tracer tracer(r, context, scm);
+		tracer.step();
+
+		// the ray lands on the last layer where the plasma frequency is negligible
+		double altitude = r.o.magnitude() - context.radius;
+		double SZA = r.o.norm().angle(Vector3d::SUBSOLAR);
+		double nextSZA = (r.o + r.d * context.ionosphereStep).norm().angle(Vector3d::SUBSOLAR);
+		double angularFrequency = 2 * Constants::PI * r.frequency;
+
+		ASSERT_GT(altitude, 70e3 + context.ionosphereStep);
+		ASSERT_LT(table.getPlasmaFrequency(altitude, SZA), 0.01 * angularFrequency);
+		ASSERT_GT(table.getPlasmaFrequency(altitude + context.ionosphereStep, nextSZA), 0.01 * angularFrequency);
+		ASSERT_EQ(1, r.tracings);
+	}
+
+	TEST_F(TracerTest, SkippingPreservesOutcome) {
+
+		SimulationContext context = Application::getInstance().getSimulationContext();
+		context.terrain = SimulationContext::terrain_sphere;
+		IonosphereTable table;
+		table.build(context, 1e-3);
+
+		double elevations[] = {20, 45, 70};
+		for (double elevation : elevations) {
+
+			Ray stepped, skipped;
+			stepped.o = skipped.o = Vector3d(0, 3390e3 + 2, 0);
+			stepped.d = skipped.d = Vector3d(cos(elevation * Constants::PI / 180), sin(elevation * Constants::PI / 180), 0);
+			stepped.frequency = skipped.frequency = 4.5e6;
+
+			context.skipEmptySpace = false;
+			scm.loadStaticEnvironment(context, &table);
+			Tracer::traceState steppedState = Tracer(stepped, context, scm).run();
+
+			context.skipEmptySpace = true;
+			context.skipPlasmaFrequencyRatio = 0.01;
+			scm.loadStaticEnvironment(context, &table);
+			Tracer::traceState skippedState = Tracer(skipped, context, scm).run();
+
+			ASSERT_EQ(steppedState, skippedState);
+			ASSERT_LT(skipped.tracings, stepped.tracings / 2);
+			ASSERT_NEAR(0, stepped.o.angle(skipped.o), 0.002);
+		}
+	}
+}